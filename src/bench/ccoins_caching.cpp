@@ -5,6 +5,7 @@
 #include <bench/bench.h>
 #include <coins.h>
 #include <policy/policy.h>
+#include <random.h>
 #include <wallet/crypter.h>
 
 #include <vector>
@@ -85,3 +86,66 @@ static void CCoinsCaching(benchmark::State& state)
 }
 
 BENCHMARK(CCoinsCaching, 170 * 1000);
+
+// Simulate a stream of blocks connecting on top of a UTXO cache that is much
+// smaller than the UTXO set. Every block reads a few coins from a small hot
+// set and replaces some coins of a large cold set. Whenever the cache grows
+// over its budget it is either emptied (Flush) or written out and trimmed to
+// half of its budget (Trim). The base cache stands in for the chainstate
+// database, so misses are far cheaper here than on a real node; the
+// difference between the two benchmarks is a lower bound.
+static void CoinsCacheChurn(benchmark::State& state, bool fTrim)
+{
+    static const size_t HOT_COINS = 2000;
+    static const size_t COLD_COINS = 50000;
+    static const size_t CACHE_LIMIT = 2 << 20;
+
+    FastRandomContext rng(true);
+    CCoinsView coinsDummy;
+    CCoinsViewCache coinsDB(&coinsDummy);
+    CCoinsViewCache coinsTip(&coinsDB);
+
+    auto newCoin = [&rng]() {
+        Coin coin;
+        coin.out.nValue = 1 + rng.randrange(50 * COIN);
+        coin.out.scriptPubKey = CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(20, 0) << OP_EQUALVERIFY << OP_CHECKSIG;
+        return coin;
+    };
+    std::vector<COutPoint> outpoints;
+    for (size_t i = 0; i < HOT_COINS + COLD_COINS; i++) {
+        outpoints.emplace_back(rng.rand256(), 0);
+        coinsDB.AddCoin(outpoints.back(), newCoin(), false);
+    }
+
+    while (state.KeepRunning()) {
+        CCoinsViewCache view(&coinsTip);
+        for (int i = 0; i < 200; i++) {
+            assert(!view.AccessCoin(outpoints[rng.randrange(HOT_COINS)]).IsSpent());
+        }
+        for (int i = 0; i < 100; i++) {
+            COutPoint& outpoint = outpoints[HOT_COINS + rng.randrange(COLD_COINS)];
+            bool spent = view.SpendCoin(outpoint);
+            assert(spent);
+            outpoint = COutPoint(rng.rand256(), 0);
+            view.AddCoin(outpoint, newCoin(), false);
+        }
+        view.Flush();
+        if (coinsTip.DynamicMemoryUsage() > CACHE_LIMIT) {
+            bool ok = fTrim ? coinsTip.Trim(CACHE_LIMIT / 2) : coinsTip.Flush();
+            assert(ok);
+        }
+    }
+}
+
+static void CCoinsCachingFlush(benchmark::State& state)
+{
+    CoinsCacheChurn(state, false);
+}
+
+static void CCoinsCachingTrim(benchmark::State& state)
+{
+    CoinsCacheChurn(state, true);
+}
+
+BENCHMARK(CCoinsCachingFlush, 2000);
+BENCHMARK(CCoinsCachingTrim, 2000);
@@ -112,3 +112,75 @@ static void MempoolEviction(benchmark::State& state)
 }
 
 BENCHMARK(MempoolEviction, 41000);
+
+static const size_t DEEP_CHAIN_LENGTH = 200;
+static const size_t WIDE_FANOUT_WIDTH = 2000;
+
+// A chain of transactions each spending the single output of the previous
+// one. Adding it walks all ancestors of every entry, and removing it walks all
+// descendants of the first.
+static void MempoolDeepChain(benchmark::State& state)
+{
+    std::vector<CTransactionRef> chain;
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].scriptSig = CScript() << OP_1;
+    tx.vout.resize(1);
+    tx.vout[0].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+    tx.vout[0].nValue = 10 * COIN;
+    for (size_t i = 0; i < DEEP_CHAIN_LENGTH; i++) {
+        chain.push_back(MakeTransactionRef(tx));
+        tx.vin[0].prevout = COutPoint(chain.back()->GetHash(), 0);
+    }
+
+    CTxMemPool pool;
+
+    while (state.KeepRunning()) {
+        for (const CTransactionRef& ptx : chain) {
+            AddTx(*ptx, 1000LL, pool);
+        }
+        pool.removeRecursive(*chain.front());
+    }
+}
+
+// One transaction with many children, re-added to the mempool after its
+// children as happens when a block is disconnected in a reorg.
+static void MempoolWideFanout(benchmark::State& state)
+{
+    CMutableTransaction parent;
+    parent.vin.resize(1);
+    parent.vin[0].scriptSig = CScript() << OP_1;
+    parent.vout.resize(WIDE_FANOUT_WIDTH);
+    for (size_t i = 0; i < WIDE_FANOUT_WIDTH; i++) {
+        parent.vout[i].scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        parent.vout[i].nValue = COIN;
+    }
+    const CTransaction parent_tx(parent);
+
+    std::vector<CTransactionRef> children;
+    for (size_t i = 0; i < WIDE_FANOUT_WIDTH; i++) {
+        CMutableTransaction child;
+        child.vin.resize(1);
+        child.vin[0].prevout = COutPoint(parent_tx.GetHash(), i);
+        child.vin[0].scriptSig = CScript() << OP_2;
+        child.vout.resize(1);
+        child.vout[0].scriptPubKey = CScript() << OP_2 << OP_EQUAL;
+        child.vout[0].nValue = COIN;
+        children.push_back(MakeTransactionRef(child));
+    }
+    const std::vector<uint256> vHashesToUpdate(1, parent_tx.GetHash());
+
+    CTxMemPool pool;
+
+    while (state.KeepRunning()) {
+        for (const CTransactionRef& ptx : children) {
+            AddTx(*ptx, 1000LL, pool);
+        }
+        AddTx(parent_tx, 1000LL, pool);
+        pool.UpdateTransactionsFromBlock(vHashesToUpdate);
+        pool.removeRecursive(parent_tx);
+    }
+}
+
+BENCHMARK(MempoolDeepChain, 20);
+BENCHMARK(MempoolWideFanout, 40);
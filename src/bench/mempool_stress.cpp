@@ -0,0 +1,257 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <arith_uint256.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <miner.h>
+#include <policy/policy.h>
+#include <random.h>
+#include <txmempool.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Benchmarks of block template selection, size limiting and block removal on
+// large generated mempools. Transactions have 1-3 inputs and outputs, feerates
+// drawn log-uniformly from 1 to 1000 sat/vB, about 30% spend an unconfirmed
+// output (building CPFP chains within the ancestor limits), and about 5%
+// replace an earlier transaction with a higher fee one. The generator is
+// seeded deterministically, so every run measures the same mempool.
+
+namespace {
+
+class MempoolGenerator
+{
+    FastRandomContext rng;
+    //! Outputs of mempool transactions that have not been spent yet
+    std::vector<COutPoint> vUnconfirmed;
+    //! Transactions added so far, candidates for replacement
+    std::vector<CTransactionRef> vAdded;
+    uint32_t nConfirmed;
+
+    CScript RandomScriptPubKey()
+    {
+        uint256 hash = rng.rand256();
+        return CScript() << OP_DUP << OP_HASH160 << std::vector<unsigned char>(hash.begin(), hash.begin() + 20) << OP_EQUALVERIFY << OP_CHECKSIG;
+    }
+
+    /** An output of a made up confirmed transaction. */
+    COutPoint ConfirmedOutpoint()
+    {
+        return COutPoint(ArithToUint256(arith_uint256(++nConfirmed)), rng.randrange(4));
+    }
+
+    /** Pick an unspent output of a mempool transaction, or a null outpoint if there is none. */
+    COutPoint UnconfirmedOutpoint(CTxMemPool& pool)
+    {
+        while (!vUnconfirmed.empty()) {
+            size_t i = rng.randrange(vUnconfirmed.size());
+            COutPoint outpoint = vUnconfirmed[i];
+            vUnconfirmed[i] = vUnconfirmed.back();
+            vUnconfirmed.pop_back();
+            // Outputs of replaced or mined transactions are skipped.
+            if (pool.exists(outpoint.hash) && !pool.isSpent(outpoint)) return outpoint;
+        }
+        return COutPoint();
+    }
+
+    CAmount RandomFee(const CTransaction& tx)
+    {
+        const double feerate = std::exp(std::log(1000.0) * rng.randrange(1000000) / 1000000.0);
+        return (CAmount)(feerate * GetVirtualTransactionSize(tx)) + 1;
+    }
+
+    bool Add(CTxMemPool& pool, const CTransactionRef& tx, CAmount nFee)
+    {
+        LockPoints lp;
+        CTxMemPoolEntry entry(tx, nFee, GetTime(), 1, false, 4 * tx->vin.size(), lp);
+        CTxMemPool::setEntries setAncestors;
+        std::string dummy;
+        if (!pool.CalculateMemPoolAncestors(entry, setAncestors, DEFAULT_ANCESTOR_LIMIT, DEFAULT_ANCESTOR_SIZE_LIMIT * 1000,
+                                            DEFAULT_DESCENDANT_LIMIT, DEFAULT_DESCENDANT_SIZE_LIMIT * 1000, dummy)) {
+            return false;
+        }
+        pool.addUnchecked(tx->GetHash(), entry, setAncestors, false);
+        for (size_t i = 0; i < tx->vout.size(); i++) {
+            vUnconfirmed.emplace_back(tx->GetHash(), i);
+        }
+        vAdded.push_back(tx);
+        return true;
+    }
+
+    CMutableTransaction NewTransaction(size_t nInputs)
+    {
+        CMutableTransaction mtx;
+        mtx.vin.resize(nInputs);
+        for (CTxIn& txin : mtx.vin) {
+            // A signature and a compressed public key
+            txin.scriptSig = CScript() << std::vector<unsigned char>(72, 0x30) << std::vector<unsigned char>(33, 0x02);
+        }
+        mtx.vout.resize(1 + rng.randrange(3));
+        for (CTxOut& txout : mtx.vout) {
+            txout.scriptPubKey = RandomScriptPubKey();
+            txout.nValue = 1 + rng.randrange(COIN);
+        }
+        return mtx;
+    }
+
+    /** Remove a random earlier transaction and its descendants, and add a conflicting one paying more. */
+    void Replace(CTxMemPool& pool)
+    {
+        const CTransactionRef ptxOld = vAdded[rng.randrange(vAdded.size())];
+        CTxMemPool::txiter it = pool.mapTx.find(ptxOld->GetHash());
+        if (it == pool.mapTx.end()) return;
+        const CAmount nOldFee = it->GetModifiedFee();
+        CMutableTransaction mtx = NewTransaction(ptxOld->vin.size());
+        for (size_t i = 0; i < mtx.vin.size(); i++) {
+            mtx.vin[i].prevout = ptxOld->vin[i].prevout;
+        }
+        const CTransactionRef ptxNew = MakeTransactionRef(std::move(mtx));
+        pool.removeRecursive(*ptxOld, MemPoolRemovalReason::REPLACED);
+        Add(pool, ptxNew, std::max(RandomFee(*ptxNew), nOldFee + 1000));
+    }
+
+public:
+    MempoolGenerator() : rng(true), nConfirmed(0) {}
+
+    /** Add generated transactions to pool until it holds nTarget of them. */
+    void Fill(CTxMemPool& pool, size_t nTarget)
+    {
+        LOCK(pool.cs);
+        while (pool.size() < nTarget) {
+            if (!vAdded.empty() && rng.randrange(100) < 5) {
+                Replace(pool);
+                continue;
+            }
+            CMutableTransaction mtx = NewTransaction(1 + rng.randrange(3));
+            for (CTxIn& txin : mtx.vin) {
+                txin.prevout = ConfirmedOutpoint();
+            }
+            const bool fChild = rng.randrange(100) < 30;
+            if (fChild) {
+                const COutPoint parent = UnconfirmedOutpoint(pool);
+                if (!parent.IsNull()) mtx.vin[0].prevout = parent;
+            }
+            const CTransactionRef ptx = MakeTransactionRef(std::move(mtx));
+            if (!Add(pool, ptx, RandomFee(*ptx)) && fChild) {
+                // Too many ancestors or descendants; fall back to confirmed inputs only.
+                CMutableTransaction mtxRoot(*ptx);
+                mtxRoot.vin[0].prevout = ConfirmedOutpoint();
+                const CTransactionRef ptxRoot = MakeTransactionRef(std::move(mtxRoot));
+                Add(pool, ptxRoot, RandomFee(*ptxRoot));
+            }
+        }
+    }
+};
+
+/** Make the regtest genesis block the chain tip, as CreateNewBlock needs one. */
+static void SetupGenesisTip()
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    static CBlockIndex genesis;
+    static uint256 hashGenesis;
+    const CBlock& block = Params().GenesisBlock();
+    hashGenesis = block.GetHash();
+    genesis = CBlockIndex(block);
+    genesis.phashBlock = &hashGenesis;
+    genesis.nHeight = 0;
+    LOCK(cs_main);
+    chainActive.SetTip(&genesis);
+}
+
+static BlockAssembler::Options AssemblerOptions()
+{
+    BlockAssembler::Options options;
+    options.nBlockMaxWeight = DEFAULT_BLOCK_MAX_WEIGHT;
+    options.blockMinFeeRate = CFeeRate(DEFAULT_BLOCK_MIN_TX_FEE);
+    // The generated transactions spend made up coins.
+    options.fTestBlockValidity = false;
+    return options;
+}
+
+static void ClearMempool()
+{
+    LOCK(mempool.cs);
+    mempool.clear();
+}
+
+} // namespace
+
+static void MempoolCreateNewBlock(benchmark::State& state, size_t nTransactions)
+{
+    SetupGenesisTip();
+    MempoolGenerator generator;
+    generator.Fill(mempool, nTransactions);
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate;
+    while (state.KeepRunning()) {
+        pblocktemplate = BlockAssembler(Params(), AssemblerOptions()).CreateNewBlock(scriptPubKey);
+    }
+    // Revenue of the template, to compare selection changes against each other.
+    std::cerr << state.m_name << ": " << pblocktemplate->block.vtx.size() - 1 << " transactions, "
+              << -pblocktemplate->vTxFees[0] << " fees in template\n";
+    ClearMempool();
+}
+
+static void MempoolTrimToSize(benchmark::State& state, size_t nTransactions)
+{
+    MempoolGenerator generator;
+    generator.Fill(mempool, nTransactions);
+
+    while (state.KeepRunning()) {
+        // Evict about 1% of the pool, then top it up again.
+        {
+            LOCK(mempool.cs);
+            mempool.TrimToSize(mempool.DynamicMemoryUsage() / 100 * 99);
+        }
+        generator.Fill(mempool, nTransactions);
+    }
+    ClearMempool();
+}
+
+static void MempoolRemoveForBlock(benchmark::State& state, size_t nTransactions)
+{
+    SetupGenesisTip();
+    MempoolGenerator generator;
+    generator.Fill(mempool, nTransactions);
+    const CScript scriptPubKey = CScript() << OP_TRUE;
+
+    while (state.KeepRunning()) {
+        // Mine a full template, then top the pool up again.
+        std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(Params(), AssemblerOptions()).CreateNewBlock(scriptPubKey);
+        {
+            LOCK(mempool.cs);
+            mempool.removeForBlock(pblocktemplate->block.vtx, 1);
+        }
+        generator.Fill(mempool, nTransactions);
+    }
+    ClearMempool();
+}
+
+static void MempoolCreateNewBlock10k(benchmark::State& state) { MempoolCreateNewBlock(state, 10000); }
+static void MempoolCreateNewBlock100k(benchmark::State& state) { MempoolCreateNewBlock(state, 100000); }
+static void MempoolCreateNewBlock500k(benchmark::State& state) { MempoolCreateNewBlock(state, 500000); }
+static void MempoolTrimToSize10k(benchmark::State& state) { MempoolTrimToSize(state, 10000); }
+static void MempoolTrimToSize100k(benchmark::State& state) { MempoolTrimToSize(state, 100000); }
+static void MempoolTrimToSize500k(benchmark::State& state) { MempoolTrimToSize(state, 500000); }
+static void MempoolRemoveForBlock10k(benchmark::State& state) { MempoolRemoveForBlock(state, 10000); }
+static void MempoolRemoveForBlock100k(benchmark::State& state) { MempoolRemoveForBlock(state, 100000); }
+static void MempoolRemoveForBlock500k(benchmark::State& state) { MempoolRemoveForBlock(state, 500000); }
+
+BENCHMARK(MempoolCreateNewBlock10k, 50);
+BENCHMARK(MempoolCreateNewBlock100k, 10);
+BENCHMARK(MempoolCreateNewBlock500k, 2);
+BENCHMARK(MempoolTrimToSize10k, 50);
+BENCHMARK(MempoolTrimToSize100k, 10);
+BENCHMARK(MempoolTrimToSize500k, 2);
+BENCHMARK(MempoolRemoveForBlock10k, 10);
+BENCHMARK(MempoolRemoveForBlock100k, 5);
+BENCHMARK(MempoolRemoveForBlock500k, 1);
@@ -0,0 +1,65 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+
+#include <chainparams.h>
+#include <rpc/blockchain.h>
+#include <streams.h>
+#include <validation.h>
+
+#include <univalue.h>
+
+namespace block_bench {
+#include <bench/data/block413567.raw.h>
+} // namespace block_bench
+
+static CBlock ReadBenchBlock()
+{
+    // Transaction outputs are shown with their addresses
+    SelectParams(CBaseChainParams::MAIN);
+
+    CDataStream stream((const char*)block_bench::block413567,
+            (const char*)&block_bench::block413567[sizeof(block_bench::block413567)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+    return block;
+}
+
+static UniValue BenchBlockToJSON(const CBlock& block)
+{
+    const uint256 blockHash = block.GetHash();
+    CBlockIndex blockindex;
+    blockindex.phashBlock = &blockHash;
+    blockindex.nBits = block.nBits;
+
+    LOCK(cs_main);
+    return blockToJSON(block, &blockindex, true);
+}
+
+// The result of getblock with verbosity 2, built and written
+static void BlockToJsonVerbose(benchmark::State& state)
+{
+    const CBlock block = ReadBenchBlock();
+
+    while (state.KeepRunning()) {
+        (void)BenchBlockToJSON(block).write();
+    }
+}
+
+// ... and read back by a client
+static void BlockFromJsonVerbose(benchmark::State& state)
+{
+    const std::string strJSON = BenchBlockToJSON(ReadBenchBlock()).write();
+
+    while (state.KeepRunning()) {
+        UniValue value;
+        bool ok = value.read(strJSON);
+        assert(ok);
+    }
+}
+
+BENCHMARK(BlockToJsonVerbose, 10);
+BENCHMARK(BlockFromJsonVerbose, 20);
@@ -104,34 +104,55 @@ ReadStatus PartiallyDownloadedBlock::InitData(const CBlockHeaderAndShortTxIDs& c
     std::vector<bool> have_txn(txn_available.size());
     {
     LOCK(pool->cs);
-    const std::vector<std::pair<uint256, CTxMemPool::txiter> >& vTxHashes = pool->vTxHashes;
-    for (size_t i = 0; i < vTxHashes.size(); i++) {
-        uint64_t shortid = cmpctblock.GetShortID(vTxHashes[i].first);
-        std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
-        if (idit != shorttxids.end()) {
-            if (!have_txn[idit->second]) {
-                txn_available[idit->second] = vTxHashes[i].second->GetSharedTx();
-                have_txn[idit->second]  = true;
-                mempool_count++;
-            } else {
-                // If we find two mempool txn that match the short id, just request it.
-                // This should be rare enough that the extra bandwidth doesn't matter,
-                // but eating a round-trip due to FillBlock failure would be annoying
-                if (txn_available[idit->second]) {
-                    txn_available[idit->second].reset();
-                    mempool_count--;
-                }
+    auto add_mempool_txn = [&](const uint256& wtxid, CTxMemPool::txiter it) {
+        std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(cmpctblock.GetShortID(wtxid));
+        if (idit == shorttxids.end())
+            return;
+        if (!have_txn[idit->second]) {
+            txn_available[idit->second] = it->GetSharedTx();
+            have_txn[idit->second]  = true;
+            mempool_count++;
+        } else {
+            // If we find two mempool txn that match the short id, just request it.
+            // This should be rare enough that the extra bandwidth doesn't matter,
+            // but eating a round-trip due to FillBlock failure would be annoying
+            // Note that we don't want finding the same transaction in both scans
+            // below to trigger this case, so we compare witness hashes first
+            if (txn_available[idit->second] && txn_available[idit->second]->GetWitnessHash() != wtxid) {
+                txn_available[idit->second].reset();
+                mempool_count--;
             }
         }
+    };
+
+    // A new block mostly holds the transactions our own block template would
+    // pick first, so try the best packages by ancestor feerate before hashing
+    // the whole mempool. When we have every transaction of the block this
+    // finds them all after a few blocks' worth of entries, however large the
+    // mempool is.
+    const size_t max_best_scan = 2 * shorttxids.size() + 100;
+    size_t best_scanned = 0;
+    const auto& ancestor_index = pool->mapTx.get<ancestor_score>();
+    for (auto mi = ancestor_index.begin(); mi != ancestor_index.end() && best_scanned < max_best_scan; ++mi, ++best_scanned) {
+        if (mempool_count == shorttxids.size())
+            break;
+        add_mempool_txn(mi->GetTx().GetWitnessHash(), pool->mapTx.project<0>(mi));
+    }
+
+    const std::vector<std::pair<uint256, CTxMemPool::txiter> >& vTxHashes = pool->vTxHashes;
+    for (size_t i = 0; i < vTxHashes.size(); i++) {
         // Though ideally we'd continue scanning for the two-txn-match-shortid case,
         // the performance win of an early exit here is too good to pass up and worth
         // the extra risk.
         if (mempool_count == shorttxids.size())
             break;
+        add_mempool_txn(vTxHashes[i].first, vTxHashes[i].second);
     }
     }
 
     for (size_t i = 0; i < extra_txn.size(); i++) {
+        if (!extra_txn[i].second)
+            continue;
         uint64_t shortid = cmpctblock.GetShortID(extra_txn[i].first);
         std::unordered_map<uint64_t, uint16_t>::iterator idit = shorttxids.find(shortid);
         if (idit != shorttxids.end()) {
@@ -181,6 +181,9 @@ public:
                    //   (the tx=... number in the SetBestChain debug.log lines)
            0.015     // * estimated number of transactions per second after that timestamp
         };
+
+        // Trusted UTXO snapshots for -loadtxoutset: {base block hash, hash reported by dumptxoutset}
+        mapUTXOSnapshots = {};
     }
 };
 
@@ -25,6 +25,9 @@ struct CCheckpointData {
     MapCheckpoints mapCheckpoints;
 };
 
+/** Hashes of trusted UTXO snapshots (see utxosnapshot.h), by the hash of their base block */
+typedef std::map<uint256, uint256> MapUTXOSnapshots;
+
 struct ChainTxData {
     int64_t nTime;
     int64_t nTxCount;
@@ -73,6 +76,7 @@ public:
     const std::vector<SeedSpec6>& FixedSeeds() const { return vFixedSeeds; }
     const CCheckpointData& Checkpoints() const { return checkpointData; }
     const ChainTxData& TxData() const { return chainTxData; }
+    const MapUTXOSnapshots& UTXOSnapshots() const { return mapUTXOSnapshots; }
     void UpdateVersionBitsParameters(Consensus::DeploymentPos d, int64_t nStartTime, int64_t nTimeout);
     std::string SporkKey() const { return strSporkKey; }
 
@@ -94,6 +98,7 @@ protected:
     bool fMineBlocksOnDemand;
     CCheckpointData checkpointData;
     ChainTxData chainTxData;
+    MapUTXOSnapshots mapUTXOSnapshots;
     std::string strSporkKey;
 };
 
@@ -104,6 +104,7 @@ struct CCoinsCacheEntry
 {
     Coin coin; // The actual cached data.
     unsigned char flags;
+    uint32_t nLastUsed; // Batch counter of the owning cache when this entry was last touched (see CCoinsViewCache::Trim).
 
     enum Flags {
         DIRTY = (1 << 0), // This cache entry is potentially different from the version in the parent view.
@@ -115,8 +116,8 @@ struct CCoinsCacheEntry
          */
     };
 
-    CCoinsCacheEntry() : flags(0) {}
-    explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0) {}
+    CCoinsCacheEntry() : flags(0), nLastUsed(0) {}
+    explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0), nLastUsed(0) {}
 };
 
 typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
@@ -211,6 +212,9 @@ protected:
     /* Cached dynamic memory usage for the inner Coin objects. */
     mutable size_t cachedCoinsUsage;
 
+    /* Number of batches written into this cache; used to age entries for Trim. */
+    uint32_t nBatchCounter;
+
 public:
     CCoinsViewCache(CCoinsView *baseIn);
 
@@ -248,6 +252,14 @@ public:
      */
     const Coin& AccessCoin(const COutPoint &output) const;
 
+    /**
+     * Add an unmodified coin that the caller has read from the backing view
+     * itself, exactly as if it had been fetched by this cache. Does nothing if
+     * the outpoint is cached already. This lets coins be read from the backing
+     * view concurrently, while the cache itself is only touched by one thread.
+     */
+    void AddFetchedCoin(const COutPoint& outpoint, Coin&& coin);
+
     /**
      * Add a coin. Set potential_overwrite to true if a non-pruned version may
      * already exist.
@@ -268,6 +280,16 @@ public:
      */
     bool Flush();
 
+    /**
+     * Push the modifications applied to this cache to its base without emptying it,
+     * then evict the least recently used unmodified entries until the memory usage
+     * is at most nTargetUsage. Entries age by one for every BatchWrite into this cache,
+     * so for pcoinsTip the age of an entry is roughly the number of blocks since it
+     * was last used.
+     * If false is returned, the state of this cache (and its backing view) will be undefined.
+     */
+    bool Trim(size_t nTargetUsage);
+
     /**
      * Removes the UTXO with the given outpoint from the cache, if it is
      * not modified.
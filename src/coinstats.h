@@ -0,0 +1,79 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_COINSTATS_H
+#define BITCOIN_COINSTATS_H
+
+#include <amount.h>
+#include <crypto/muhash.h>
+#include <serialize.h>
+#include <uint256.h>
+
+#include <stdint.h>
+
+class CBlock;
+class CBlockUndo;
+class CCoinsView;
+class COutPoint;
+class Coin;
+
+/** -utxostats default (maintain UTXO set statistics block by block) */
+static const bool DEFAULT_UTXOSTATS = false;
+
+/**
+ * UTXO set statistics that are kept up to date while blocks are connected
+ * and disconnected, so that they do not need a scan of the whole set.
+ * The set itself is committed to by a MuHash of all its coins.
+ */
+class CRollingCoinsStats
+{
+public:
+    uint256 hashBlock;
+    uint64_t nTransactionOutputs;
+    uint64_t nBogoSize;
+    CAmount nTotalAmount;
+    MuHash3072 muhash;
+
+    CRollingCoinsStats() : nTransactionOutputs(0), nBogoSize(0), nTotalAmount(0) {}
+
+    void AddCoin(const COutPoint& outpoint, const Coin& coin);
+    void RemoveCoin(const COutPoint& outpoint, const Coin& coin);
+
+    /** Apply the coins created and spent by a block at height nHeight, connected on top of hashBlock. */
+    void ConnectBlock(const CBlock& block, const CBlockUndo& blockundo, int nHeight);
+    /** Revert ConnectBlock, moving the statistics back to the block's parent. */
+    void DisconnectBlock(const CBlock& block, const CBlockUndo& blockundo, int nHeight);
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(hashBlock);
+        READWRITE(nTransactionOutputs);
+        READWRITE(nBogoSize);
+        READWRITE(nTotalAmount);
+        READWRITE(muhash);
+    }
+};
+
+/** Statistics about the unspent transaction output set, as computed by a full scan */
+struct CCoinsStats
+{
+    int nHeight;
+    uint256 hashBlock;
+    uint64_t nTransactions;
+    uint64_t nTransactionOutputs;
+    uint64_t nBogoSize;
+    uint256 hashSerialized;
+    uint64_t nDiskSize;
+    CAmount nTotalAmount;
+
+    CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
+};
+
+//! Calculate statistics about the unspent transaction output set. If prolling
+//! is set, it is filled in from the same scan.
+bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats, CRollingCoinsStats *prolling = nullptr);
+
+#endif // BITCOIN_COINSTATS_H
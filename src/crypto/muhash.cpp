@@ -0,0 +1,162 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/muhash.h>
+
+#include <crypto/chacha20.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
+
+#include <assert.h>
+#include <string.h>
+
+namespace {
+
+/** 2^3072 - MAX_PRIME_DIFF is the largest 3072-bit prime. */
+const uint32_t MAX_PRIME_DIFF = 1103717;
+
+} // namespace
+
+bool Num3072::IsOverflow() const
+{
+    if (limbs[0] <= 0xFFFFFFFFUL - MAX_PRIME_DIFF) return false;
+    for (int i = 1; i < LIMBS; ++i) {
+        if (limbs[i] != 0xFFFFFFFFUL) return false;
+    }
+    return true;
+}
+
+void Num3072::FullReduce()
+{
+    // Subtracting the prime is the same as adding MAX_PRIME_DIFF and dropping 2^3072.
+    uint64_t carry = MAX_PRIME_DIFF;
+    for (int i = 0; i < LIMBS; ++i) {
+        carry += limbs[i];
+        limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+}
+
+void Num3072::MultiplyLimbs(const Num3072& a)
+{
+    // Schoolbook multiplication into a 6144-bit product.
+    uint32_t prod[2 * LIMBS];
+    memset(prod, 0, sizeof(prod));
+    for (int i = 0; i < LIMBS; ++i) {
+        uint64_t carry = 0;
+        for (int j = 0; j < LIMBS; ++j) {
+            carry += prod[i + j] + (uint64_t)limbs[i] * a.limbs[j];
+            prod[i + j] = (uint32_t)carry;
+            carry >>= 32;
+        }
+        prod[i + LIMBS] = (uint32_t)carry;
+    }
+
+    // Reduce using 2^3072 = MAX_PRIME_DIFF (mod p): fold the high half onto the low half.
+    uint64_t carry = 0;
+    for (int i = 0; i < LIMBS; ++i) {
+        carry += prod[i] + (uint64_t)prod[i + LIMBS] * MAX_PRIME_DIFF;
+        limbs[i] = (uint32_t)carry;
+        carry >>= 32;
+    }
+    // What is left above 2^3072 is less than 2^22; keep folding until it is gone.
+    while (carry) {
+        uint64_t fold = carry * MAX_PRIME_DIFF;
+        carry = 0;
+        for (int i = 0; i < LIMBS && (fold || carry); ++i) {
+            carry += limbs[i] + (fold & 0xFFFFFFFFUL);
+            fold >>= 32;
+            limbs[i] = (uint32_t)carry;
+            carry >>= 32;
+        }
+    }
+}
+
+void Num3072::Multiply(const Num3072& a)
+{
+    MultiplyLimbs(a);
+    if (IsOverflow()) FullReduce();
+}
+
+void Num3072::SetToInverse(const Num3072& a)
+{
+    // By Fermat's little theorem, a^-1 = a^(p-2) (mod p). The exponent
+    // p - 2 = 2^3072 - MAX_PRIME_DIFF - 2 has all bits set except in its lowest limb.
+    const uint32_t low = (uint32_t)(0xFFFFFFFFUL - MAX_PRIME_DIFF - 1);
+    SetToOne();
+    for (int i = LIMBS - 1; i >= 0; --i) {
+        uint32_t word = (i == 0) ? low : 0xFFFFFFFFUL;
+        for (int bit = 31; bit >= 0; --bit) {
+            Num3072 square = *this;
+            Multiply(square);
+            if ((word >> bit) & 1) {
+                Multiply(a);
+            }
+        }
+    }
+}
+
+void Num3072::SetToOne()
+{
+    limbs[0] = 1;
+    for (int i = 1; i < LIMBS; ++i) {
+        limbs[i] = 0;
+    }
+}
+
+Num3072::Num3072(const unsigned char (&data)[BYTE_SIZE])
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        limbs[i] = ReadLE32(data + 4 * i);
+    }
+}
+
+void Num3072::ToBytes(unsigned char (&out)[BYTE_SIZE]) const
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        WriteLE32(out + 4 * i, limbs[i]);
+    }
+}
+
+Num3072 MuHash3072::ToNum3072(const unsigned char* data, size_t len)
+{
+    unsigned char hash[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(data, len).Finalize(hash);
+    unsigned char tmp[Num3072::BYTE_SIZE];
+    ChaCha20(hash, sizeof(hash)).Output(tmp, sizeof(tmp));
+    // Values of at least the prime are so unlikely (about 2^-3050) that they
+    // are left unreduced; Multiply copes with any 3072-bit input.
+    return Num3072(tmp);
+}
+
+MuHash3072& MuHash3072::Insert(const unsigned char* data, size_t len)
+{
+    numerator.Multiply(ToNum3072(data, len));
+    return *this;
+}
+
+MuHash3072& MuHash3072::Remove(const unsigned char* data, size_t len)
+{
+    denominator.Multiply(ToNum3072(data, len));
+    return *this;
+}
+
+MuHash3072& MuHash3072::operator*=(const MuHash3072& mul)
+{
+    numerator.Multiply(mul.numerator);
+    denominator.Multiply(mul.denominator);
+    return *this;
+}
+
+void MuHash3072::Finalize(uint256& out)
+{
+    Num3072 inverse;
+    inverse.SetToInverse(denominator);
+    numerator.Multiply(inverse);
+    denominator.SetToOne();
+
+    unsigned char data[Num3072::BYTE_SIZE];
+    numerator.ToBytes(data);
+    CSHA256().Write(data, sizeof(data)).Finalize(out.begin());
+}
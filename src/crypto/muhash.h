@@ -0,0 +1,90 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_CRYPTO_MUHASH_H
+#define BITCOIN_CRYPTO_MUHASH_H
+
+#include <serialize.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/** A number modulo the 3072-bit safe-ish prime 2^3072 - 1103717. */
+class Num3072
+{
+private:
+    void FullReduce();
+    bool IsOverflow() const;
+    void MultiplyLimbs(const Num3072& a);
+
+public:
+    static const size_t BYTE_SIZE = 384;
+    static const int LIMBS = 96;
+    uint32_t limbs[LIMBS];
+
+    /** Set this number to the inverse of a modulo the prime. */
+    void SetToInverse(const Num3072& a);
+    void Multiply(const Num3072& a);
+    void SetToOne();
+    void ToBytes(unsigned char (&out)[BYTE_SIZE]) const;
+
+    Num3072() { SetToOne(); }
+    explicit Num3072(const unsigned char (&data)[BYTE_SIZE]);
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        for (int i = 0; i < LIMBS; ++i) {
+            READWRITE(limbs[i]);
+        }
+    }
+};
+
+/**
+ * A multiplicative hash of a set of byte strings (MuHash, see
+ * https://cseweb.ucsd.edu/~mihir/papers/inchash.pdf).
+ *
+ * Every element is hashed to a number modulo a 3072-bit prime by expanding
+ * its SHA256 with ChaCha20; the set is represented by the product of those
+ * numbers. Elements can be added and removed in any order, which makes it
+ * suitable for maintaining a commitment to the UTXO set block by block.
+ * Removals are tracked in a separate denominator, so that the (expensive)
+ * modular inverse is only computed in Finalize.
+ */
+class MuHash3072
+{
+private:
+    Num3072 numerator;
+    Num3072 denominator;
+
+    static Num3072 ToNum3072(const unsigned char* data, size_t len);
+
+public:
+    /** The hash of the empty set. */
+    MuHash3072() {}
+
+    /** Add an element to the set. */
+    MuHash3072& Insert(const unsigned char* data, size_t len);
+
+    /** Remove an element from the set. */
+    MuHash3072& Remove(const unsigned char* data, size_t len);
+
+    /** Combine with another set (union of both). */
+    MuHash3072& operator*=(const MuHash3072& mul);
+
+    /** Hash the set to a 256-bit value. Normalizes the internal state. */
+    void Finalize(uint256& out);
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(numerator);
+        READWRITE(denominator);
+    }
+};
+
+#endif // BITCOIN_CRYPTO_MUHASH_H
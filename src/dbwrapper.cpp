@@ -6,6 +6,8 @@
 
 #include <memory>
 #include <random.h>
+#include <sync.h>
+#include <utilstrencodings.h>
 
 #include <leveldb/cache.h>
 #include <leveldb/env.h>
@@ -13,6 +15,7 @@
 #include <memenv.h>
 #include <stdint.h>
 #include <algorithm>
+#include <set>
 
 class CBitcoinLevelDBLogger : public leveldb::Logger {
 public:
@@ -72,14 +75,60 @@ public:
     }
 };
 
-static leveldb::Options GetOptions(size_t nCacheSize)
+static const char* const DB_NAMES[] = {"chainstate", "blockindex", "sporks"};
+static const char* const DB_OPTION_NAMES[] = {"block_cache_size", "write_buffer_size", "block_size", "bloom_bits", "compression", "max_open_files", "max_file_size"};
+
+bool ParseDBOption(const std::string& strOption, std::string& strDB, std::string& strName, int64_t& nValue)
+{
+    size_t nColon = strOption.find(':');
+    size_t nEquals = strOption.find('=', nColon == std::string::npos ? 0 : nColon);
+    if (nColon == std::string::npos || nEquals == std::string::npos) {
+        return false;
+    }
+    strDB = strOption.substr(0, nColon);
+    strName = strOption.substr(nColon + 1, nEquals - nColon - 1);
+    if (!ParseInt64(strOption.substr(nEquals + 1), &nValue) || nValue < 0) {
+        return false;
+    }
+    return std::find(std::begin(DB_NAMES), std::end(DB_NAMES), strDB) != std::end(DB_NAMES) &&
+           std::find(std::begin(DB_OPTION_NAMES), std::end(DB_OPTION_NAMES), strName) != std::end(DB_OPTION_NAMES);
+}
+
+static leveldb::Options GetOptions(size_t nCacheSize, const std::string& name, size_t& nBlockCacheSize, int& nBloomBits)
 {
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
+    nBlockCacheSize = nCacheSize / 2;
     options.write_buffer_size = nCacheSize / 4; // up to two write buffers may be held in memory simultaneously
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
+    nBloomBits = 10;
     options.compression = leveldb::kNoCompression;
     options.max_open_files = 64;
+
+    // Per-database overrides, as -dboption=<db>:<option>=<n>; validated at startup.
+    for (const std::string& strOption : gArgs.GetArgs("-dboption")) {
+        std::string strDB, strName;
+        int64_t nValue;
+        if (!ParseDBOption(strOption, strDB, strName, nValue) || strDB != name) {
+            continue;
+        }
+        if (strName == "block_cache_size") {
+            nBlockCacheSize = nValue;
+        } else if (strName == "write_buffer_size") {
+            options.write_buffer_size = nValue;
+        } else if (strName == "block_size") {
+            options.block_size = nValue;
+        } else if (strName == "bloom_bits") {
+            nBloomBits = nValue;
+        } else if (strName == "compression") {
+            options.compression = nValue ? leveldb::kSnappyCompression : leveldb::kNoCompression;
+        } else if (strName == "max_open_files") {
+            options.max_open_files = nValue;
+        } else if (strName == "max_file_size") {
+            options.max_file_size = nValue;
+        }
+    }
+
+    options.block_cache = leveldb::NewLRUCache(nBlockCacheSize);
+    options.filter_policy = nBloomBits > 0 ? leveldb::NewBloomFilterPolicy(nBloomBits) : nullptr;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 || (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
         // LevelDB versions before 1.16 consider short writes to be corruption. Only trigger error
@@ -89,14 +138,19 @@ static leveldb::Options GetOptions(size_t nCacheSize)
     return options;
 }
 
-CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate)
+/** Named databases that are open, for GetDBWrapperInfo */
+static CCriticalSection cs_dbwrappers;
+static std::set<const CDBWrapper*> setDBWrappers GUARDED_BY(cs_dbwrappers);
+
+CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, bool obfuscate, const std::string& nameIn)
+    : name(nameIn), dbpath(path)
 {
     penv = nullptr;
     readoptions.verify_checksums = true;
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(nCacheSize);
+    options = GetOptions(nCacheSize, name, nBlockCacheSize, nBloomBits);
     options.create_if_missing = true;
     if (fMemory) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -138,10 +192,19 @@ CDBWrapper::CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory, bo
     }
 
     LogPrintf("Using obfuscation key for %s: %s\n", path.string(), HexStr(obfuscate_key));
+
+    if (!name.empty()) {
+        LOCK(cs_dbwrappers);
+        setDBWrappers.insert(this);
+    }
 }
 
 CDBWrapper::~CDBWrapper()
 {
+    {
+        LOCK(cs_dbwrappers);
+        setDBWrappers.erase(this);
+    }
     Sync();
 
     delete pdb;
@@ -183,6 +246,56 @@ std::vector<unsigned char> CDBWrapper::CreateObfuscateKey() const
 
 }
 
+void CDBWrapper::GetInfo(DBWrapperInfo& info, bool fVerbose) const
+{
+    info.name = name;
+    info.path = dbpath;
+
+    // Keys are serialized with a leading type byte, so this range covers all of them.
+    const std::string strEnd(8, '\xff');
+    const leveldb::Slice begin, end(strEnd);
+    leveldb::Range range(begin, end);
+    uint64_t nSize = 0;
+    pdb->GetApproximateSizes(&range, 1, &nSize);
+    info.nApproximateSize = nSize;
+
+    std::string strValue;
+    info.nMemoryUsage = 0;
+    if (pdb->GetProperty("leveldb.approximate-memory-usage", &strValue)) {
+        info.nMemoryUsage = atoi64(strValue);
+    }
+    info.vFilesPerLevel.clear();
+    for (int level = 0; pdb->GetProperty("leveldb.num-files-at-level" + std::to_string(level), &strValue); level++) {
+        info.vFilesPerLevel.push_back(atoi(strValue));
+    }
+    info.strStats.clear();
+    if (fVerbose && pdb->GetProperty("leveldb.stats", &strValue)) {
+        info.strStats = strValue;
+        if (pdb->GetProperty("leveldb.sstables", &strValue)) {
+            info.strStats += strValue;
+        }
+    }
+
+    info.nBlockCacheSize = nBlockCacheSize;
+    info.nWriteBufferSize = options.write_buffer_size;
+    info.nBlockSize = options.block_size;
+    info.nBloomBits = nBloomBits;
+    info.fCompression = options.compression != leveldb::kNoCompression;
+    info.nMaxOpenFiles = options.max_open_files;
+    info.nMaxFileSize = options.max_file_size;
+}
+
+std::vector<DBWrapperInfo> GetDBWrapperInfo(bool fVerbose)
+{
+    LOCK(cs_dbwrappers);
+    std::vector<DBWrapperInfo> vInfo(setDBWrappers.size());
+    size_t i = 0;
+    for (const CDBWrapper* pdbwrapper : setDBWrappers) {
+        pdbwrapper->GetInfo(vInfo[i++], fVerbose);
+    }
+    return vInfo;
+}
+
 bool CDBWrapper::IsEmpty()
 {
     std::unique_ptr<CDBIterator> it(NewIterator());
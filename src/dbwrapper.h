@@ -173,6 +173,35 @@ public:
 
 };
 
+/** Settings and LevelDB statistics of an open database, as reported by getdbinfo */
+struct DBWrapperInfo
+{
+    std::string name;
+    fs::path path;
+    uint64_t nApproximateSize;
+    uint64_t nMemoryUsage;
+    std::vector<int> vFilesPerLevel;
+    //! leveldb.stats and leveldb.sstables; only filled in when asked for
+    std::string strStats;
+
+    size_t nBlockCacheSize;
+    size_t nWriteBufferSize;
+    size_t nBlockSize;
+    int nBloomBits;
+    bool fCompression;
+    int nMaxOpenFiles;
+    size_t nMaxFileSize;
+};
+
+/**
+ * Parse a -dboption=<db>:<option>=<n> setting. Returns false if it is malformed
+ * or names an unknown database or option.
+ */
+bool ParseDBOption(const std::string& strOption, std::string& strDB, std::string& strName, int64_t& nValue);
+
+/** Describe all named databases that are currently open. */
+std::vector<DBWrapperInfo> GetDBWrapperInfo(bool fVerbose);
+
 class CDBWrapper
 {
     friend const std::vector<unsigned char>& dbwrapper_private::GetObfuscateKey(const CDBWrapper &w);
@@ -180,9 +209,19 @@ private:
     //! custom environment this database is using (may be nullptr in case of default environment)
     leveldb::Env* penv;
 
+    //! name under which -dboption settings apply and the database is reported (may be empty)
+    std::string name;
+
+    //! location of the database
+    fs::path dbpath;
+
     //! database options used
     leveldb::Options options;
 
+    //! settings behind options.block_cache and options.filter_policy
+    size_t nBlockCacheSize;
+    int nBloomBits;
+
     //! options used when reading from the database
     leveldb::ReadOptions readoptions;
 
@@ -217,8 +256,10 @@ public:
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
+     * @param[in] name        Name used for -dboption settings and getdbinfo; unnamed
+     *                        databases are not reported.
      */
-    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false, const std::string& name = "");
     ~CDBWrapper();
 
     template <typename K, typename V>
@@ -306,6 +347,11 @@ public:
      */
     bool IsEmpty();
 
+    /**
+     * Describe the settings and LevelDB statistics of this database.
+     */
+    void GetInfo(DBWrapperInfo& info, bool fVerbose) const;
+
     template<typename K>
     size_t EstimateSize(const K& key_begin, const K& key_end) const
     {
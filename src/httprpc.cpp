@@ -7,6 +7,7 @@
 #include <base58.h>
 #include <chainparams.h>
 #include <httpserver.h>
+#include <rpc/jsonstream.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <random.h>
@@ -83,6 +84,43 @@ static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const Uni
     req->WriteReply(nStatus, strReply);
 }
 
+/** Reply to a single request as its result is produced, if the command can.
+ *  Returns false, having sent nothing, if it cannot. */
+static bool JSONRPCStreamReply(HTTPRequest* req, const JSONRPCRequest& jreq)
+{
+    bool fStarted = false;
+    JSONStreamWriter writer([req, &fStarted](const std::string& strChunk) {
+        if (!fStarted) {
+            req->WriteHeader("Content-Type", "application/json");
+            fStarted = true;
+        }
+        req->WriteReplyChunk(HTTP_OK, strChunk);
+    });
+
+    // Same layout as JSONRPCReply
+    writer.BeginObject();
+    writer.Key("result");
+    try {
+        if (!tableRPC.executeStream(jreq, writer))
+            return false;
+    } catch (...) {
+        if (!writer.Flushed())
+            throw;
+        // Too late to reply with the error, cut the reply short instead
+        LogPrintf("ThreadRPCServer method=%s failed while sending its result\n", SanitizeString(jreq.strMethod));
+        req->WriteReplyEnd();
+        return true;
+    }
+    writer.Key("error");
+    writer.Value(NullUniValue);
+    writer.Key("id");
+    writer.Value(jreq.id);
+    writer.EndObject();
+    writer.Finish();
+    req->WriteReplyEnd();
+    return true;
+}
+
 //This function checks username and password against -rpcauth
 //entries from config file.
 static bool multiUserAuthorized(std::string strUserPass)
@@ -187,6 +225,9 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
 
+            if (JSONRPCStreamReply(req, jreq))
+                return true;
+
             UniValue result = tableRPC.execute(jreq);
 
             // Send reply
@@ -59,6 +59,7 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    bool replyStarted;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req);
@@ -114,6 +115,21 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Write part of a chunked HTTP reply, for replies produced bit by bit.
+     * The first call sends the status line, with status code nStatus, and
+     * the output headers.
+     */
+    void WriteReplyChunk(int nStatus, const std::string& strChunk);
+
+    /**
+     * End a reply started with WriteReplyChunk.
+     *
+     * @note Same as for WriteReply, do not call any other HTTPRequest methods
+     * after calling this.
+     */
+    void WriteReplyEnd();
 };
 
 /** Event handler closure.
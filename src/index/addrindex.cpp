@@ -0,0 +1,315 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addrindex.h>
+
+#include <chain.h>
+#include <coins.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
+#include <undo.h>
+#include <util.h>
+
+/*
+ * Entries are keyed by the script hash first, then by height, so those of
+ * one script are next to each other, in chain order:
+ *  'a' script height outpoint -> value, spending txid (null if unspent) and height
+ *  'u' script height outpoint -> value, for unspent outputs only
+ *  'h' script height position -> txid, for every transaction paying to or
+ *                                spending from the script
+ */
+static const char DB_ADDR_OUTPUT = 'a';
+static const char DB_ADDR_UNSPENT = 'u';
+static const char DB_ADDR_HISTORY = 'h';
+
+std::unique_ptr<AddrIndex> g_addr_index;
+
+namespace {
+
+template<typename Stream>
+void SerializeBE32(Stream& s, uint32_t n)
+{
+    unsigned char buf[4];
+    WriteBE32(buf, n);
+    s.write((char*)buf, sizeof(buf));
+}
+
+template<typename Stream>
+uint32_t UnserializeBE32(Stream& s)
+{
+    unsigned char buf[4];
+    s.read((char*)buf, sizeof(buf));
+    return ReadBE32(buf);
+}
+
+struct OutputKey
+{
+    char prefix;
+    uint256 hashScript;
+    int nHeight;
+    COutPoint outpoint;
+
+    OutputKey() : prefix(0), nHeight(0) {}
+    OutputKey(char prefixIn, const uint256& hashScriptIn, int nHeightIn, const COutPoint& outpointIn) :
+        prefix(prefixIn), hashScript(hashScriptIn), nHeight(nHeightIn), outpoint(outpointIn) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ::Serialize(s, prefix);
+        ::Serialize(s, hashScript);
+        SerializeBE32(s, nHeight);
+        ::Serialize(s, outpoint);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        ::Unserialize(s, prefix);
+        ::Unserialize(s, hashScript);
+        nHeight = UnserializeBE32(s);
+        ::Unserialize(s, outpoint);
+    }
+};
+
+struct OutputValue
+{
+    CAmount nValue;
+    uint256 spentTxid;
+    int nSpentHeight;
+
+    OutputValue() : nValue(0), nSpentHeight(0) {}
+    OutputValue(CAmount nValueIn, const uint256& spentTxidIn, int nSpentHeightIn) :
+        nValue(nValueIn), spentTxid(spentTxidIn), nSpentHeight(nSpentHeightIn) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(nValue);
+        READWRITE(spentTxid);
+        READWRITE(nSpentHeight);
+    }
+};
+
+struct HistoryKey
+{
+    char prefix;
+    uint256 hashScript;
+    int nHeight;
+    uint32_t nPos;
+
+    HistoryKey() : prefix(DB_ADDR_HISTORY), nHeight(0), nPos(0) {}
+    HistoryKey(const uint256& hashScriptIn, int nHeightIn, uint32_t nPosIn) :
+        prefix(DB_ADDR_HISTORY), hashScript(hashScriptIn), nHeight(nHeightIn), nPos(nPosIn) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ::Serialize(s, prefix);
+        ::Serialize(s, hashScript);
+        SerializeBE32(s, nHeight);
+        SerializeBE32(s, nPos);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        ::Unserialize(s, prefix);
+        ::Unserialize(s, hashScript);
+        nHeight = UnserializeBE32(s);
+        nPos = UnserializeBE32(s);
+    }
+};
+
+uint256 ScriptHash(const CScript& script)
+{
+    uint256 hash;
+    CSHA256().Write(script.data(), script.size()).Finalize(hash.begin());
+    return hash;
+}
+
+} // namespace
+
+/** Access to the address index database (indexes/addrindex/) */
+class AddrIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+    /**
+     * Call fn with the key and value of each entry with prefix about script,
+     * in order, until it returns false. Returns false if an entry could not
+     * be read.
+     */
+    template<typename K, typename V, typename Fn>
+    bool ForEach(char prefix, const uint256& hashScript, Fn fn);
+};
+
+AddrIndex::DB::DB(size_t nCacheSize, bool fMemory, bool fWipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "addrindex", nCacheSize, fMemory, fWipe, "addrindex")
+{
+}
+
+template<typename K, typename V, typename Fn>
+bool AddrIndex::DB::ForEach(char prefix, const uint256& hashScript, Fn fn)
+{
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    for (pcursor->Seek(std::make_pair(prefix, hashScript)); pcursor->Valid(); pcursor->Next()) {
+        K key;
+        if (!pcursor->GetKey(key) || key.prefix != prefix || key.hashScript != hashScript)
+            break;
+        V value;
+        if (!pcursor->GetValue(value))
+            return error("%s: failed to read entry", __func__);
+        if (!fn(key, value))
+            break;
+    }
+    return true;
+}
+
+AddrIndex::AddrIndex(size_t nCacheSize, bool fMemory, bool fWipe) :
+    m_db(new AddrIndex::DB(nCacheSize, fMemory, fWipe))
+{
+}
+
+AddrIndex::~AddrIndex()
+{
+    // Before the database goes away
+    Interrupt();
+    Stop();
+}
+
+BaseIndex::DB& AddrIndex::GetDB() const
+{
+    return *m_db;
+}
+
+bool AddrIndex::WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& undo, const CBlockIndex* pindex)
+{
+    // The outputs of the genesis block are not spendable
+    if (pindex->nHeight == 0)
+        return true;
+
+    if (block.vtx.size() != undo.vtxundo.size() + 1)
+        return error("%s: undo data does not match block %s", __func__, pindex->GetBlockHash().ToString());
+
+    // In block order, so outputs spent within the block end up spent
+    for (size_t i = 0; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+
+        if (i > 0) {
+            const CTxUndo& txundo = undo.vtxundo[i - 1];
+            if (txundo.vprevout.size() != tx.vin.size())
+                return error("%s: undo data does not match transaction %s", __func__, txid.ToString());
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                const Coin& coin = txundo.vprevout[j];
+                const uint256 hashScript = ScriptHash(coin.out.scriptPubKey);
+                const COutPoint& prevout = tx.vin[j].prevout;
+                batch.Write(OutputKey(DB_ADDR_OUTPUT, hashScript, coin.nHeight, prevout), OutputValue(coin.out.nValue, txid, pindex->nHeight));
+                batch.Erase(OutputKey(DB_ADDR_UNSPENT, hashScript, coin.nHeight, prevout));
+                batch.Write(HistoryKey(hashScript, pindex->nHeight, i), txid);
+            }
+        }
+
+        for (uint32_t n = 0; n < tx.vout.size(); n++) {
+            const CTxOut& out = tx.vout[n];
+            if (out.scriptPubKey.IsUnspendable())
+                continue;
+            const uint256 hashScript = ScriptHash(out.scriptPubKey);
+            const COutPoint outpoint(txid, n);
+            batch.Write(OutputKey(DB_ADDR_OUTPUT, hashScript, pindex->nHeight, outpoint), OutputValue(out.nValue, uint256(), 0));
+            batch.Write(OutputKey(DB_ADDR_UNSPENT, hashScript, pindex->nHeight, outpoint), out.nValue);
+            batch.Write(HistoryKey(hashScript, pindex->nHeight, i), txid);
+        }
+    }
+    return true;
+}
+
+bool AddrIndex::EraseBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& undo, const CBlockIndex* pindex)
+{
+    if (block.vtx.size() != undo.vtxundo.size() + 1)
+        return error("%s: undo data does not match block %s", __func__, pindex->GetBlockHash().ToString());
+
+    // In reverse block order, undoing WriteBlock
+    for (size_t i = block.vtx.size(); i-- > 0;) {
+        const CTransaction& tx = *block.vtx[i];
+        const uint256& txid = tx.GetHash();
+
+        for (uint32_t n = 0; n < tx.vout.size(); n++) {
+            const CTxOut& out = tx.vout[n];
+            if (out.scriptPubKey.IsUnspendable())
+                continue;
+            const uint256 hashScript = ScriptHash(out.scriptPubKey);
+            const COutPoint outpoint(txid, n);
+            batch.Erase(OutputKey(DB_ADDR_OUTPUT, hashScript, pindex->nHeight, outpoint));
+            batch.Erase(OutputKey(DB_ADDR_UNSPENT, hashScript, pindex->nHeight, outpoint));
+            batch.Erase(HistoryKey(hashScript, pindex->nHeight, i));
+        }
+
+        if (i > 0) {
+            const CTxUndo& txundo = undo.vtxundo[i - 1];
+            if (txundo.vprevout.size() != tx.vin.size())
+                return error("%s: undo data does not match transaction %s", __func__, txid.ToString());
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                const Coin& coin = txundo.vprevout[j];
+                const uint256 hashScript = ScriptHash(coin.out.scriptPubKey);
+                const COutPoint& prevout = tx.vin[j].prevout;
+                batch.Write(OutputKey(DB_ADDR_OUTPUT, hashScript, coin.nHeight, prevout), OutputValue(coin.out.nValue, uint256(), 0));
+                batch.Write(OutputKey(DB_ADDR_UNSPENT, hashScript, coin.nHeight, prevout), coin.out.nValue);
+                batch.Erase(HistoryKey(hashScript, pindex->nHeight, i));
+            }
+        }
+    }
+    return true;
+}
+
+bool AddrIndex::FindTxids(const CScript& script, size_t nSkip, size_t nCount, std::vector<std::pair<int, uint256>>& vTxids) const
+{
+    return m_db->ForEach<HistoryKey, uint256>(DB_ADDR_HISTORY, ScriptHash(script),
+        [&](const HistoryKey& key, const uint256& txid) -> bool {
+            if (nSkip > 0) {
+                nSkip--;
+                return true;
+            }
+            vTxids.emplace_back(key.nHeight, txid);
+            return vTxids.size() < nCount;
+        });
+}
+
+bool AddrIndex::FindOutputs(const CScript& script, bool fIncludeSpent, size_t nSkip, size_t nCount, std::vector<CAddrIndexOutput>& vOutputs) const
+{
+    if (fIncludeSpent) {
+        return m_db->ForEach<OutputKey, OutputValue>(DB_ADDR_OUTPUT, ScriptHash(script),
+            [&](const OutputKey& key, const OutputValue& value) -> bool {
+                if (nSkip > 0) {
+                    nSkip--;
+                    return true;
+                }
+                vOutputs.push_back(CAddrIndexOutput{key.outpoint, key.nHeight, value.nValue, value.spentTxid, value.nSpentHeight});
+                return vOutputs.size() < nCount;
+            });
+    }
+    return m_db->ForEach<OutputKey, CAmount>(DB_ADDR_UNSPENT, ScriptHash(script),
+        [&](const OutputKey& key, const CAmount& nValue) -> bool {
+            if (nSkip > 0) {
+                nSkip--;
+                return true;
+            }
+            vOutputs.push_back(CAddrIndexOutput{key.outpoint, key.nHeight, nValue, uint256(), 0});
+            return vOutputs.size() < nCount;
+        });
+}
+
+bool AddrIndex::GetBalance(const CScript& script, CAmount& nBalance, CAmount& nReceived) const
+{
+    const uint256 hashScript = ScriptHash(script);
+    nBalance = 0;
+    nReceived = 0;
+    return m_db->ForEach<OutputKey, CAmount>(DB_ADDR_UNSPENT, hashScript,
+               [&](const OutputKey&, const CAmount& nValue) -> bool { nBalance += nValue; return true; }) &&
+           m_db->ForEach<OutputKey, OutputValue>(DB_ADDR_OUTPUT, hashScript,
+               [&](const OutputKey&, const OutputValue& value) -> bool { nReceived += value.nValue; return true; });
+}
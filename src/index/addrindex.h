@@ -0,0 +1,75 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRINDEX_H
+#define BITCOIN_INDEX_ADDRINDEX_H
+
+#include <amount.h>
+#include <index/base.h>
+#include <script/script.h>
+#include <uint256.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+/** Default for -addrindex */
+static const bool DEFAULT_ADDRINDEX = false;
+//! Max memory allocated to the address index database cache (MiB)
+static const int64_t nMaxAddrIndexCache = 1024;
+
+/** An output in the address index */
+struct CAddrIndexOutput
+{
+    COutPoint outpoint;
+    int nHeight;
+    CAmount nValue;
+    //! The transaction spending the output and its height, null if unspent
+    uint256 spentTxid;
+    int nSpentHeight;
+};
+
+/**
+ * Index of the transaction outputs in the active chain by the SHA256 hash of
+ * their scriptPubKey, so the history, unspent outputs and balance of an
+ * address can be looked up. For every output it keeps its height, value and
+ * the transaction spending it, if any. Enabled with -addrindex.
+ *
+ * Results are in chain order, and can be fetched in pages.
+ */
+class AddrIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool NeedsUndo() const override { return true; }
+    bool WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& undo, const CBlockIndex* pindex) override;
+    bool EraseBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& undo, const CBlockIndex* pindex) override;
+
+    BaseIndex::DB& GetDB() const override;
+    const char* GetName() const override { return "addrindex"; }
+
+public:
+    /** Constructs the index, which becomes available to be queried once synced */
+    explicit AddrIndex(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    virtual ~AddrIndex() override;
+
+    /** Get the (height, txid) of the transactions paying to or spending from
+     *  script, skipping the first nSkip of them and returning at most nCount */
+    bool FindTxids(const CScript& script, size_t nSkip, size_t nCount, std::vector<std::pair<int, uint256>>& vTxids) const;
+    /** Get the unspent outputs paying to script, or all of them if fIncludeSpent,
+     *  paged as in FindTxids */
+    bool FindOutputs(const CScript& script, bool fIncludeSpent, size_t nSkip, size_t nCount, std::vector<CAddrIndexOutput>& vOutputs) const;
+    /** Get the total value of the unspent outputs and of all outputs paying to script */
+    bool GetBalance(const CScript& script, CAmount& nBalance, CAmount& nReceived) const;
+};
+
+/** The global address index, if -addrindex is set */
+extern std::unique_ptr<AddrIndex> g_addr_index;
+
+#endif // BITCOIN_INDEX_ADDRINDEX_H
@@ -0,0 +1,308 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/base.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <init.h>
+#include <streams.h>
+#include <tinyformat.h>
+#include <ui_interface.h>
+#include <undo.h>
+#include <util.h>
+#include <utiltime.h>
+#include <validation.h>
+#include <warnings.h>
+
+#include <functional>
+
+static const char DB_BEST_BLOCK = 'B';
+
+//! Interval between logging the progress of the initial sync
+static const int64_t SYNC_LOG_INTERVAL = 30; // seconds
+
+template<typename... Args>
+static void FatalError(const char* fmt, const Args&... args)
+{
+    std::string strMessage = tfm::format(fmt, args...);
+    SetMiscWarning(strMessage);
+    LogPrintf("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(
+        "Error: A fatal internal error occurred, see debug.log for details",
+        "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+}
+
+BaseIndex::DB::DB(const fs::path& path, size_t nCacheSize, bool fMemory, bool fWipe, const std::string& name) :
+    CDBWrapper(path, nCacheSize, fMemory, fWipe, false, name)
+{
+}
+
+bool BaseIndex::DB::ReadBestBlock(uint256& hash) const
+{
+    return Read(DB_BEST_BLOCK, hash);
+}
+
+void BaseIndex::DB::WriteBestBlock(CDBBatch& batch, const uint256& hash)
+{
+    batch.Write(DB_BEST_BLOCK, hash);
+}
+
+BaseIndex::BaseIndex() : m_synced(false), m_best_block_index(nullptr)
+{
+}
+
+BaseIndex::~BaseIndex()
+{
+    Interrupt();
+    Stop();
+}
+
+bool BaseIndex::Start()
+{
+    uint256 hashBest;
+    if (GetDB().ReadBestBlock(hashBest)) {
+        LOCK(cs_main);
+        BlockMap::const_iterator it = mapBlockIndex.find(hashBest);
+        if (it == mapBlockIndex.end())
+            return error("%s: best block %s of %s is not in the block tree", __func__, hashBest.ToString(), GetName());
+        m_best_block_index = it->second;
+    }
+
+    // Notifications are ignored until the sync thread hands over, under
+    // cs_main, so none is missed
+    RegisterValidationInterface(this);
+
+    m_thread_sync = std::thread(&TraceThread<std::function<void()>>, GetName(),
+                                std::bind(&BaseIndex::ThreadSync, this));
+    return true;
+}
+
+void BaseIndex::Interrupt()
+{
+    m_interrupt();
+}
+
+void BaseIndex::Stop()
+{
+    UnregisterValidationInterface(this);
+
+    if (m_thread_sync.joinable())
+        m_thread_sync.join();
+}
+
+int BaseIndex::GetBestHeight() const
+{
+    const CBlockIndex* pindex = m_best_block_index.load();
+    return pindex ? pindex->nHeight : -1;
+}
+
+bool BaseIndex::ReadBlockData(const CBlockIndex* pindex, CBlock& block, CBlockUndo& undo) const
+{
+    CDiskBlockPos blockPos, undoPos;
+    {
+        LOCK(cs_main);
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA))
+            return error("%s: block %s is not available", __func__, pindex->GetBlockHash().ToString());
+        blockPos = pindex->GetBlockPos();
+        undoPos = pindex->GetUndoPos();
+    }
+
+    // The block was checked when it was stored, only make sure it is the one
+    std::vector<uint8_t> blockData;
+    if (!ReadRawBlockFromDisk(blockData, blockPos, Params().MessageStart()))
+        return false;
+    try {
+        CDataStream(blockData, SER_DISK, CLIENT_VERSION) >> block;
+    } catch (const std::exception& e) {
+        return error("%s: Deserialize error - %s at %s", __func__, e.what(), blockPos.ToString());
+    }
+    if (block.GetHash() != pindex->GetBlockHash())
+        return error("%s: block at %s is not %s", __func__, blockPos.ToString(), pindex->GetBlockHash().ToString());
+
+    if (NeedsUndo() && pindex->pprev)
+        return UndoReadFromDisk(undo, undoPos, pindex->pprev->GetBlockHash());
+    return true;
+}
+
+bool BaseIndex::DisconnectBest(const CBlock& block, const CBlockUndo& undo)
+{
+    const CBlockIndex* pindex = m_best_block_index.load();
+    assert(pindex && pindex->pprev && block.GetHash() == pindex->GetBlockHash());
+
+    CDBBatch batch(GetDB());
+    if (!EraseBlock(batch, block, undo, pindex))
+        return false;
+    GetDB().WriteBestBlock(batch, pindex->pprev->GetBlockHash());
+    if (!GetDB().WriteBatch(batch))
+        return false;
+    m_best_block_index = pindex->pprev;
+    return true;
+}
+
+void BaseIndex::ThreadSync()
+{
+    const CBlockIndex* pindex = m_best_block_index.load();
+    int64_t nLastLogTime = 0;
+    while (!m_synced) {
+        if (m_interrupt)
+            return;
+
+        // Blocks to remove from the index, best first, and the next ones to add
+        std::vector<const CBlockIndex*> vDisconnect, vConnect;
+        {
+            LOCK(cs_main);
+            const CBlockIndex* pfork = chainActive.FindFork(pindex);
+            for (const CBlockIndex* pwalk = pindex; pwalk != pfork; pwalk = pwalk->pprev)
+                vDisconnect.push_back(pwalk);
+            const CBlockIndex* pnext = pfork ? chainActive.Next(pfork) : chainActive.Genesis();
+            for (; pnext != nullptr && vConnect.size() < INDEX_SYNC_BATCH_SIZE; pnext = chainActive.Next(pnext))
+                vConnect.push_back(pnext);
+
+            if (vDisconnect.empty() && vConnect.empty()) {
+                m_synced = true;
+                break;
+            }
+        }
+
+        for (const CBlockIndex* pdisconnect : vDisconnect) {
+            CBlock block;
+            CBlockUndo undo;
+            if (!ReadBlockData(pdisconnect, block, undo) || !DisconnectBest(block, undo)) {
+                FatalError("%s: failed to rewind %s from block %s", __func__, GetName(), pdisconnect->GetBlockHash().ToString());
+                return;
+            }
+        }
+        pindex = m_best_block_index.load();
+
+        // Read the next blocks in parallel, then add them in order
+        std::vector<CBlock> vBlocks(vConnect.size());
+        std::vector<CBlockUndo> vUndo(vConnect.size());
+        std::vector<char> vRead(vConnect.size(), false);
+        std::atomic<size_t> nNext(0);
+        auto reader = [&]() {
+            for (size_t i = nNext++; i < vConnect.size() && !m_interrupt; i = nNext++)
+                vRead[i] = ReadBlockData(vConnect[i], vBlocks[i], vUndo[i]);
+        };
+        std::vector<std::thread> vReaders;
+        for (int i = 1; i < INDEX_SYNC_READ_THREADS && (size_t)i < vConnect.size(); i++)
+            vReaders.emplace_back(reader);
+        reader();
+        for (std::thread& thread : vReaders)
+            thread.join();
+        if (m_interrupt)
+            return;
+
+        CDBBatch batch(GetDB());
+        for (size_t i = 0; i < vConnect.size(); i++) {
+            if (!vRead[i] || !WriteBlock(batch, vBlocks[i], vUndo[i], vConnect[i])) {
+                FatalError("%s: failed to add block %s to %s", __func__, vConnect[i]->GetBlockHash().ToString(), GetName());
+                return;
+            }
+        }
+        GetDB().WriteBestBlock(batch, vConnect.back()->GetBlockHash());
+        if (!GetDB().WriteBatch(batch)) {
+            FatalError("%s: failed to write %s", __func__, GetName());
+            return;
+        }
+        pindex = vConnect.back();
+        m_best_block_index = pindex;
+
+        int64_t nTime = GetTime();
+        if (nTime - nLastLogTime >= SYNC_LOG_INTERVAL) {
+            LogPrintf("Syncing %s with block chain from height %d\n", GetName(), pindex->nHeight);
+            nLastLogTime = nTime;
+        }
+    }
+
+    LogPrintf("%s is enabled at height %d\n", GetName(), GetBestHeight());
+}
+
+void BaseIndex::BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
+                               const std::vector<CTransactionRef>& txnConflicted)
+{
+    if (!m_synced)
+        return;
+
+    const CBlockIndex* pbest = m_best_block_index.load();
+    if (pindex->pprev != pbest) {
+        // Notifications queued before the sync thread handed over can be for
+        // blocks it already added, or for blocks that are no longer in the
+        // active chain, whose disconnection follows.
+        if (pbest == nullptr || pbest->GetAncestor(pindex->nHeight) != pindex) {
+            LogPrintf("%s: block %s does not connect to the best block %s of %s, ignoring it\n", __func__,
+                      pindex->GetBlockHash().ToString(), pbest ? pbest->GetBlockHash().ToString() : "(none)", GetName());
+        }
+        return;
+    }
+
+    CBlockUndo undo;
+    if (NeedsUndo() && pindex->pprev) {
+        CDiskBlockPos undoPos;
+        {
+            LOCK(cs_main);
+            undoPos = pindex->GetUndoPos();
+        }
+        if (!UndoReadFromDisk(undo, undoPos, pindex->pprev->GetBlockHash())) {
+            FatalError("%s: failed to read undo data of block %s for %s", __func__, pindex->GetBlockHash().ToString(), GetName());
+            return;
+        }
+    }
+
+    CDBBatch batch(GetDB());
+    if (!WriteBlock(batch, *block, undo, pindex)) {
+        FatalError("%s: failed to add block %s to %s", __func__, pindex->GetBlockHash().ToString(), GetName());
+        return;
+    }
+    GetDB().WriteBestBlock(batch, pindex->GetBlockHash());
+    if (!GetDB().WriteBatch(batch)) {
+        FatalError("%s: failed to write %s", __func__, GetName());
+        return;
+    }
+    m_best_block_index = pindex;
+}
+
+void BaseIndex::BlockDisconnected(const std::shared_ptr<const CBlock>& block)
+{
+    if (!m_synced)
+        return;
+
+    // See BlockConnected about notifications for other blocks
+    const CBlockIndex* pbest = m_best_block_index.load();
+    if (pbest == nullptr || pbest->GetBlockHash() != block->GetHash())
+        return;
+
+    CBlockUndo undo;
+    if (NeedsUndo()) {
+        CDiskBlockPos undoPos;
+        {
+            LOCK(cs_main);
+            undoPos = pbest->GetUndoPos();
+        }
+        if (!UndoReadFromDisk(undo, undoPos, pbest->pprev->GetBlockHash())) {
+            FatalError("%s: failed to read undo data of block %s for %s", __func__, pbest->GetBlockHash().ToString(), GetName());
+            return;
+        }
+    }
+
+    if (!DisconnectBest(*block, undo))
+        FatalError("%s: failed to remove block %s from %s", __func__, pbest->GetBlockHash().ToString(), GetName());
+}
+
+bool BaseIndex::BlockUntilSyncedToCurrentChain()
+{
+    if (!m_synced)
+        return false;
+
+    {
+        LOCK(cs_main);
+        if (m_best_block_index.load() == chainActive.Tip())
+            return true;
+    }
+
+    SyncWithValidationInterfaceQueue();
+    return true;
+}
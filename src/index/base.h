@@ -0,0 +1,109 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_BASE_H
+#define BITCOIN_INDEX_BASE_H
+
+#include <dbwrapper.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <threadinterrupt.h>
+#include <uint256.h>
+#include <validationinterface.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+class CBlockIndex;
+class CBlockUndo;
+
+/** Blocks read ahead at a time by the initial sync of an index */
+static const size_t INDEX_SYNC_BATCH_SIZE = 32;
+/** Threads reading blocks from disk for the initial sync of an index */
+static const int INDEX_SYNC_READ_THREADS = 4;
+
+/**
+ * Base class for optional indexes of the block chain, each kept in its own
+ * database. An index first catches up with the active chain on its own
+ * thread, reading blocks from disk in parallel, and from then on follows it
+ * through validation interface notifications. Block connection itself is
+ * never held up by an index.
+ *
+ * The index stores the block it is synced to together with the entries of
+ * every block, so it is consistent after a crash, and rewinds by itself if
+ * that block left the active chain while the node was down.
+ */
+class BaseIndex : public CValidationInterface
+{
+protected:
+    class DB : public CDBWrapper
+    {
+    public:
+        DB(const fs::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, const std::string& name = "");
+
+        /** Read the hash of the last block in the index */
+        bool ReadBestBlock(uint256& hash) const;
+        void WriteBestBlock(CDBBatch& batch, const uint256& hash);
+    };
+
+private:
+    /** Whether the index caught up with the active chain and follows notifications */
+    std::atomic<bool> m_synced;
+    /** The last block in the index, nullptr if it is empty */
+    std::atomic<const CBlockIndex*> m_best_block_index;
+
+    std::thread m_thread_sync;
+    CThreadInterrupt m_interrupt;
+
+    /** Catch up with the active chain, then hand over to notifications */
+    void ThreadSync();
+    /** Read a block, and its undo data if the index needs it */
+    bool ReadBlockData(const CBlockIndex* pindex, CBlock& block, CBlockUndo& undo) const;
+    /** Remove the last block from the index */
+    bool DisconnectBest(const CBlock& block, const CBlockUndo& undo);
+
+protected:
+    void BlockConnected(const std::shared_ptr<const CBlock>& block, const CBlockIndex* pindex,
+                        const std::vector<CTransactionRef>& txnConflicted) override;
+    void BlockDisconnected(const std::shared_ptr<const CBlock>& block) override;
+
+    /** Whether WriteBlock and EraseBlock are given the undo data of blocks */
+    virtual bool NeedsUndo() const { return false; }
+    /** Add the entries of a block connected on top of the index to batch */
+    virtual bool WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& undo, const CBlockIndex* pindex) = 0;
+    /** Remove the entries of the last block in the index in batch */
+    virtual bool EraseBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& undo, const CBlockIndex* pindex) = 0;
+
+    virtual DB& GetDB() const = 0;
+    /** Name of the index for log messages */
+    virtual const char* GetName() const = 0;
+    std::string GetSubscriberName() const override { return GetName(); }
+
+public:
+    BaseIndex();
+    /** Destructor interrupts and stops the sync thread */
+    virtual ~BaseIndex();
+
+    /** Load the state of the index, start following the chain and the sync
+     *  thread. Returns false if the index does not fit the block tree. */
+    bool Start();
+    void Interrupt();
+    /** Stop the sync thread and following the chain */
+    void Stop();
+
+    bool IsSynced() const { return m_synced; }
+    /** Height of the last block in the index, -1 if it is empty */
+    int GetBestHeight() const;
+
+    /**
+     * Wait for the notifications about the current chain tip to be handled,
+     * so that the index is up to date with it. Returns false right away if
+     * the index is still catching up on its own.
+     */
+    bool BlockUntilSyncedToCurrentChain();
+};
+
+#endif // BITCOIN_INDEX_BASE_H
@@ -0,0 +1,98 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/txindex.h>
+
+#include <chain.h>
+#include <clientversion.h>
+#include <streams.h>
+#include <txdb.h>
+#include <util.h>
+#include <validation.h>
+
+static const char DB_TXINDEX = 't';
+
+std::unique_ptr<TxIndex> g_txindex;
+
+/** Access to the transaction index database (indexes/txindex/) */
+class TxIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+    bool ReadTxPos(const uint256& txid, CDiskTxPos& pos) const;
+};
+
+TxIndex::DB::DB(size_t nCacheSize, bool fMemory, bool fWipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "txindex", nCacheSize, fMemory, fWipe, "txindex")
+{
+}
+
+bool TxIndex::DB::ReadTxPos(const uint256& txid, CDiskTxPos& pos) const
+{
+    return Read(std::make_pair(DB_TXINDEX, txid), pos);
+}
+
+TxIndex::TxIndex(size_t nCacheSize, bool fMemory, bool fWipe) :
+    m_db(new TxIndex::DB(nCacheSize, fMemory, fWipe))
+{
+}
+
+TxIndex::~TxIndex()
+{
+    // Before the database goes away
+    Interrupt();
+    Stop();
+}
+
+BaseIndex::DB& TxIndex::GetDB() const
+{
+    return *m_db;
+}
+
+bool TxIndex::WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& undo, const CBlockIndex* pindex)
+{
+    // The genesis block transaction is not spendable, nor looked up
+    if (pindex->nHeight == 0)
+        return true;
+
+    // The position of a block does not change once it is stored
+    CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
+    for (const CTransactionRef& tx : block.vtx) {
+        batch.Write(std::make_pair(DB_TXINDEX, tx->GetHash()), pos);
+        pos.nTxOffset += ::GetSerializeSize(*tx, SER_DISK, CLIENT_VERSION);
+    }
+    return true;
+}
+
+bool TxIndex::EraseBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& undo, const CBlockIndex* pindex)
+{
+    for (const CTransactionRef& tx : block.vtx)
+        batch.Erase(std::make_pair(DB_TXINDEX, tx->GetHash()));
+    return true;
+}
+
+bool TxIndex::FindTx(const uint256& txid, uint256& hashBlock, CTransactionRef& tx) const
+{
+    CDiskTxPos postx;
+    if (!m_db->ReadTxPos(txid, postx))
+        return false;
+
+    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull())
+        return error("%s: OpenBlockFile failed", __func__);
+    CBlockHeader header;
+    try {
+        file >> header;
+        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR))
+            return error("%s: fseek(...) failed", __func__);
+        file >> tx;
+    } catch (const std::exception& e) {
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+    if (tx->GetHash() != txid)
+        return error("%s: txid mismatch", __func__);
+    hashBlock = header.GetHash();
+    return true;
+}
@@ -0,0 +1,59 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_TXINDEX_H
+#define BITCOIN_INDEX_TXINDEX_H
+
+#include <index/base.h>
+#include <primitives/transaction.h>
+#include <uint256.h>
+
+#include <memory>
+
+/** Default for -txindex */
+static const bool DEFAULT_TXINDEX = false;
+//! Max memory allocated to the transaction index database cache (MiB)
+// Unlike for the UTXO database, for the txindex scenario the leveldb cache make
+// a meaningful difference: https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
+static const int64_t nMaxTxIndexCache = 1024;
+
+/**
+ * Index of the transactions in the active chain by txid, pointing to where
+ * they are stored on disk. Enabled with -txindex.
+ */
+class TxIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+protected:
+    bool WriteBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& undo, const CBlockIndex* pindex) override;
+    bool EraseBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& undo, const CBlockIndex* pindex) override;
+
+    BaseIndex::DB& GetDB() const override;
+    const char* GetName() const override { return "txindex"; }
+
+public:
+    /** Constructs the index, which becomes available to be queried once synced */
+    explicit TxIndex(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    virtual ~TxIndex() override;
+
+    /**
+     * Look up a transaction by txid.
+     *
+     * @param[in]   txid        The id of the transaction to look up
+     * @param[out]  hashBlock   The hash of the block containing the transaction
+     * @param[out]  tx          The transaction itself
+     * @return  true if the transaction was found in the index and read from disk
+     */
+    bool FindTx(const uint256& txid, uint256& hashBlock, CTransactionRef& tx) const;
+};
+
+/** The global transaction index, if -txindex is set */
+extern std::unique_ptr<TxIndex> g_txindex;
+
+#endif // BITCOIN_INDEX_TXINDEX_H
@@ -5,52 +5,156 @@
 #ifndef BITCOIN_INDIRECTMAP_H
 #define BITCOIN_INDIRECTMAP_H
 
-template <class T>
-struct DereferencingComparator { bool operator()(const T a, const T b) const { return *a < *b; } };
+#include <iterator>
+#include <utility>
+#include <vector>
 
-/* Map whose keys are pointers, but are compared by their dereferenced values.
+#include <stddef.h>
+
+/* Hash map whose keys are pointers, but are hashed and compared by their
+ * dereferenced values.
+ *
+ * Methods that take a key for lookup take a K rather than a K* (taking a K*
+ * would be confusing, since it's the value rather than the address of the
+ * object that matters).
  *
- * Differs from a plain std::map<const K*, T, DereferencingComparator<K*> > in
- * that methods that take a key for comparison take a K rather than taking a K*
- * (taking a K* would be confusing, since it's the value rather than the address
- * of the object for comparison that matters due to the dereferencing comparator).
+ * Entries are kept in a single flat array using open addressing with linear
+ * probing, so there is no allocation per entry. A slot with a null key is
+ * empty. Iteration order is unspecified, and insert and erase invalidate all
+ * iterators.
  *
- * Objects pointed to by keys must not be modified in any way that changes the
- * result of DereferencingComparator.
+ * Objects pointed to by keys must not be modified in any way that changes
+ * their hash or equality while they are in the map.
  */
-template <class K, class T>
+template <class K, class T, class Hash>
 class indirectmap {
+public:
+    typedef std::pair<const K*, T> value_type;
+    typedef size_t size_type;
+
 private:
-    typedef std::map<const K*, T, DereferencingComparator<const K*> > base;
-    base m;
+    typedef std::vector<value_type> slots_type;
+    slots_type slots; //!< Power of two sized, or empty
+    size_type nSize;
+    Hash hasher;
+
+    static const size_type MIN_SLOTS = 16;
+
+    size_type Bucket(const K& key) const { return hasher(key) & (slots.size() - 1); }
+
+    /** Index of the slot holding key, or slots.size() if there is none. */
+    size_type FindSlot(const K& key) const
+    {
+        if (nSize == 0) return slots.size();
+        for (size_type i = Bucket(key); ; i = (i + 1) & (slots.size() - 1)) {
+            if (slots[i].first == nullptr) return slots.size();
+            if (*slots[i].first == key) return i;
+        }
+    }
+
+    /** Place value in the first free slot of its probe sequence; its key must not be present. */
+    size_type Place(const value_type& value)
+    {
+        size_type i = Bucket(*value.first);
+        while (slots[i].first != nullptr) {
+            i = (i + 1) & (slots.size() - 1);
+        }
+        slots[i] = value;
+        return i;
+    }
+
+    void Rehash(size_type nSlots)
+    {
+        slots_type old(nSlots, value_type(nullptr, T()));
+        old.swap(slots);
+        for (const value_type& value : old) {
+            if (value.first != nullptr) Place(value);
+        }
+    }
+
+    /** Empty slot i, shifting later entries of its cluster back so that no lookup misses them. */
+    void EraseSlot(size_type i)
+    {
+        const size_type mask = slots.size() - 1;
+        for (size_type j = (i + 1) & mask; slots[j].first != nullptr; j = (j + 1) & mask) {
+            const size_type k = Bucket(*slots[j].first);
+            // The entry in slot j may move to i only if its bucket is not in (i, j] (cyclically).
+            const bool fStays = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+            if (!fStays) {
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        slots[i] = value_type(nullptr, T());
+        nSize--;
+    }
+
+    template <typename V>
+    class iter_base : public std::iterator<std::forward_iterator_tag, V>
+    {
+        friend class indirectmap;
+        V* pos;
+        V* last;
+        iter_base(V* posIn, V* lastIn) : pos(posIn), last(lastIn) { SkipEmpty(); }
+        void SkipEmpty() { while (pos != last && pos->first == nullptr) ++pos; }
+    public:
+        iter_base() : pos(nullptr), last(nullptr) {}
+        template <typename W>
+        iter_base(const iter_base<W>& other) : pos(other.pos), last(other.last) {}
+        V& operator*() const { return *pos; }
+        V* operator->() const { return pos; }
+        iter_base& operator++() { ++pos; SkipEmpty(); return *this; }
+        iter_base operator++(int) { iter_base copy(*this); ++(*this); return copy; }
+        bool operator==(const iter_base& other) const { return pos == other.pos; }
+        bool operator!=(const iter_base& other) const { return pos != other.pos; }
+        template <typename W> friend class iter_base;
+    };
+
 public:
-    typedef typename base::iterator iterator;
-    typedef typename base::const_iterator const_iterator;
-    typedef typename base::size_type size_type;
-    typedef typename base::value_type value_type;
-
-    // passthrough (pointer interface)
-    std::pair<iterator, bool> insert(const value_type& value) { return m.insert(value); }
-
-    // pass address (value interface)
-    iterator find(const K& key)                     { return m.find(&key); }
-    const_iterator find(const K& key) const         { return m.find(&key); }
-    iterator lower_bound(const K& key)              { return m.lower_bound(&key); }
-    const_iterator lower_bound(const K& key) const  { return m.lower_bound(&key); }
-    size_type erase(const K& key)                   { return m.erase(&key); }
-    size_type count(const K& key) const             { return m.count(&key); }
-
-    // passthrough
-    bool empty() const              { return m.empty(); }
-    size_type size() const          { return m.size(); }
-    size_type max_size() const      { return m.max_size(); }
-    void clear()                    { m.clear(); }
-    iterator begin()                { return m.begin(); }
-    iterator end()                  { return m.end(); }
-    const_iterator begin() const    { return m.begin(); }
-    const_iterator end() const      { return m.end(); }
-    const_iterator cbegin() const   { return m.cbegin(); }
-    const_iterator cend() const     { return m.cend(); }
+    typedef iter_base<value_type> iterator;
+    typedef iter_base<const value_type> const_iterator;
+
+    indirectmap() : nSize(0) {}
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        size_type i = FindSlot(*value.first);
+        if (i != slots.size()) return std::make_pair(MakeIter(i), false);
+        // Keep the load factor at most 3/4.
+        if ((nSize + 1) * 4 > slots.size() * 3) {
+            Rehash(slots.empty() ? MIN_SLOTS : slots.size() * 2);
+        }
+        i = Place(value);
+        nSize++;
+        return std::make_pair(MakeIter(i), true);
+    }
+
+    iterator find(const K& key)                     { return MakeIter(FindSlot(key)); }
+    const_iterator find(const K& key) const         { return MakeIter(FindSlot(key)); }
+    size_type count(const K& key) const             { return FindSlot(key) != slots.size(); }
+    size_type erase(const K& key)
+    {
+        size_type i = FindSlot(key);
+        if (i == slots.size()) return 0;
+        EraseSlot(i);
+        return 1;
+    }
+
+    bool empty() const              { return nSize == 0; }
+    size_type size() const          { return nSize; }
+    /** Number of slots allocated, for memory usage accounting. */
+    size_type capacity() const      { return slots.size(); }
+    void clear()                    { slots_type().swap(slots); nSize = 0; }
+    iterator begin()                { return MakeIter(0); }
+    iterator end()                  { return MakeIter(slots.size()); }
+    const_iterator begin() const    { return MakeIter(0); }
+    const_iterator end() const      { return MakeIter(slots.size()); }
+    const_iterator cbegin() const   { return begin(); }
+    const_iterator cend() const     { return end(); }
+
+private:
+    iterator MakeIter(size_type i)             { return iterator(slots.data() + i, slots.data() + slots.size()); }
+    const_iterator MakeIter(size_type i) const { return const_iterator(slots.data() + i, slots.data() + slots.size()); }
 };
 
 #endif // BITCOIN_INDIRECTMAP_H
@@ -117,18 +117,14 @@ static inline size_t IncrementalDynamicUsage(const std::map<X, Y, Z>& m)
     return MallocUsage(sizeof(stl_tree_node<std::pair<const X, Y> >));
 }
 
-// indirectmap has underlying map with pointer as key
+// indirectmap is a flat array of (pointer, value) slots, kept at most 3/4 full.
+// Charge each entry its share of a full table, so that usage falls as entries
+// are removed rather than depending on how large the table once grew.
 
-template<typename X, typename Y>
-static inline size_t DynamicUsage(const indirectmap<X, Y>& m)
-{
-    return MallocUsage(sizeof(stl_tree_node<std::pair<const X*, Y> >)) * m.size();
-}
-
-template<typename X, typename Y>
-static inline size_t IncrementalDynamicUsage(const indirectmap<X, Y>& m)
+template<typename X, typename Y, typename Z>
+static inline size_t DynamicUsage(const indirectmap<X, Y, Z>& m)
 {
-    return MallocUsage(sizeof(stl_tree_node<std::pair<const X*, Y> >));
+    return sizeof(std::pair<const X*, Y>) * m.size() * 4 / 3;
 }
 
 template<typename X>
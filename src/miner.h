@@ -132,6 +132,7 @@ private:
     bool fIncludeWitness;
     unsigned int nBlockMaxWeight;
     CFeeRate blockMinFeeRate;
+    bool fTestBlockValidity;
 
     // Information on the current status of the block
     uint64_t nBlockWeight;
@@ -150,6 +151,8 @@ public:
         Options();
         size_t nBlockMaxWeight;
         CFeeRate blockMinFeeRate;
+        //! Check the template with TestBlockValidity; only benchmarks turn this off
+        bool fTestBlockValidity;
     };
 
     explicit BlockAssembler(const CChainParams& params);
@@ -2692,7 +2692,7 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     fInbound(fInboundIn),
     nKeyedNetGroup(nKeyedNetGroupIn),
     addrKnown(5000, 0.001),
-    filterInventoryKnown(50000, 0.000001),
+    filterInventoryKnown(MIN_INVENTORY_KNOWN_ELEMENTS, 0.000001),
     id(idIn),
     nLocalHostNonce(nLocalHostNonceIn),
     nLocalServices(nLocalServicesIn),
@@ -2723,6 +2723,9 @@ CNode::CNode(NodeId idIn, ServiceFlags nLocalServicesIn, int nMyStartingHeightIn
     hashContinue = uint256();
     nStartingHeight = -1;
     filterInventoryKnown.reset();
+    nInventoryKnownElements = MIN_INVENTORY_KNOWN_ELEMENTS;
+    nInventoryKnownInserts = 0;
+    nInventoryKnownSince = 0;
     fSendMempool = false;
     fGetAddr = false;
     nNextLocalAddrSend = 0;
@@ -2796,6 +2799,31 @@ void CNode::AskFor(const CInv& inv)
     mapAskFor.insert(std::make_pair(nRequestTime, inv));
 }
 
+void CNode::UpdateInventoryKnownSize(int64_t nTimeMicros)
+{
+    if (nInventoryKnownSince == 0) {
+        nInventoryKnownSince = nTimeMicros;
+        return;
+    }
+    // Look again every INVENTORY_KNOWN_RESIZE_INTERVAL, or as soon as the
+    // filter has started forgetting what it was sized for
+    const int64_t nElapsed = nTimeMicros - nInventoryKnownSince;
+    if (nElapsed < INVENTORY_KNOWN_RESIZE_INTERVAL * 1000000 && nInventoryKnownInserts < nInventoryKnownElements)
+        return;
+
+    // An hour's worth at the rate seen since the last look
+    uint64_t nWanted = (uint64_t)nInventoryKnownInserts * (60 * 60 * 1000000LL) / std::max<int64_t>(nElapsed, 1000000);
+    nWanted = std::min<uint64_t>(std::max<uint64_t>(nWanted, MIN_INVENTORY_KNOWN_ELEMENTS), MAX_INVENTORY_KNOWN_ELEMENTS);
+    // Grow right away, but only shrink when well oversized
+    if (nWanted > nInventoryKnownElements || nWanted * 4 <= nInventoryKnownElements) {
+        LogPrint(BCLog::NET, "resizing known inventory filter from %u to %u elements, peer=%d\n", nInventoryKnownElements, nWanted, id);
+        nInventoryKnownElements = nWanted;
+        filterInventoryKnown = CRollingBloomFilter(nInventoryKnownElements, 0.000001);
+    }
+    nInventoryKnownInserts = 0;
+    nInventoryKnownSince = nTimeMicros;
+}
+
 bool CConnman::NodeFullyConnected(const CNode* pnode)
 {
     return pnode && pnode->fSuccessfullyConnected && !pnode->fDisconnect;
@@ -49,6 +49,11 @@ static const int TIMEOUT_INTERVAL = 20 * 60;
 static const int FEELER_INTERVAL = 120;
 /** The maximum number of entries in an 'inv' protocol message */
 static const unsigned int MAX_INV_SZ = 50000;
+/** Bounds on the number of transactions a peer's known inventory filter remembers */
+static const unsigned int MIN_INVENTORY_KNOWN_ELEMENTS = 5000;
+static const unsigned int MAX_INVENTORY_KNOWN_ELEMENTS = 50000;
+/** How often, in seconds, a peer's known inventory filter size is reconsidered, unless it fills up sooner */
+static const int64_t INVENTORY_KNOWN_RESIZE_INTERVAL = 10 * 60;
 /** The maximum number of new addresses to accumulate before announcing. */
 static const unsigned int MAX_ADDR_TO_SEND = 1000;
 /** Maximum length of incoming protocol messages (no message over 4 MB is currently acceptable). */
@@ -679,6 +684,11 @@ public:
 
     // inventory based relay
     CRollingBloomFilter filterInventoryKnown;
+    // Number of elements filterInventoryKnown was created for, and insertions
+    // since nInventoryKnownSince, see UpdateInventoryKnownSize. Protected by cs_inventory
+    unsigned int nInventoryKnownElements;
+    unsigned int nInventoryKnownInserts;
+    int64_t nInventoryKnownSince;
     // Set of transaction ids we still have to announce.
     // They are sorted by the mempool before relay, so the order is not important.
     std::set<uint256> setInventoryTxToSend;
@@ -815,10 +825,24 @@ public:
     {
         {
             LOCK(cs_inventory);
-            filterInventoryKnown.insert(inv.hash);
+            InsertInventoryKnown(inv.hash);
         }
     }
 
+    void InsertInventoryKnown(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_inventory)
+    {
+        filterInventoryKnown.insert(hash);
+        nInventoryKnownInserts++;
+    }
+
+    /**
+     * Size filterInventoryKnown to remember about an hour of this peer's
+     * transactions, so quiet peers do not each hold a filter sized for the
+     * busiest. Starting over with an empty filter only costs some redundant
+     * announcements. nTimeMicros is the current time.
+     */
+    void UpdateInventoryKnownSize(int64_t nTimeMicros) EXCLUSIVE_LOCKS_REQUIRED(cs_inventory);
+
     void PushInventory(const CInv& inv)
     {
         LOCK(cs_inventory);
@@ -10,6 +10,7 @@
 #include <blockencodings.h>
 #include <chainparams.h>
 #include <consensus/validation.h>
+#include <core_memusage.h>
 #include <hash.h>
 #include <init.h>
 #include <validation.h>
@@ -25,6 +26,8 @@
 #include <scheduler.h>
 #include <tinyformat.h>
 #include <txmempool.h>
+#include <txorphanpool.h>
+#include <txrelaycache.h>
 #include <ui_interface.h>
 #include <util.h>
 #include <utilmoneystr.h>
@@ -32,6 +35,7 @@
 #include <spork.h>
 
 #include <memory>
+#include <unordered_map>
 
 #if defined(NDEBUG)
 # error "TheHolyRoger cannot be compiled without assertions."
@@ -39,28 +43,14 @@
 
 std::atomic<int64_t> nTimeBestReceived(0); // Used only to inform the wallet of when we last received a block
 
-struct IteratorComparator
-{
-    template<typename I>
-    bool operator()(const I& a, const I& b) const
-    {
-        return &(*a) < &(*b);
-    }
-};
+static CTxOrphanPool g_orphan_pool;
 
-struct COrphanTx {
-    // When modifying, adapt the copy of this definition in tests/DoS_tests.
-    CTransactionRef tx;
-    NodeId fromPeer;
-    int64_t nTimeExpire;
-};
-static CCriticalSection g_cs_orphans;
-std::map<uint256, COrphanTx> mapOrphanTransactions GUARDED_BY(g_cs_orphans);
-std::map<COutPoint, std::set<std::map<uint256, COrphanTx>::iterator, IteratorComparator>> mapOrphanTransactionsByPrev GUARDED_BY(g_cs_orphans);
-void EraseOrphansFor(NodeId peer);
+CTxRelayCache g_relay_cache(DEFAULT_MAX_RELAY_CACHE_SIZE * 1000000);
 
+static CCriticalSection g_cs_orphans;
 static size_t vExtraTxnForCompactIt GUARDED_BY(g_cs_orphans) = 0;
 static std::vector<std::pair<uint256, CTransactionRef>> vExtraTxnForCompact GUARDED_BY(g_cs_orphans);
+static size_t nExtraTxnForCompactUsage GUARDED_BY(g_cs_orphans) = 0;
 
 static const uint64_t RANDOMIZER_ID_ADDRESS_RELAY = 0x3cac0035b5866b90ULL; // SHA256("main address relay")[0:8]
 
@@ -132,12 +122,6 @@ namespace {
 
     /** When our tip was last updated. */
     std::atomic<int64_t> g_last_tip_update(0);
-
-    /** Relay map, protected by cs_main. */
-    typedef std::map<uint256, CTransactionRef> MapRelay;
-    MapRelay mapRelay;
-    /** Expiration-time ordered list of (expire time, relay map entry) pairs, protected by cs_main). */
-    std::deque<std::pair<int64_t, MapRelay::iterator>> vRelayExpiration;
 } // namespace
 
 namespace {
@@ -596,7 +580,7 @@ void PeerLogicValidation::FinalizeNode(NodeId nodeid, bool& fUpdateConnectionTim
     for (const QueuedBlock& entry : state->vBlocksInFlight) {
         mapBlocksInFlight.erase(entry.hash);
     }
-    EraseOrphansFor(nodeid);
+    g_orphan_pool.EraseForPeer(nodeid);
     nPreferredDownload -= state->fPreferredDownload;
     nPeersWithValidatedDownloads -= (state->nBlocksInFlightValidHeaders != 0);
     assert(nPeersWithValidatedDownloads >= 0);
@@ -630,11 +614,6 @@ bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats) {
     return true;
 }
 
-//////////////////////////////////////////////////////////////////////////////
-//
-// mapOrphanTransactions
-//
-
 void AddToCompactExtraTransactions(const CTransactionRef& tx) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
 {
     size_t max_extra_txn = gArgs.GetArg("-blockreconstructionextratxn", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN);
@@ -642,114 +621,23 @@ void AddToCompactExtraTransactions(const CTransactionRef& tx) EXCLUSIVE_LOCKS_RE
         return;
     if (!vExtraTxnForCompact.size())
         vExtraTxnForCompact.resize(max_extra_txn);
-    vExtraTxnForCompact[vExtraTxnForCompactIt] = std::make_pair(tx->GetWitnessHash(), tx);
-    vExtraTxnForCompactIt = (vExtraTxnForCompactIt + 1) % max_extra_txn;
-}
-
-bool AddOrphanTx(const CTransactionRef& tx, NodeId peer) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
-{
-    const uint256& hash = tx->GetHash();
-    if (mapOrphanTransactions.count(hash))
-        return false;
-
-    // Ignore big transactions, to avoid a
-    // send-big-orphans memory exhaustion attack. If a peer has a legitimate
-    // large transaction with a missing parent then we assume
-    // it will rebroadcast it later, after the parent transaction(s)
-    // have been mined or received.
-    // 100 orphans, each of which is at most 99,999 bytes big is
-    // at most 10 megabytes of orphans and somewhat more byprev index (in the worst case):
-    unsigned int sz = GetTransactionWeight(*tx);
-    if (sz >= MAX_STANDARD_TX_WEIGHT)
-    {
-        LogPrint(BCLog::MEMPOOL, "ignoring large orphan tx (size: %u, hash: %s)\n", sz, hash.ToString());
-        return false;
-    }
-
-    auto ret = mapOrphanTransactions.emplace(hash, COrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME});
-    assert(ret.second);
-    for (const CTxIn& txin : tx->vin) {
-        mapOrphanTransactionsByPrev[txin.prevout].insert(ret.first);
-    }
-
-    AddToCompactExtraTransactions(tx);
-
-    LogPrint(BCLog::MEMPOOL, "stored orphan tx %s (mapsz %u outsz %u)\n", hash.ToString(),
-             mapOrphanTransactions.size(), mapOrphanTransactionsByPrev.size());
-    return true;
-}
-
-int static EraseOrphanTx(uint256 hash) EXCLUSIVE_LOCKS_REQUIRED(g_cs_orphans)
-{
-    std::map<uint256, COrphanTx>::iterator it = mapOrphanTransactions.find(hash);
-    if (it == mapOrphanTransactions.end())
-        return 0;
-    for (const CTxIn& txin : it->second.tx->vin)
-    {
-        auto itPrev = mapOrphanTransactionsByPrev.find(txin.prevout);
-        if (itPrev == mapOrphanTransactionsByPrev.end())
-            continue;
-        itPrev->second.erase(it);
-        if (itPrev->second.empty())
-            mapOrphanTransactionsByPrev.erase(itPrev);
-    }
-    mapOrphanTransactions.erase(it);
-    return 1;
-}
-
-void EraseOrphansFor(NodeId peer)
-{
-    LOCK(g_cs_orphans);
-    int nErased = 0;
-    std::map<uint256, COrphanTx>::iterator iter = mapOrphanTransactions.begin();
-    while (iter != mapOrphanTransactions.end())
-    {
-        std::map<uint256, COrphanTx>::iterator maybeErase = iter++; // increment to avoid iterator becoming invalid
-        if (maybeErase->second.fromPeer == peer)
-        {
-            nErased += EraseOrphanTx(maybeErase->second.tx->GetHash());
-        }
-    }
-    if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx from peer=%d\n", nErased, peer);
-}
-
-
-unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans)
-{
-    LOCK(g_cs_orphans);
-
-    unsigned int nEvicted = 0;
-    static int64_t nNextSweep;
-    int64_t nNow = GetTime();
-    if (nNextSweep <= nNow) {
-        // Sweep out expired orphan pool entries:
-        int nErased = 0;
-        int64_t nMinExpTime = nNow + ORPHAN_TX_EXPIRE_TIME - ORPHAN_TX_EXPIRE_INTERVAL;
-        std::map<uint256, COrphanTx>::iterator iter = mapOrphanTransactions.begin();
-        while (iter != mapOrphanTransactions.end())
-        {
-            std::map<uint256, COrphanTx>::iterator maybeErase = iter++;
-            if (maybeErase->second.nTimeExpire <= nNow) {
-                nErased += EraseOrphanTx(maybeErase->second.tx->GetHash());
-            } else {
-                nMinExpTime = std::min(maybeErase->second.nTimeExpire, nMinExpTime);
-            }
+    const size_t nUsage = RecursiveDynamicUsage(tx);
+    if (nUsage > MAX_BLOCK_RECONSTRUCTION_EXTRA_TXN_MEMORY)
+        return;
+    // Overwrite the oldest entry, and drop the ones after it while they take
+    // too much memory
+    for (size_t i = vExtraTxnForCompactIt; ; i = (i + 1) % max_extra_txn) {
+        const CTransactionRef& oldTx = vExtraTxnForCompact[i].second;
+        if (oldTx) {
+            nExtraTxnForCompactUsage -= RecursiveDynamicUsage(oldTx);
+            vExtraTxnForCompact[i] = std::make_pair(uint256(), nullptr);
         }
-        // Sweep again 5 minutes after the next entry that expires in order to batch the linear scan.
-        nNextSweep = nMinExpTime + ORPHAN_TX_EXPIRE_INTERVAL;
-        if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx due to expiration\n", nErased);
+        if (nExtraTxnForCompactUsage + nUsage <= MAX_BLOCK_RECONSTRUCTION_EXTRA_TXN_MEMORY)
+            break;
     }
-    while (mapOrphanTransactions.size() > nMaxOrphans)
-    {
-        // Evict a random orphan:
-        uint256 randomhash = GetRandHash();
-        std::map<uint256, COrphanTx>::iterator it = mapOrphanTransactions.lower_bound(randomhash);
-        if (it == mapOrphanTransactions.end())
-            it = mapOrphanTransactions.begin();
-        EraseOrphanTx(it->first);
-        ++nEvicted;
-    }
-    return nEvicted;
+    vExtraTxnForCompact[vExtraTxnForCompactIt] = std::make_pair(tx->GetWitnessHash(), tx);
+    nExtraTxnForCompactUsage += nUsage;
+    vExtraTxnForCompactIt = (vExtraTxnForCompactIt + 1) % max_extra_txn;
 }
 
 // Requires cs_main.
@@ -800,6 +688,7 @@ static bool BlockRequestAllowed(const CBlockIndex* pindex, const Consensus::Para
 PeerLogicValidation::PeerLogicValidation(CConnman* connmanIn, CScheduler &scheduler) : connman(connmanIn), m_stale_tip_check_time(0) {
     // Initialize global variables that cannot be constructed at startup.
     recentRejects.reset(new CRollingBloomFilter(120000, 0.000001));
+    g_relay_cache.SetMaxUsage((size_t)std::max((int64_t)0, gArgs.GetArg("-maxrelaycache", DEFAULT_MAX_RELAY_CACHE_SIZE)) * 1000000);
 
     const Consensus::Params& consensusParams = Params().GetConsensus();
     // Stale tip checking and peer eviction are on two different timers, but we
@@ -811,33 +700,7 @@ PeerLogicValidation::PeerLogicValidation(CConnman* connmanIn, CScheduler &schedu
 }
 
 void PeerLogicValidation::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindex, const std::vector<CTransactionRef>& vtxConflicted) {
-    LOCK(g_cs_orphans);
-
-    std::vector<uint256> vOrphanErase;
-
-    for (const CTransactionRef& ptx : pblock->vtx) {
-        const CTransaction& tx = *ptx;
-
-        // Which orphan pool entries must we evict?
-        for (const auto& txin : tx.vin) {
-            auto itByPrev = mapOrphanTransactionsByPrev.find(txin.prevout);
-            if (itByPrev == mapOrphanTransactionsByPrev.end()) continue;
-            for (auto mi = itByPrev->second.begin(); mi != itByPrev->second.end(); ++mi) {
-                const CTransaction& orphanTx = *(*mi)->second.tx;
-                const uint256& orphanHash = orphanTx.GetHash();
-                vOrphanErase.push_back(orphanHash);
-            }
-        }
-    }
-
-    // Erase orphan transactions include or precluded by this block
-    if (vOrphanErase.size()) {
-        int nErased = 0;
-        for (uint256 &orphanHash : vOrphanErase) {
-            nErased += EraseOrphanTx(orphanHash);
-        }
-        LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx included or conflicted by block\n", nErased);
-    }
+    g_orphan_pool.EraseForBlock(*pblock);
 
     g_last_tip_update = GetTime();
 }
@@ -849,12 +712,39 @@ static std::shared_ptr<const CBlockHeaderAndShortTxIDs> most_recent_compact_bloc
 static uint256 most_recent_block_hash;
 static bool fWitnessesPresentInMostRecentCompactBlock;
 
+/** A compact block relayed before we had the full block, see PreRelayCompactBlock */
+struct PreRelayedBlock {
+    //! The block once reconstructed, null until then
+    std::shared_ptr<const CBlock> block;
+    //! getblocktxn requests that arrived before the block was reconstructed
+    std::vector<std::pair<NodeId, BlockTransactionsRequest>> vPendingRequests;
+};
+/** Maximum number of pre-relayed blocks remembered */
+static const size_t MAX_PRERELAYED_BLOCKS = 3;
+/** Maximum number of getblocktxn requests kept waiting per pre-relayed block */
+static const size_t MAX_PRERELAY_PENDING_REQUESTS = 16;
+// Protected by cs_most_recent_block, oldest first
+static std::list<std::pair<uint256, PreRelayedBlock>> g_prerelayed_blocks;
+
+static std::list<std::pair<uint256, PreRelayedBlock>>::iterator FindPreRelayedBlock(const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_most_recent_block)
+{
+    for (auto it = g_prerelayed_blocks.begin(); it != g_prerelayed_blocks.end(); ++it) {
+        if (it->first == hash) return it;
+    }
+    return g_prerelayed_blocks.end();
+}
+
+static void PreRelayedBlockReconstructed(const std::shared_ptr<const CBlock>& pblock, CConnman* connman);
+
 void PeerLogicValidation::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) {
     std::shared_ptr<const CBlockHeaderAndShortTxIDs> pcmpctblock = std::make_shared<const CBlockHeaderAndShortTxIDs> (*pblock, true);
     const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
 
     LOCK(cs_main);
 
+    // A block we pre-relayed may have arrived in full rather than been reconstructed
+    PreRelayedBlockReconstructed(pblock, connman);
+
     static int nHighestFastAnnounce = 0;
     if (pindex->nHeight <= nHighestFastAnnounce)
         return;
@@ -978,10 +868,7 @@ bool static AlreadyHave(const CInv& inv) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
                 recentRejects->reset();
             }
 
-            {
-                LOCK(g_cs_orphans);
-                if (mapOrphanTransactions.count(inv.hash)) return true;
-            }
+            if (g_orphan_pool.HaveTx(inv.hash)) return true;
 
             return recentRejects->contains(inv.hash) ||
                    mempool.exists(inv.hash) ||
@@ -1201,8 +1088,7 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
     std::vector<CInv> vNotFound;
     const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
     {
-        LOCK(cs_main);
-
+        // The relay cache and the mempool have their own locks, no cs_main needed
         while (it != pfrom->vRecvGetData.end() && (it->type == MSG_TX || it->type == MSG_WITNESS_TX)) {
             if (interruptMsgProc)
                 return;
@@ -1215,10 +1101,10 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
 
             // Send stream from relay memory
             bool push = false;
-            auto mi = mapRelay.find(inv.hash);
+            CTransactionRef txRelay = g_relay_cache.Get(inv.hash);
             int nSendFlags = (inv.type == MSG_TX ? SERIALIZE_TRANSACTION_NO_WITNESS : 0);
-            if (mi != mapRelay.end()) {
-                connman->PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::TX, *mi->second));
+            if (txRelay) {
+                connman->PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::TX, *txRelay));
                 push = true;
             } else if (pfrom->timeLastMempoolReq) {
                 auto txinfo = mempool.info(inv.hash);
@@ -1233,7 +1119,7 @@ void static ProcessGetData(CNode* pfrom, const Consensus::Params& consensusParam
                 vNotFound.push_back(inv);
             }
         }
-    } // release cs_main
+    }
 
     if (it != pfrom->vRecvGetData.end() && !pfrom->fPauseSend) {
         const CInv &inv = *it;
@@ -1291,6 +1177,72 @@ inline void static SendBlockTransactions(const CBlock& block, const BlockTransac
     connman->PushMessage(pfrom, msgMaker.Make(nSendFlags, NetMsgType::BLOCKTXN, resp));
 }
 
+/**
+ * With -cmpctblockprerelay, forward a compact block that extends our tip to
+ * our high-bandwidth peers as soon as its header is valid, before we have
+ * reconstructed, let alone validated, the block. BIP 152 allows this, and
+ * peers at INVALID_CB_NO_BAN_VERSION or later do not punish us if the block
+ * turns out to be invalid. Their getblocktxn requests are answered once we
+ * have reconstructed the block ourselves.
+ */
+static void PreRelayCompactBlock(const CBlockHeaderAndShortTxIDs& cmpctblock, const CBlockIndex* pindex, NodeId from, CConnman* connman) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+    if (!gArgs.GetBoolArg("-cmpctblockprerelay", DEFAULT_CMPCTBLOCK_PRERELAY))
+        return;
+    if (pindex->pprev != chainActive.Tip() || (pindex->nStatus & BLOCK_HAVE_DATA) || IsInitialBlockDownload())
+        return;
+
+    const uint256 hashBlock(pindex->GetBlockHash());
+    {
+        LOCK(cs_most_recent_block);
+        if (FindPreRelayedBlock(hashBlock) != g_prerelayed_blocks.end())
+            return;
+        g_prerelayed_blocks.emplace_back(hashBlock, PreRelayedBlock());
+        if (g_prerelayed_blocks.size() > MAX_PRERELAYED_BLOCKS)
+            g_prerelayed_blocks.pop_front();
+    }
+
+    const bool fWitnessEnabled = IsWitnessEnabled(pindex->pprev, Params().GetConsensus());
+    const CNetMsgMaker msgMaker(PROTOCOL_VERSION);
+    connman->ForEachNode([&cmpctblock, pindex, from, fWitnessEnabled, &msgMaker, &hashBlock, connman](CNode* pnode) {
+        if (pnode->GetId() == from || pnode->nVersion < INVALID_CB_NO_BAN_VERSION || pnode->fDisconnect)
+            return;
+        ProcessBlockAvailability(pnode->GetId());
+        CNodeState &state = *State(pnode->GetId());
+        if (state.fPreferHeaderAndIDs && (!fWitnessEnabled || state.fWantsCmpctWitness) &&
+                !PeerHasHeader(&state, pindex) && PeerHasHeader(&state, pindex->pprev)) {
+            LogPrint(BCLog::CMPCTBLOCK, "pre-relaying cmpctblock %s to peer=%d\n", hashBlock.ToString(), pnode->GetId());
+            connman->PushMessage(pnode, msgMaker.Make(NetMsgType::CMPCTBLOCK, cmpctblock));
+            state.pindexBestHeaderSent = pindex;
+        }
+    });
+}
+
+/** Remember a freshly reconstructed block if we pre-relayed it, and answer the requests waiting for it */
+static void PreRelayedBlockReconstructed(const std::shared_ptr<const CBlock>& pblock, CConnman* connman)
+{
+    std::vector<std::pair<NodeId, BlockTransactionsRequest>> vRequests;
+    {
+        LOCK(cs_most_recent_block);
+        auto it = FindPreRelayedBlock(pblock->GetHash());
+        if (it == g_prerelayed_blocks.end() || it->second.block)
+            return;
+        it->second.block = pblock;
+        vRequests.swap(it->second.vPendingRequests);
+    }
+    if (vRequests.empty())
+        return;
+
+    LOCK(cs_main);
+    for (const auto& request : vRequests) {
+        connman->ForNode(request.first, [&pblock, &request, connman](CNode* pnode) {
+            SendBlockTransactions(*pblock, request.second, pnode, connman);
+            return true;
+        });
+    }
+}
+
 bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::vector<CBlockHeader>& headers, const CChainParams& chainparams, bool punish_duplicate_invalid)
 {
     const CNetMsgMaker msgMaker(pfrom->GetSendVersion());
@@ -1510,6 +1462,58 @@ bool static ProcessHeadersMessage(CNode *pfrom, CConnman *connman, const std::ve
     return true;
 }
 
+/**
+ * Reconsider the orphans of peer whose parents have arrived, until one of
+ * them is accepted or rejected, so that each call does a bounded amount of
+ * validation. Orphans that are still missing inputs stay in the pool.
+ */
+void static ProcessOrphanTx(CConnman* connman, NodeId peer, std::list<CTransactionRef>& lRemovedTxn) EXCLUSIVE_LOCKS_REQUIRED(cs_main, g_cs_orphans)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(g_cs_orphans);
+    while (CTransactionRef porphanTx = g_orphan_pool.GetTxToReconsider(peer)) {
+        const CTransaction& orphanTx = *porphanTx;
+        const uint256& orphanHash = orphanTx.GetHash();
+        bool fMissingInputs2 = false;
+        // Use a dummy CValidationState so someone can't setup nodes to counter-DoS based on orphan
+        // resolution (that is, feeding people an invalid transaction based on LegitTxX in order to get
+        // anyone relaying LegitTxX banned)
+        CValidationState stateDummy;
+
+        if (AcceptToMemoryPool(mempool, stateDummy, porphanTx, &fMissingInputs2, &lRemovedTxn, false /* bypass_limits */, 0 /* nAbsurdFee */)) {
+            LogPrint(BCLog::MEMPOOL, "   accepted orphan tx %s\n", orphanHash.ToString());
+            RelayTransaction(orphanTx, connman);
+            g_orphan_pool.AddChildrenToWorkSet(orphanTx);
+            g_orphan_pool.EraseTx(orphanHash);
+            mempool.check(pcoinsTip.get());
+            break;
+        }
+        else if (!fMissingInputs2)
+        {
+            int nDos = 0;
+            if (stateDummy.IsInvalid(nDos) && nDos > 0)
+            {
+                // Punish peer that gave us an invalid orphan tx
+                Misbehaving(peer, nDos);
+                LogPrint(BCLog::MEMPOOL, "   invalid orphan tx %s\n", orphanHash.ToString());
+            }
+            // Has inputs but not accepted to mempool
+            // Probably non-standard or insufficient fee
+            LogPrint(BCLog::MEMPOOL, "   removed orphan tx %s\n", orphanHash.ToString());
+            g_orphan_pool.EraseTx(orphanHash);
+            if (!orphanTx.HasWitness() && !stateDummy.CorruptionPossible()) {
+                // Do not use rejection cache for witness transactions or
+                // witness-stripped transactions, as they can have been malleated.
+                // See https://github.com/bitcoin/bitcoin/issues/8279 for details.
+                assert(recentRejects);
+                recentRejects->insert(orphanHash);
+            }
+            mempool.check(pcoinsTip.get());
+            break;
+        }
+    }
+}
+
 bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, int64_t nTimeReceived, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc)
 {
     LogPrint(BCLog::NET, "received: %s (%u bytes) peer=%d\n", SanitizeString(strCommand), vRecv.size(), pfrom->GetId());
@@ -2023,6 +2027,17 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             LOCK(cs_most_recent_block);
             if (most_recent_block_hash == req.blockhash)
                 recent_block = most_recent_block;
+            auto it = FindPreRelayedBlock(req.blockhash);
+            if (!recent_block && it != g_prerelayed_blocks.end()) {
+                if (it->second.block) {
+                    recent_block = it->second.block;
+                } else {
+                    // We relayed this block before having it; answer once we do
+                    if (it->second.vPendingRequests.size() < MAX_PRERELAY_PENDING_REQUESTS)
+                        it->second.vPendingRequests.emplace_back(pfrom->GetId(), req);
+                    return true;
+                }
+            }
             // Unlock cs_most_recent_block to avoid cs_main lock inversion
         }
         if (recent_block) {
@@ -2135,8 +2150,6 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             return true;
         }
 
-        std::deque<COutPoint> vWorkQueue;
-        std::vector<uint256> vEraseQueue;
         CTransactionRef ptx;
         vRecv >> ptx;
         const CTransaction& tx = *ptx;
@@ -2158,9 +2171,6 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             AcceptToMemoryPool(mempool, state, ptx, &fMissingInputs, &lRemovedTxn, false /* bypass_limits */, 0 /* nAbsurdFee */)) {
             mempool.check(pcoinsTip.get());
             RelayTransaction(tx, connman);
-            for (unsigned int i = 0; i < tx.vout.size(); i++) {
-                vWorkQueue.emplace_back(inv.hash, i);
-            }
 
             pfrom->nLastTXTime = GetTime();
 
@@ -2169,66 +2179,9 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 tx.GetHash().ToString(),
                 mempool.size(), mempool.DynamicMemoryUsage() / 1000);
 
-            // Recursively process any orphan transactions that depended on this one
-            std::set<NodeId> setMisbehaving;
-            while (!vWorkQueue.empty()) {
-                auto itByPrev = mapOrphanTransactionsByPrev.find(vWorkQueue.front());
-                vWorkQueue.pop_front();
-                if (itByPrev == mapOrphanTransactionsByPrev.end())
-                    continue;
-                for (auto mi = itByPrev->second.begin();
-                     mi != itByPrev->second.end();
-                     ++mi)
-                {
-                    const CTransactionRef& porphanTx = (*mi)->second.tx;
-                    const CTransaction& orphanTx = *porphanTx;
-                    const uint256& orphanHash = orphanTx.GetHash();
-                    NodeId fromPeer = (*mi)->second.fromPeer;
-                    bool fMissingInputs2 = false;
-                    // Use a dummy CValidationState so someone can't setup nodes to counter-DoS based on orphan
-                    // resolution (that is, feeding people an invalid transaction based on LegitTxX in order to get
-                    // anyone relaying LegitTxX banned)
-                    CValidationState stateDummy;
-
-
-                    if (setMisbehaving.count(fromPeer))
-                        continue;
-                    if (AcceptToMemoryPool(mempool, stateDummy, porphanTx, &fMissingInputs2, &lRemovedTxn, false /* bypass_limits */, 0 /* nAbsurdFee */)) {
-                        LogPrint(BCLog::MEMPOOL, "   accepted orphan tx %s\n", orphanHash.ToString());
-                        RelayTransaction(orphanTx, connman);
-                        for (unsigned int i = 0; i < orphanTx.vout.size(); i++) {
-                            vWorkQueue.emplace_back(orphanHash, i);
-                        }
-                        vEraseQueue.push_back(orphanHash);
-                    }
-                    else if (!fMissingInputs2)
-                    {
-                        int nDos = 0;
-                        if (stateDummy.IsInvalid(nDos) && nDos > 0)
-                        {
-                            // Punish peer that gave us an invalid orphan tx
-                            Misbehaving(fromPeer, nDos);
-                            setMisbehaving.insert(fromPeer);
-                            LogPrint(BCLog::MEMPOOL, "   invalid orphan tx %s\n", orphanHash.ToString());
-                        }
-                        // Has inputs but not accepted to mempool
-                        // Probably non-standard or insufficient fee
-                        LogPrint(BCLog::MEMPOOL, "   removed orphan tx %s\n", orphanHash.ToString());
-                        vEraseQueue.push_back(orphanHash);
-                        if (!orphanTx.HasWitness() && !stateDummy.CorruptionPossible()) {
-                            // Do not use rejection cache for witness transactions or
-                            // witness-stripped transactions, as they can have been malleated.
-                            // See https://github.com/bitcoin/bitcoin/issues/8279 for details.
-                            assert(recentRejects);
-                            recentRejects->insert(orphanHash);
-                        }
-                    }
-                    mempool.check(pcoinsTip.get());
-                }
-            }
-
-            for (uint256 hash : vEraseQueue)
-                EraseOrphanTx(hash);
+            // Orphans that depended on this one are reconsidered one at a
+            // time, when the message handler gets to the peer that sent them.
+            g_orphan_pool.AddChildrenToWorkSet(tx);
         }
         else if (fMissingInputs)
         {
@@ -2246,11 +2199,14 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                     pfrom->AddInventoryKnown(_inv);
                     if (!AlreadyHave(_inv)) pfrom->AskFor(_inv);
                 }
-                AddOrphanTx(ptx, pfrom->GetId());
+                if (g_orphan_pool.AddTx(ptx, pfrom->GetId())) {
+                    AddToCompactExtraTransactions(ptx);
+                }
 
-                // DoS prevention: do not allow mapOrphanTransactions to grow unbounded
+                // DoS prevention: do not allow the orphan pool to grow unbounded
                 unsigned int nMaxOrphanTx = (unsigned int)std::max((int64_t)0, gArgs.GetArg("-maxorphantx", DEFAULT_MAX_ORPHAN_TRANSACTIONS));
-                unsigned int nEvicted = LimitOrphanTxSize(nMaxOrphanTx);
+                size_t nMaxOrphanBytes = (size_t)std::max((int64_t)0, gArgs.GetArg("-maxorphanmem", DEFAULT_MAX_ORPHAN_MEMORY)) * 1000000;
+                unsigned int nEvicted = g_orphan_pool.LimitOrphans(nMaxOrphanTx, nMaxOrphanBytes);
                 if (nEvicted > 0) {
                     LogPrint(BCLog::MEMPOOL, "mapOrphan overflow, removed %u tx\n", nEvicted);
                 }
@@ -2386,6 +2342,8 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         if (pindex->nStatus & BLOCK_HAVE_DATA) // Nothing to do here
             return true;
 
+        PreRelayCompactBlock(cmpctblock, pindex, pfrom->GetId(), connman);
+
         if (pindex->nChainWork <= chainActive.Tip()->nChainWork || // We know something better
                 pindex->nTx != 0) { // We had this block at some point, but pruned it
             if (fAlreadyInFlight) {
@@ -2502,6 +2460,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         if (fBlockReconstructed) {
             // If we got here, we were able to optimistically reconstruct a
             // block that is in flight from some other peer.
+            PreRelayedBlockReconstructed(pblock, connman);
             {
                 LOCK(cs_main);
                 mapBlockSource.emplace(pblock->GetHash(), std::make_pair(pfrom->GetId(), false));
@@ -2593,6 +2552,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
             }
         } // Don't hold cs_main when we call into ProcessNewBlock
         if (fBlockRead) {
+            PreRelayedBlockReconstructed(pblock, connman);
             bool fNewBlock = false;
             // Since we requested this block (it was in mapBlocksInFlight), force it to be processed,
             // even if it would not be a candidate for new tip (missing previous block, chain not long enough, etc)
@@ -2923,11 +2883,21 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
     if (!pfrom->vRecvGetData.empty())
         ProcessGetData(pfrom, chainparams.GetConsensus(), connman, interruptMsgProc);
 
+    if (g_orphan_pool.HaveTxToReconsider(pfrom->GetId())) {
+        std::list<CTransactionRef> lRemovedTxn;
+        LOCK2(cs_main, g_cs_orphans);
+        ProcessOrphanTx(connman, pfrom->GetId(), lRemovedTxn);
+        for (const CTransactionRef& removedTx : lRemovedTxn)
+            AddToCompactExtraTransactions(removedTx);
+    }
+
     if (pfrom->fDisconnect)
         return false;
 
     // this maintains the order of responses
     if (!pfrom->vRecvGetData.empty()) return true;
+    // and so does reconsidering this peer's orphans before its next message
+    if (g_orphan_pool.HaveTxToReconsider(pfrom->GetId())) return true;
 
     // Don't bother if send buffer is too full to respond anyway
     if (pfrom->fPauseSend)
@@ -3157,22 +3127,39 @@ void PeerLogicValidation::CheckForStaleTipAndEvictPeers(const Consensus::Params
     }
 }
 
-class CompareInvMempoolOrder
+static CCriticalSection cs_inv_relay_order;
+
+/** Get the relay order keys of the transactions in setInv that are still in the mempool */
+static void GetInvRelayKeys(const std::set<uint256>& setInv, int64_t nNow, std::vector<std::pair<uint256, DepthAndScore>>& vKeys)
 {
-    CTxMemPool *mp;
-public:
-    explicit CompareInvMempoolOrder(CTxMemPool *_mempool)
-    {
-        mp = _mempool;
+    vKeys.reserve(setInv.size());
+    std::vector<uint256> vMissing;
+    LOCK(cs_inv_relay_order);
+    // Depth and score of the transactions announced recently, shared by all
+    // peers, so that each mempool entry is looked up about once per
+    // INVENTORY_BROADCAST_INTERVAL instead of once per comparison for every
+    // peer. Not a global, as the hasher is salted on construction.
+    static std::unordered_map<uint256, DepthAndScore, SaltedTxidHasher> mapInvRelayKeys;
+    static int64_t nInvRelayKeysTime = 0;
+    if (nNow - nInvRelayKeysTime > INVENTORY_BROADCAST_INTERVAL * 1000000) {
+        mapInvRelayKeys.clear();
+        nInvRelayKeysTime = nNow;
+    }
+    for (const uint256& hash : setInv) {
+        auto it = mapInvRelayKeys.find(hash);
+        if (it != mapInvRelayKeys.end()) {
+            vKeys.emplace_back(hash, it->second);
+        } else {
+            vMissing.push_back(hash);
+        }
     }
-
-    bool operator()(std::set<uint256>::iterator a, std::set<uint256>::iterator b)
-    {
-        /* As std::make_heap produces a max-heap, we want the entries with the
-         * fewest ancestors/highest fee to sort later. */
-        return mp->CompareDepthAndScore(*b, *a);
+    if (vMissing.empty()) return;
+    const size_t nFound = vKeys.size();
+    mempool.GetDepthAndScore(vMissing, vKeys);
+    for (size_t i = nFound; i < vKeys.size(); i++) {
+        mapInvRelayKeys.insert(vKeys[i]);
     }
-};
+}
 
 bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptMsgProc)
 {
@@ -3497,7 +3484,7 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
                     if (pto->pfilter) {
                         if (!pto->pfilter->IsRelevantAndUpdate(*txinfo.tx)) continue;
                     }
-                    pto->filterInventoryKnown.insert(hash);
+                    pto->InsertInventoryKnown(hash);
                     vInv.push_back(inv);
                     if (vInv.size() == MAX_INV_SZ) {
                         connman->PushMessage(pto, msgMaker.Make(NetMsgType::INV, vInv));
@@ -3509,11 +3496,15 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
 
             // Determine transactions to relay
             if (fSendTrickle) {
-                // Produce a vector with all candidates for sending
-                std::vector<std::set<uint256>::iterator> vInvTx;
-                vInvTx.reserve(pto->setInventoryTxToSend.size());
-                for (std::set<uint256>::iterator it = pto->setInventoryTxToSend.begin(); it != pto->setInventoryTxToSend.end(); it++) {
-                    vInvTx.push_back(it);
+                pto->UpdateInventoryKnownSize(nNow);
+                // Produce a vector with all candidates for sending that are still in the mempool
+                std::vector<std::pair<uint256, DepthAndScore>> vInvTx;
+                GetInvRelayKeys(pto->setInventoryTxToSend, nNow, vInvTx);
+                if (vInvTx.size() < pto->setInventoryTxToSend.size()) {
+                    // Drop what left the mempool, it will never be sent
+                    std::set<uint256> setStillInMempool;
+                    for (const auto& key : vInvTx) setStillInMempool.insert(key.first);
+                    pto->setInventoryTxToSend.swap(setStillInMempool);
                 }
                 CAmount filterrate = 0;
                 {
@@ -3522,7 +3513,11 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
                 }
                 // Topologically and fee-rate sort the inventory we send for privacy and priority reasons.
                 // A heap is used so that not all items need sorting if only a few are being sent.
-                CompareInvMempoolOrder compareInvMempoolOrder(&mempool);
+                // As std::make_heap produces a max-heap, we want the entries with the
+                // fewest ancestors/highest fee to sort later.
+                auto compareInvMempoolOrder = [](const std::pair<uint256, DepthAndScore>& a, const std::pair<uint256, DepthAndScore>& b) {
+                    return CompareDepthAndScoreKeys()(b, a);
+                };
                 std::make_heap(vInvTx.begin(), vInvTx.end(), compareInvMempoolOrder);
                 // No reason to drain out at many times the network's capacity,
                 // especially since we have many peers and some will draw much shorter delays.
@@ -3531,11 +3526,10 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
                 while (!vInvTx.empty() && nRelayedTransactions < INVENTORY_BROADCAST_MAX) {
                     // Fetch the top element from the heap
                     std::pop_heap(vInvTx.begin(), vInvTx.end(), compareInvMempoolOrder);
-                    std::set<uint256>::iterator it = vInvTx.back();
+                    uint256 hash = vInvTx.back().first;
                     vInvTx.pop_back();
-                    uint256 hash = *it;
                     // Remove it from the to-be-sent set
-                    pto->setInventoryTxToSend.erase(it);
+                    pto->setInventoryTxToSend.erase(hash);
                     // Check if not in the filter already
                     if (pto->filterInventoryKnown.contains(hash)) {
                         continue;
@@ -3552,24 +3546,12 @@ bool PeerLogicValidation::SendMessages(CNode* pto, std::atomic<bool>& interruptM
                     // Send
                     vInv.push_back(CInv(MSG_TX, hash));
                     nRelayedTransactions++;
-                    {
-                        // Expire old relay messages
-                        while (!vRelayExpiration.empty() && vRelayExpiration.front().first < nNow)
-                        {
-                            mapRelay.erase(vRelayExpiration.front().second);
-                            vRelayExpiration.pop_front();
-                        }
-
-                        auto ret = mapRelay.insert(std::make_pair(hash, std::move(txinfo.tx)));
-                        if (ret.second) {
-                            vRelayExpiration.push_back(std::make_pair(nNow + 15 * 60 * 1000000, ret.first));
-                        }
-                    }
+                    g_relay_cache.Add(txinfo.tx, nNow);
                     if (vInv.size() == MAX_INV_SZ) {
                         connman->PushMessage(pto, msgMaker.Make(NetMsgType::INV, vInv));
                         vInv.clear();
                     }
-                    pto->filterInventoryKnown.insert(hash);
+                    pto->InsertInventoryKnown(hash);
                 }
             }
         }
@@ -3720,8 +3702,5 @@ class CNetProcessingCleanup
 public:
     CNetProcessingCleanup() {}
     ~CNetProcessingCleanup() {
-        // orphan transactions
-        mapOrphanTransactions.clear();
-        mapOrphanTransactionsByPrev.clear();
     }
 } instance_of_cnetprocessingcleanup;
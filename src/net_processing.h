@@ -7,17 +7,23 @@
 #define BITCOIN_NET_PROCESSING_H
 
 #include <net.h>
+#include <txrelaycache.h>
 #include <validationinterface.h>
 #include <consensus/params.h>
 
 /** Default for -maxorphantx, maximum number of orphan transactions kept in memory */
 static const unsigned int DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
-/** Expiration time for orphan transactions in seconds */
-static const int64_t ORPHAN_TX_EXPIRE_TIME = 20 * 60;
-/** Minimum time between orphan transactions expire time checks in seconds */
-static const int64_t ORPHAN_TX_EXPIRE_INTERVAL = 5 * 60;
+/** Default for -maxorphanmem, maximum megabytes of orphan transactions kept in memory */
+static const unsigned int DEFAULT_MAX_ORPHAN_MEMORY = 5;
 /** Default number of orphan+recently-replaced txn to keep around for block reconstruction */
-static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
+static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 1000;
+/** Maximum memory, in bytes, taken by the txn kept around for block reconstruction */
+static const size_t MAX_BLOCK_RECONSTRUCTION_EXTRA_TXN_MEMORY = 20 * 1000 * 1000;
+/** Default for -cmpctblockprerelay, forwarding compact blocks to high-bandwidth peers before reconstructing them */
+static const bool DEFAULT_CMPCTBLOCK_PRERELAY = false;
+
+/** Transactions recently announced to peers, to answer their getdata with */
+extern CTxRelayCache g_relay_cache;
 /** Headers download timeout expressed in microseconds
  *  Timeout = base + per_header * (expected number of headers) */
 static constexpr int64_t HEADERS_DOWNLOAD_TIMEOUT_BASE = 15 * 60 * 1000000; // 15 minutes
@@ -46,6 +52,7 @@ public:
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
     void BlockChecked(const CBlock& block, const CValidationState& state) override;
     void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock) override;
+    std::string GetSubscriberName() const override { return "peerlogic"; }
 
 
     void InitializeNode(CNode* pnode) override;
@@ -98,6 +98,12 @@ private:
 
     double decay;
 
+    // The moving averages above are stored divided by multiplier, so that
+    // decaying them all only has to scale multiplier down. Once it gets
+    // small it is folded back into the stored values by Normalize().
+    double multiplier;
+    static constexpr double MIN_MULTIPLIER = 1e-20;
+
     // Resolution (# of blocks) with which confirmations are tracked
     unsigned int scale;
 
@@ -110,6 +116,8 @@ private:
 
     void resizeInMemoryCounters(size_t newbuckets);
 
+    void Normalize();
+
 public:
     /**
      * Create new TxConfirmStats. This is called by BlockPolicyEstimator's
@@ -140,7 +148,7 @@ public:
                   unsigned int bucketIndex, bool inBlock);
 
     /** Update our estimates by decaying our historical moving average and updating
-        with the data gathered from the current block */
+        with the data gathered from the current block. Amortized O(1). */
     void UpdateMovingAverages();
 
     /**
@@ -175,7 +183,7 @@ public:
 TxConfirmStats::TxConfirmStats(const std::vector<double>& defaultBuckets,
                                 const std::map<double, unsigned int>& defaultBucketMap,
                                unsigned int maxPeriods, double _decay, unsigned int _scale)
-    : buckets(defaultBuckets), bucketMap(defaultBucketMap)
+    : buckets(defaultBuckets), bucketMap(defaultBucketMap), multiplier(1)
 {
     decay = _decay;
     assert(_scale != 0 && "_scale must be non-zero");
@@ -222,22 +230,31 @@ void TxConfirmStats::Record(int blocksToConfirm, double val)
     int periodsToConfirm = (blocksToConfirm + scale - 1)/scale;
     unsigned int bucketindex = bucketMap.lower_bound(val)->second;
     for (size_t i = periodsToConfirm; i <= confAvg.size(); i++) {
-        confAvg[i - 1][bucketindex]++;
+        confAvg[i - 1][bucketindex] += 1 / multiplier;
     }
-    txCtAvg[bucketindex]++;
-    avg[bucketindex] += val;
+    txCtAvg[bucketindex] += 1 / multiplier;
+    avg[bucketindex] += val / multiplier;
 }
 
 void TxConfirmStats::UpdateMovingAverages()
 {
-    for (unsigned int j = 0; j < buckets.size(); j++) {
+    multiplier *= decay;
+    if (multiplier < MIN_MULTIPLIER) {
+        Normalize();
+    }
+}
+
+void TxConfirmStats::Normalize()
+{
+    for (unsigned int j = 0; j < avg.size(); j++) {
         for (unsigned int i = 0; i < confAvg.size(); i++)
-            confAvg[i][j] = confAvg[i][j] * decay;
+            confAvg[i][j] = confAvg[i][j] * multiplier;
         for (unsigned int i = 0; i < failAvg.size(); i++)
-            failAvg[i][j] = failAvg[i][j] * decay;
-        avg[j] = avg[j] * decay;
-        txCtAvg[j] = txCtAvg[j] * decay;
+            failAvg[i][j] = failAvg[i][j] * multiplier;
+        avg[j] = avg[j] * multiplier;
+        txCtAvg[j] = txCtAvg[j] * multiplier;
     }
+    multiplier = 1;
 }
 
 // returns -1 on error conditions
@@ -285,9 +302,9 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
             newBucketRange = false;
         }
         curFarBucket = bucket;
-        nConf += confAvg[periodTarget - 1][bucket];
-        totalNum += txCtAvg[bucket];
-        failNum += failAvg[periodTarget - 1][bucket];
+        nConf += confAvg[periodTarget - 1][bucket] * multiplier;
+        totalNum += txCtAvg[bucket] * multiplier;
+        failNum += failAvg[periodTarget - 1][bucket] * multiplier;
         for (unsigned int confct = confTarget; confct < GetMaxConfirms(); confct++)
             extraNum += unconfTxs[(nBlockHeight - confct)%bins][bucket];
         extraNum += oldUnconfTxs[bucket];
@@ -345,13 +362,13 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     unsigned int minBucket = std::min(bestNearBucket, bestFarBucket);
     unsigned int maxBucket = std::max(bestNearBucket, bestFarBucket);
     for (unsigned int j = minBucket; j <= maxBucket; j++) {
-        txSum += txCtAvg[j];
+        txSum += txCtAvg[j] * multiplier;
     }
     if (foundAnswer && txSum != 0) {
         txSum = txSum / 2;
         for (unsigned int j = minBucket; j <= maxBucket; j++) {
-            if (txCtAvg[j] < txSum)
-                txSum -= txCtAvg[j];
+            if (txCtAvg[j] * multiplier < txSum)
+                txSum -= txCtAvg[j] * multiplier;
             else { // we're in the right bucket
                 median = avg[j] / txCtAvg[j];
                 break;
@@ -393,14 +410,31 @@ double TxConfirmStats::EstimateMedianVal(int confTarget, double sufficientTxVal,
     return median;
 }
 
+static std::vector<double> Scaled(const std::vector<double>& values, double multiplier)
+{
+    std::vector<double> ret(values);
+    for (double& value : ret) {
+        value *= multiplier;
+    }
+    return ret;
+}
+
 void TxConfirmStats::Write(CAutoFile& fileout) const
 {
     fileout << decay;
     fileout << scale;
-    fileout << avg;
-    fileout << txCtAvg;
-    fileout << confAvg;
-    fileout << failAvg;
+    fileout << Scaled(avg, multiplier);
+    fileout << Scaled(txCtAvg, multiplier);
+    std::vector<std::vector<double>> scaledAvg;
+    for (const std::vector<double>& values : confAvg) {
+        scaledAvg.push_back(Scaled(values, multiplier));
+    }
+    fileout << scaledAvg;
+    scaledAvg.clear();
+    for (const std::vector<double>& values : failAvg) {
+        scaledAvg.push_back(Scaled(values, multiplier));
+    }
+    fileout << scaledAvg;
 }
 
 void TxConfirmStats::Read(CAutoFile& filein, int nFileVersion, size_t numBuckets)
@@ -451,6 +485,8 @@ void TxConfirmStats::Read(CAutoFile& filein, int nFileVersion, size_t numBuckets
         }
     }
 
+    multiplier = 1;
+
     // Resize the current block variables which aren't stored in the data file
     // to match the number of confirms and buckets
     resizeInMemoryCounters(numBuckets);
@@ -499,7 +535,7 @@ void TxConfirmStats::removeTx(unsigned int entryHeight, unsigned int nBestSeenHe
         assert(scale != 0);
         unsigned int periodsAgo = blocksAgo / scale;
         for (size_t i = 0; i < periodsAgo && i < failAvg.size(); i++) {
-            failAvg[i][bucketindex]++;
+            failAvg[i][bucketindex] += 1 / multiplier;
         }
     }
 }
@@ -514,6 +550,11 @@ bool CBlockPolicyEstimator::removeTx(uint256 hash, bool inBlock)
     LOCK(cs_feeEstimator);
     std::map<uint256, TxStatsInfo>::iterator pos = mapMemPoolTxs.find(hash);
     if (pos != mapMemPoolTxs.end()) {
+        // Transactions that entered the mempool since the last block are not
+        // counted by any estimate yet.
+        if (pos->second.blockHeight < nBestSeenHeight) {
+            mapSmartFeeCache.clear();
+        }
         feeStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         shortStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
         longStats->removeTx(pos->second.blockHeight, nBestSeenHeight, pos->second.bucketIndex, inBlock);
@@ -525,7 +566,7 @@ bool CBlockPolicyEstimator::removeTx(uint256 hash, bool inBlock)
 }
 
 CBlockPolicyEstimator::CBlockPolicyEstimator()
-    : nBestSeenHeight(0), firstRecordedHeight(0), historicalFirst(0), historicalBest(0), trackedTxs(0), untrackedTxs(0)
+    : nBestSeenHeight(0), firstRecordedHeight(0), historicalFirst(0), historicalBest(0), nWrittenHeight(0), trackedTxs(0), untrackedTxs(0)
 {
     static_assert(MIN_BUCKET_FEERATE > 0, "Min feerate must be nonzero");
     size_t bucketIndex = 0;
@@ -629,6 +670,7 @@ void CBlockPolicyEstimator::processBlock(unsigned int nBlockHeight,
     // calls to removeTx (via processBlockTx) correctly calculate age
     // of unconfirmed txs to remove from tracking.
     nBestSeenHeight = nBlockHeight;
+    mapSmartFeeCache.clear();
 
     // Update unconfirmed circular buffer
     feeStats->ClearCurrent(nBlockHeight);
@@ -821,6 +863,24 @@ CFeeRate CBlockPolicyEstimator::estimateSmartFee(int confTarget, FeeCalculation
 {
     LOCK(cs_feeEstimator);
 
+    const std::pair<int, bool> key(confTarget, conservative);
+    auto cached = mapSmartFeeCache.find(key);
+    if (cached != mapSmartFeeCache.end()) {
+        if (feeCalc) *feeCalc = cached->second.second;
+        return cached->second.first;
+    }
+
+    FeeCalculation calc;
+    const CFeeRate feeRate = estimateSmartFeeUncached(confTarget, &calc, conservative);
+    mapSmartFeeCache.emplace(key, std::make_pair(feeRate, calc));
+    if (feeCalc) *feeCalc = calc;
+    return feeRate;
+}
+
+CFeeRate CBlockPolicyEstimator::estimateSmartFeeUncached(int confTarget, FeeCalculation *feeCalc, bool conservative) const
+{
+    AssertLockHeld(cs_feeEstimator);
+
     if (feeCalc) {
         feeCalc->desiredTarget = confTarget;
         feeCalc->returnedTarget = confTarget;
@@ -913,6 +973,7 @@ bool CBlockPolicyEstimator::Write(CAutoFile& fileout) const
         feeStats->Write(fileout);
         shortStats->Write(fileout);
         longStats->Write(fileout);
+        nWrittenHeight = nBestSeenHeight;
     }
     catch (const std::exception&) {
         LogPrintf("CBlockPolicyEstimator::Write(): unable to write policy estimator data (non-fatal)\n");
@@ -921,6 +982,12 @@ bool CBlockPolicyEstimator::Write(CAutoFile& fileout) const
     return true;
 }
 
+bool CBlockPolicyEstimator::IsDirty() const
+{
+    LOCK(cs_feeEstimator);
+    return nBestSeenHeight != nWrittenHeight;
+}
+
 bool CBlockPolicyEstimator::Read(CAutoFile& filein)
 {
     try {
@@ -972,6 +1039,8 @@ bool CBlockPolicyEstimator::Read(CAutoFile& filein)
             nBestSeenHeight = nFileBestSeenHeight;
             historicalFirst = nFileHistoricalFirst;
             historicalBest = nFileHistoricalBest;
+            nWrittenHeight = nBestSeenHeight;
+            mapSmartFeeCache.clear();
         }
     }
     catch (const std::exception& e) {
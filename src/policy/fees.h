@@ -220,6 +220,9 @@ public:
     /** Write estimation data to a file */
     bool Write(CAutoFile& fileout) const;
 
+    /** Whether a block has been processed since estimation data was last written */
+    bool IsDirty() const;
+
     /** Read estimation data from a file */
     bool Read(CAutoFile& filein);
 
@@ -234,6 +237,8 @@ private:
     unsigned int firstRecordedHeight;
     unsigned int historicalFirst;
     unsigned int historicalBest;
+    //! nBestSeenHeight as of the last Write
+    mutable unsigned int nWrittenHeight;
 
     struct TxStatsInfo
     {
@@ -258,9 +263,20 @@ private:
 
     mutable CCriticalSection cs_feeEstimator;
 
+    /**
+     * estimateSmartFee answers by (confTarget, conservative). They are cleared
+     * whenever a block is processed or a transaction which counts towards the
+     * estimates is removed, so a cached answer is always the one that would be
+     * calculated.
+     */
+    mutable std::map<std::pair<int, bool>, std::pair<CFeeRate, FeeCalculation>> mapSmartFeeCache;
+
     /** Process a transaction confirmed in a block*/
     bool processBlockTx(unsigned int nBlockHeight, const CTxMemPoolEntry* entry);
 
+    /** estimateSmartFee without the cache */
+    CFeeRate estimateSmartFeeUncached(int confTarget, FeeCalculation *feeCalc, bool conservative) const;
+
     /** Helper for estimateSmartFee */
     double estimateCombinedFee(unsigned int confTarget, double successThreshold, bool checkShorterHorizon, EstimationResult *result) const;
     /** Helper for estimateSmartFee */
@@ -10,11 +10,14 @@
 #include <primitives/transaction.h>
 #include <validation.h>
 #include <httpserver.h>
+#include <index/txindex.h>
 #include <rpc/blockchain.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <streams.h>
 #include <sync.h>
 #include <txmempool.h>
+#include <util.h>
 #include <utilstrencodings.h>
 #include <version.h>
 
@@ -23,6 +26,8 @@
 #include <univalue.h>
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const long MAX_REST_HEADERS_RESULTS = 20000;
+static const long MAX_REST_BLOCKRANGE_RESULTS = 100;
 
 enum RetFormat {
     RF_UNDEF,
@@ -135,7 +140,7 @@ static bool rest_headers(HTTPRequest* req,
         return RESTERR(req, HTTP_BAD_REQUEST, "No header count specified. Use /rest/headers/<count>/<hash>.<ext>.");
 
     long count = strtol(path[0].c_str(), nullptr, 10);
-    if (count < 1 || count > 2000)
+    if (count < 1 || count > MAX_REST_HEADERS_RESULTS)
         return RESTERR(req, HTTP_BAD_REQUEST, "Header count out of range: " + path[0]);
 
     std::string hashStr = path[1];
@@ -195,6 +200,30 @@ static bool rest_headers(HTTPRequest* req,
     }
 }
 
+/** Send what a JSONStreamWriter writes as a chunked reply to req */
+static JSONStreamWriter::Sink ReplyChunkSink(HTTPRequest* req)
+{
+    return [req](const std::string& strChunk) {
+        req->WriteReplyChunk(HTTP_OK, strChunk);
+    };
+}
+
+/** Read the block of pindex as REST replies serialize it: as it is stored,
+ *  unless -rpcserialversion asks for blocks without witness data */
+static bool ReadRESTBlockData(const CBlockIndex* pindex, std::vector<uint8_t>& blockData)
+{
+    AssertLockHeld(cs_main);
+    if (!RPCSerializationFlags())
+        return ReadRawBlockFromDisk(blockData, pindex->GetBlockPos(), Params().MessageStart());
+
+    CBlock block;
+    if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus()))
+        return false;
+    blockData.clear();
+    CVectorWriter(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), blockData, 0) << block;
+    return true;
+}
+
 static bool rest_block(HTTPRequest* req,
                        const std::string& strURIPart,
                        bool showTxDetails)
@@ -209,6 +238,7 @@ static bool rest_block(HTTPRequest* req,
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
     CBlock block;
+    std::vector<uint8_t> blockData;
     CBlockIndex* pblockindex = nullptr;
     {
         LOCK(cs_main);
@@ -219,23 +249,25 @@ static bool rest_block(HTTPRequest* req,
         if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
-        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+        // The binary formats are sent without deserializing the block
+        if (rf == RF_BINARY || rf == RF_HEX) {
+            if (!ReadRESTBlockData(pblockindex, blockData))
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        } else if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) {
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        }
     }
 
-    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ssBlock << block;
-
     switch (rf) {
     case RF_BINARY: {
-        std::string binaryBlock = ssBlock.str();
+        std::string binaryBlock(blockData.begin(), blockData.end());
         req->WriteHeader("Content-Type", "application/octet-stream");
         req->WriteReply(HTTP_OK, binaryBlock);
         return true;
     }
 
     case RF_HEX: {
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
+        std::string strHex = HexStr(blockData) + "\n";
         req->WriteHeader("Content-Type", "text/plain");
         req->WriteReply(HTTP_OK, strHex);
         return true;
@@ -245,10 +277,17 @@ static bool rest_block(HTTPRequest* req,
         UniValue objBlock;
         {
             LOCK(cs_main);
-            objBlock = blockToJSON(block, pblockindex, showTxDetails);
+            objBlock = blockToJSON(block, pblockindex, false);
         }
-        std::string strJSON = objBlock.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
+        if (showTxDetails) {
+            JSONStreamWriter writer(ReplyChunkSink(req));
+            blockToJSONStream(block, objBlock, writer);
+            writer.Finish();
+            req->WriteReplyEnd();
+            return true;
+        }
+        std::string strJSON = objBlock.write() + "\n";
         req->WriteReply(HTTP_OK, strJSON);
         return true;
     }
@@ -269,6 +308,104 @@ static bool rest_block_notxdetails(HTTPRequest* req, const std::string& strURIPa
     return rest_block(req, strURIPart, false);
 }
 
+static bool rest_blockrange(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "No block count specified. Use /rest/blockrange/<height>/<count>.<ext>.");
+
+    int32_t nStart;
+    if (!ParseInt32(path[0], &nStart) || nStart < 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid height: " + path[0]);
+
+    long count = strtol(path[1].c_str(), nullptr, 10);
+    if (count < 1 || count > MAX_REST_BLOCKRANGE_RESULTS)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Block count out of range: " + path[1]);
+
+    std::string strContentType;
+    switch (rf) {
+    case RF_BINARY: strContentType = "application/octet-stream"; break;
+    case RF_HEX: strContentType = "text/plain"; break;
+    case RF_JSON: strContentType = "application/json"; break;
+    default:
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+
+    // The blocks of the active chain at the time of the request, up to its tip
+    std::vector<const CBlockIndex*> blocks;
+    {
+        LOCK(cs_main);
+        if (nStart > chainActive.Height())
+            return RESTERR(req, HTTP_NOT_FOUND, "Block height out of range: " + path[0]);
+        for (const CBlockIndex* pindex = chainActive[nStart]; pindex != nullptr; pindex = chainActive.Next(pindex)) {
+            blocks.push_back(pindex);
+            if (blocks.size() == (unsigned long)count)
+                break;
+        }
+    }
+
+    bool fStarted = false;
+    auto sendChunk = [req, &fStarted, &strContentType](const std::string& strChunk) {
+        if (!fStarted)
+            req->WriteHeader("Content-Type", strContentType);
+        req->WriteReplyChunk(HTTP_OK, strChunk);
+        fStarted = true;
+    };
+
+    // Each block is read under its own short cs_main lock and sent on its own:
+    // concatenated in binary, one per line in hex, as array elements (without
+    // transaction details) in JSON.
+    JSONStreamWriter writer(sendChunk);
+    if (rf == RF_JSON)
+        writer.BeginArray();
+    std::vector<uint8_t> blockData;
+    for (const CBlockIndex* pindex : blocks) {
+        UniValue objBlock;
+        bool fRead;
+        {
+            LOCK(cs_main);
+            if (fHavePruned && !(pindex->nStatus & BLOCK_HAVE_DATA) && pindex->nTx > 0) {
+                fRead = false;
+            } else if (rf == RF_JSON) {
+                CBlock block;
+                fRead = ReadBlockFromDisk(block, pindex, Params().GetConsensus());
+                if (fRead)
+                    objBlock = blockToJSON(block, pindex, false);
+            } else {
+                fRead = ReadRESTBlockData(pindex, blockData);
+            }
+        }
+        if (!fRead) {
+            const std::string strHash = pindex->GetBlockHash().GetHex();
+            if (!fStarted)
+                return RESTERR(req, HTTP_NOT_FOUND, strHash + " not available");
+            // Too late to report an error, cut the reply short
+            LogPrintf("REST blockrange: %s not available, reply truncated\n", strHash);
+            req->WriteReplyEnd();
+            return false;
+        }
+
+        if (rf == RF_BINARY)
+            sendChunk(std::string(blockData.begin(), blockData.end()));
+        else if (rf == RF_HEX)
+            sendChunk(HexStr(blockData) + "\n");
+        else
+            writer.Value(objBlock);
+    }
+    if (rf == RF_JSON) {
+        writer.EndArray();
+        writer.Finish();
+    }
+    req->WriteReplyEnd();
+    return true;
+}
+
 // A bit of a hack - dependency on a function defined in rpc/blockchain.cpp
 UniValue getblockchaininfo(const JSONRPCRequest& request);
 
@@ -326,11 +463,11 @@ static bool rest_mempool_contents(HTTPRequest* req, const std::string& strURIPar
 
     switch (rf) {
     case RF_JSON: {
-        UniValue mempoolObject = mempoolToJSON(true);
-
-        std::string strJSON = mempoolObject.write() + "\n";
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        JSONStreamWriter writer(ReplyChunkSink(req));
+        mempoolToJSONStream(writer);
+        writer.Finish();
+        req->WriteReplyEnd();
         return true;
     }
     default: {
@@ -350,6 +487,9 @@ static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
+    if (g_txindex)
+        g_txindex->BlockUntilSyncedToCurrentChain();
+
     CTransactionRef tx;
     uint256 hashBlock = uint256();
     if (!GetTransaction(hash, tx, Params().GetConsensus(), hashBlock, true))
@@ -577,6 +717,7 @@ static const struct {
       {"/rest/tx/", rest_tx},
       {"/rest/block/notxdetails/", rest_block_notxdetails},
       {"/rest/block/", rest_block_extended},
+      {"/rest/blockrange/", rest_blockrange},
       {"/rest/chaininfo", rest_chaininfo},
       {"/rest/mempool/info", rest_mempool_info},
       {"/rest/mempool/contents", rest_mempool_contents},
@@ -6,16 +6,22 @@
 #include <rpc/blockchain.h>
 
 #include <amount.h>
+#include <base58.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <coins.h>
+#include <coinstats.h>
 #include <consensus/validation.h>
 #include <validation.h>
 #include <core_io.h>
+#include <index/addrindex.h>
+#include <net_processing.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
 #include <primitives/transaction.h>
+#include <script/standard.h>
+#include <rpc/jsonstream.h>
 #include <rpc/server.h>
 #include <streams.h>
 #include <sync.h>
@@ -23,6 +29,7 @@
 #include <txmempool.h>
 #include <util.h>
 #include <utilstrencodings.h>
+#include <utxosnapshot.h>
 #include <hash.h>
 #include <validationinterface.h>
 #include <warnings.h>
@@ -161,6 +168,28 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
     return result;
 }
 
+void blockToJSONStream(const CBlock& block, const UniValue& blockInfo, JSONStreamWriter& writer)
+{
+    const std::vector<std::string>& keys = blockInfo.getKeys();
+    const std::vector<UniValue>& values = blockInfo.getValues();
+    writer.BeginObject();
+    for (size_t i = 0; i < keys.size(); i++) {
+        writer.Key(keys[i]);
+        if (keys[i] != "tx") {
+            writer.Value(values[i]);
+            continue;
+        }
+        writer.BeginArray();
+        for (const auto& tx : block.vtx) {
+            UniValue objTx(UniValue::VOBJ);
+            TxToUniv(*tx, uint256(), objTx, true, RPCSerializationFlags());
+            writer.Value(objTx);
+        }
+        writer.EndArray();
+    }
+    writer.EndObject();
+}
+
 UniValue getblockcount(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -174,8 +203,7 @@ UniValue getblockcount(const JSONRPCRequest& request)
             + HelpExampleRpc("getblockcount", "")
         );
 
-    LOCK(cs_main);
-    return chainActive.Height();
+    return GetChainStateSummary()->nHeight;
 }
 
 UniValue getbestblockhash(const JSONRPCRequest& request)
@@ -191,8 +219,7 @@ UniValue getbestblockhash(const JSONRPCRequest& request)
             + HelpExampleRpc("getbestblockhash", "")
         );
 
-    LOCK(cs_main);
-    return chainActive.Tip()->GetBlockHash().GetHex();
+    return GetChainStateSummary()->hashTip.GetHex();
 }
 
 void RPCNotifyBlockChange(bool ibd, const CBlockIndex * pindex)
@@ -411,6 +438,20 @@ void entryToJSON(UniValue &info, const CTxMemPoolEntry &e)
     info.push_back(Pair("depends", depends));
 }
 
+void mempoolToJSONStream(JSONStreamWriter& writer)
+{
+    LOCK(mempool.cs);
+    writer.BeginObject();
+    for (const CTxMemPoolEntry& e : mempool.mapTx)
+    {
+        UniValue info(UniValue::VOBJ);
+        entryToJSON(info, e);
+        writer.Key(e.GetTx().GetHash().ToString());
+        writer.Value(info);
+    }
+    writer.EndObject();
+}
+
 UniValue mempoolToJSON(bool fVerbose)
 {
     if (fVerbose)
@@ -471,6 +512,16 @@ UniValue getrawmempool(const JSONRPCRequest& request)
     return mempoolToJSON(fVerbose);
 }
 
+static bool getrawmempool_stream(const JSONRPCRequest& request, JSONStreamWriter& result)
+{
+    // Only the verbose result is worth streaming
+    if (request.fHelp || request.params.size() != 1 || !request.params[0].isBool() || !request.params[0].get_bool())
+        return false;
+
+    mempoolToJSONStream(result);
+    return true;
+}
+
 UniValue getmempoolancestors(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 2) {
@@ -717,6 +768,25 @@ UniValue getblockheader(const JSONRPCRequest& request)
     return blockheaderToJSON(pblockindex);
 }
 
+static CBlock GetBlockChecked(const CBlockIndex* pblockindex)
+{
+    AssertLockHeld(cs_main);
+
+    CBlock block;
+    if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+
+    if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+        // Block not found on disk. This could be because we have the block
+        // header in our index but don't have the block (for example if a
+        // non-whitelisted node sends us an unrequested long chain of valid
+        // blocks, we add the headers to our index, but don't accept the
+        // block).
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+
+    return block;
+}
+
 UniValue getblock(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 1 || request.params.size() > 2)
@@ -784,19 +854,8 @@ UniValue getblock(const JSONRPCRequest& request)
     if (mapBlockIndex.count(hash) == 0)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
 
-    CBlock block;
     CBlockIndex* pblockindex = mapBlockIndex[hash];
-
-    if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
-        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
-
-    if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
-        // Block not found on disk. This could be because we have the block
-        // header in our index but don't have the block (for example if a
-        // non-whitelisted node sends us an unrequested long chain of valid
-        // blocks, we add the headers to our index, but don't accept the
-        // block).
-        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    const CBlock block = GetBlockChecked(pblockindex);
 
     if (verbosity <= 0)
     {
@@ -809,74 +868,25 @@ UniValue getblock(const JSONRPCRequest& request)
     return blockToJSON(block, pblockindex, verbosity >= 2);
 }
 
-struct CCoinsStats
+static bool getblock_stream(const JSONRPCRequest& request, JSONStreamWriter& result)
 {
-    int nHeight;
-    uint256 hashBlock;
-    uint64_t nTransactions;
-    uint64_t nTransactionOutputs;
-    uint64_t nBogoSize;
-    uint256 hashSerialized;
-    uint64_t nDiskSize;
-    CAmount nTotalAmount;
-
-    CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
-};
+    // Only the transaction details are worth streaming
+    if (request.fHelp || request.params.size() != 2 || !request.params[1].isNum() || request.params[1].get_int() < 2)
+        return false;
 
-static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
-{
-    assert(!outputs.empty());
-    ss << hash;
-    ss << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase);
-    stats.nTransactions++;
-    for (const auto output : outputs) {
-        ss << VARINT(output.first + 1);
-        ss << output.second.out.scriptPubKey;
-        ss << VARINT(output.second.out.nValue);
-        stats.nTransactionOutputs++;
-        stats.nTotalAmount += output.second.out.nValue;
-        stats.nBogoSize += 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
-                           2 /* scriptPubKey len */ + output.second.out.scriptPubKey.size() /* scriptPubKey */;
-    }
-    ss << VARINT(0);
-}
-
-//! Calculate statistics about the unspent transaction output set
-static bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
-{
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
-    assert(pcursor);
-
-    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
-    stats.hashBlock = pcursor->GetBestBlock();
+    uint256 hash(uint256S(request.params[0].get_str()));
+    CBlock block;
+    UniValue blockInfo;
     {
         LOCK(cs_main);
-        stats.nHeight = mapBlockIndex.find(stats.hashBlock)->second->nHeight;
-    }
-    ss << stats.hashBlock;
-    uint256 prevkey;
-    std::map<uint32_t, Coin> outputs;
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        COutPoint key;
-        Coin coin;
-        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
-            if (!outputs.empty() && key.hash != prevkey) {
-                ApplyStats(stats, ss, prevkey, outputs);
-                outputs.clear();
-            }
-            prevkey = key.hash;
-            outputs[key.n] = std::move(coin);
-        } else {
-            return error("%s: unable to read value", __func__);
-        }
-        pcursor->Next();
-    }
-    if (!outputs.empty()) {
-        ApplyStats(stats, ss, prevkey, outputs);
+        if (mapBlockIndex.count(hash) == 0)
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        const CBlockIndex* pblockindex = mapBlockIndex[hash];
+        block = GetBlockChecked(pblockindex);
+        blockInfo = blockToJSON(block, pblockindex, false);
     }
-    stats.hashSerialized = ss.GetHash();
-    stats.nDiskSize = view->EstimateSize();
+
+    blockToJSONStream(block, blockInfo, result);
     return true;
 }
 
@@ -935,15 +945,16 @@ UniValue gettxoutsetinfo(const JSONRPCRequest& request)
         throw std::runtime_error(
             "gettxoutsetinfo\n"
             "\nReturns statistics about the unspent transaction output set.\n"
-            "Note this call may take some time.\n"
+            "Note this call may take some time, unless the node runs with -utxostats.\n"
             "\nResult:\n"
             "{\n"
             "  \"height\":n,     (numeric) The current block height (index)\n"
             "  \"bestblock\": \"hex\",   (string) The hash of the block at the tip of the chain\n"
-            "  \"transactions\": n,      (numeric) The number of transactions with unspent outputs\n"
+            "  \"transactions\": n,      (numeric) The number of transactions with unspent outputs (not with -utxostats)\n"
             "  \"txouts\": n,            (numeric) The number of unspent transaction outputs\n"
             "  \"bogosize\": n,          (numeric) A meaningless metric for UTXO set size\n"
-            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash\n"
+            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash (not with -utxostats)\n"
+            "  \"muhash\": \"hash\",       (string) The rolling MuHash of the set (only with -utxostats)\n"
             "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk\n"
             "  \"total_amount\": x.xxx          (numeric) The total amount\n"
             "}\n"
@@ -954,6 +965,28 @@ UniValue gettxoutsetinfo(const JSONRPCRequest& request)
 
     UniValue ret(UniValue::VOBJ);
 
+    std::unique_ptr<CRollingCoinsStats> prolling;
+    int nHeight = 0;
+    {
+        LOCK(cs_main);
+        if (pcoinsStats) {
+            prolling.reset(new CRollingCoinsStats(*pcoinsStats));
+            nHeight = chainActive.Height();
+        }
+    }
+    if (prolling) {
+        uint256 muhash;
+        prolling->muhash.Finalize(muhash);
+        ret.push_back(Pair("height", (int64_t)nHeight));
+        ret.push_back(Pair("bestblock", prolling->hashBlock.GetHex()));
+        ret.push_back(Pair("txouts", (int64_t)prolling->nTransactionOutputs));
+        ret.push_back(Pair("bogosize", (int64_t)prolling->nBogoSize));
+        ret.push_back(Pair("muhash", muhash.GetHex()));
+        ret.push_back(Pair("disk_size", pcoinsdbview->EstimateSize()));
+        ret.push_back(Pair("total_amount", ValueFromAmount(prolling->nTotalAmount)));
+        return ret;
+    }
+
     CCoinsStats stats;
     FlushStateToDisk();
     if (GetUTXOStats(pcoinsdbview.get(), stats)) {
@@ -971,6 +1004,60 @@ UniValue gettxoutsetinfo(const JSONRPCRequest& request)
     return ret;
 }
 
+UniValue dumptxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "dumptxoutset \"path\"\n"
+            "\nWrites the unspent transaction output set to a snapshot file that can be loaded with -loadtxoutset.\n"
+            "Note this call may take some time.\n"
+            "\nArguments:\n"
+            "1. \"path\"           (string, required) The file to write to, relative to the data directory if not absolute\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"coins_written\": n,        (numeric) The number of coins written\n"
+            "  \"base_hash\": \"hex\",       (string) The hash of the block the snapshot was taken at\n"
+            "  \"base_height\": n,          (numeric) The height of that block\n"
+            "  \"path\": \"path\",          (string) The absolute path of the snapshot file\n"
+            "  \"txoutset_hash\": \"hash\", (string) The snapshot hash, to be checked against when loading it\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumptxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("dumptxoutset", "\"utxo.dat\"")
+        );
+
+    fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
+    if (fs::exists(path)) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, path.string() + " already exists");
+    }
+
+    std::unique_ptr<CCoinsViewCursor> pcursor;
+    int nHeight;
+    {
+        // The cursor iterates over a database snapshot, so the set cannot
+        // change below it while the file is being written without cs_main.
+        LOCK(cs_main);
+        FlushStateToDisk();
+        pcursor.reset(pcoinsdbview->Cursor());
+        nHeight = mapBlockIndex.find(pcursor->GetBestBlock())->second->nHeight;
+    }
+
+    uint64_t nCoins;
+    uint256 hashSnapshot;
+    std::string strError;
+    if (!DumpUTXOSnapshot(pcursor.get(), path, nCoins, hashSnapshot, strError)) {
+        throw JSONRPCError(RPC_MISC_ERROR, strError);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("coins_written", nCoins));
+    ret.push_back(Pair("base_hash", pcursor->GetBestBlock().GetHex()));
+    ret.push_back(Pair("base_height", nHeight));
+    ret.push_back(Pair("path", path.string()));
+    ret.push_back(Pair("txoutset_hash", hashSnapshot.GetHex()));
+    return ret;
+}
+
 UniValue gettxout(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() < 2 || request.params.size() > 3)
@@ -1051,6 +1138,176 @@ UniValue gettxout(const JSONRPCRequest& request)
     return ret;
 }
 
+/** Default and maximum number of results of the address index RPCs */
+static const int DEFAULT_ADDRINDEX_RESULTS = 1000;
+static const int MAX_ADDRINDEX_RESULTS = 10000;
+
+/** Get the address index once it is up to date with the active chain */
+static const AddrIndex& GetSyncedAddrIndex()
+{
+    if (!g_addr_index)
+        throw JSONRPCError(RPC_MISC_ERROR, "The address index is disabled, restart with -addrindex");
+    if (!g_addr_index->BlockUntilSyncedToCurrentChain())
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("The address index is still being built, at height %d", g_addr_index->GetBestHeight()));
+    return *g_addr_index;
+}
+
+/** The script an address, or a hex encoded script, stands for */
+static CScript AddrIndexScript(const UniValue& param)
+{
+    const std::string& str = param.get_str();
+    CTxDestination dest = DecodeDestination(str);
+    if (IsValidDestination(dest))
+        return GetScriptForDestination(dest);
+    if (!str.empty() && IsHex(str)) {
+        std::vector<unsigned char> data(ParseHex(str));
+        return CScript(data.begin(), data.end());
+    }
+    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address or script");
+}
+
+/** Parse the skip and count arguments of the address index RPCs */
+static void AddrIndexPage(const JSONRPCRequest& request, size_t first, size_t& nSkip, size_t& nCount)
+{
+    int skip = request.params[first].isNull() ? 0 : request.params[first].get_int();
+    int count = request.params[first + 1].isNull() ? DEFAULT_ADDRINDEX_RESULTS : request.params[first + 1].get_int();
+    if (skip < 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Negative skip");
+    if (count < 1 || count > MAX_ADDRINDEX_RESULTS)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Count out of range, must be from 1 to %d", MAX_ADDRINDEX_RESULTS));
+    nSkip = skip;
+    nCount = count;
+}
+
+UniValue getaddresstxids(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 3)
+        throw std::runtime_error(
+            "getaddresstxids \"address\" ( skip count )\n"
+            "\nReturns the transactions in the active chain paying to or spending from an address, in chain order.\n"
+            "Requires -addrindex.\n"
+            "\nArguments:\n"
+            "1. \"address\"    (string, required) The ROGER address, or a hex encoded scriptPubKey\n"
+            "2. skip         (numeric, optional, default=0) The number of transactions to skip\n"
+            "3. count        (numeric, optional, default=" + strprintf("%d", DEFAULT_ADDRINDEX_RESULTS) + ", max=" + strprintf("%d", MAX_ADDRINDEX_RESULTS) + ") The number of transactions to return\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"txid\" : \"hash\",   (string) The transaction id\n"
+            "    \"height\" : n       (numeric) The height of the block containing the transaction\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddresstxids", "\"address\"")
+            + HelpExampleCli("getaddresstxids", "\"address\" 1000 1000")
+            + HelpExampleRpc("getaddresstxids", "\"address\", 0, 100")
+        );
+
+    const CScript script = AddrIndexScript(request.params[0]);
+    size_t nSkip, nCount;
+    AddrIndexPage(request, 1, nSkip, nCount);
+
+    std::vector<std::pair<int, uint256>> vTxids;
+    if (!GetSyncedAddrIndex().FindTxids(script, nSkip, nCount, vTxids))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Error reading the address index");
+
+    UniValue result(UniValue::VARR);
+    for (const std::pair<int, uint256>& entry : vTxids) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("txid", entry.second.GetHex());
+        obj.pushKV("height", entry.first);
+        result.push_back(std::move(obj));
+    }
+    return result;
+}
+
+UniValue getaddressutxos(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 4)
+        throw std::runtime_error(
+            "getaddressutxos \"address\" ( skip count include_spent )\n"
+            "\nReturns the unspent outputs in the active chain paying to an address, in chain order.\n"
+            "Requires -addrindex.\n"
+            "\nArguments:\n"
+            "1. \"address\"      (string, required) The ROGER address, or a hex encoded scriptPubKey\n"
+            "2. skip           (numeric, optional, default=0) The number of outputs to skip\n"
+            "3. count          (numeric, optional, default=" + strprintf("%d", DEFAULT_ADDRINDEX_RESULTS) + ", max=" + strprintf("%d", MAX_ADDRINDEX_RESULTS) + ") The number of outputs to return\n"
+            "4. include_spent  (boolean, optional, default=false) Also return the spent outputs, with the transaction spending them\n"
+            "\nResult:\n"
+            "[\n"
+            "  {\n"
+            "    \"txid\" : \"hash\",        (string) The transaction id\n"
+            "    \"vout\" : n,             (numeric) The output number\n"
+            "    \"amount\" : x.xxx,       (numeric) The value of the output in " + CURRENCY_UNIT + "\n"
+            "    \"height\" : n,           (numeric) The height of the block containing the transaction\n"
+            "    \"spenttxid\" : \"hash\",   (string, only with include_spent) The id of the transaction spending the output, if spent\n"
+            "    \"spentheight\" : n       (numeric, only with include_spent) The height of the block containing it, if spent\n"
+            "  }\n"
+            "  ,...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressutxos", "\"address\"")
+            + HelpExampleCli("getaddressutxos", "\"address\" 0 100 true")
+            + HelpExampleRpc("getaddressutxos", "\"address\", 0, 100")
+        );
+
+    const CScript script = AddrIndexScript(request.params[0]);
+    size_t nSkip, nCount;
+    AddrIndexPage(request, 1, nSkip, nCount);
+    bool fIncludeSpent = request.params[3].isNull() ? false : request.params[3].get_bool();
+
+    std::vector<CAddrIndexOutput> vOutputs;
+    if (!GetSyncedAddrIndex().FindOutputs(script, fIncludeSpent, nSkip, nCount, vOutputs))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Error reading the address index");
+
+    UniValue result(UniValue::VARR);
+    for (const CAddrIndexOutput& output : vOutputs) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("txid", output.outpoint.hash.GetHex());
+        obj.pushKV("vout", (int)output.outpoint.n);
+        obj.pushKV("amount", ValueFromAmount(output.nValue));
+        obj.pushKV("height", output.nHeight);
+        if (!output.spentTxid.IsNull()) {
+            obj.pushKV("spenttxid", output.spentTxid.GetHex());
+            obj.pushKV("spentheight", output.nSpentHeight);
+        }
+        result.push_back(std::move(obj));
+    }
+    return result;
+}
+
+UniValue getaddressbalance(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1)
+        throw std::runtime_error(
+            "getaddressbalance \"address\"\n"
+            "\nReturns the balance of an address in the active chain.\n"
+            "Requires -addrindex.\n"
+            "\nArguments:\n"
+            "1. \"address\"    (string, required) The ROGER address, or a hex encoded scriptPubKey\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"balance\" : x.xxx,    (numeric) The value of the unspent outputs paying to the address in " + CURRENCY_UNIT + "\n"
+            "  \"received\" : x.xxx    (numeric) The value of all outputs ever paying to the address in " + CURRENCY_UNIT + "\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressbalance", "\"address\"")
+            + HelpExampleRpc("getaddressbalance", "\"address\"")
+        );
+
+    const CScript script = AddrIndexScript(request.params[0]);
+
+    CAmount nBalance, nReceived;
+    if (!GetSyncedAddrIndex().GetBalance(script, nBalance, nReceived))
+        throw JSONRPCError(RPC_DATABASE_ERROR, "Error reading the address index");
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("balance", ValueFromAmount(nBalance));
+    result.pushKV("received", ValueFromAmount(nReceived));
+    return result;
+}
+
 UniValue verifychain(const JSONRPCRequest& request)
 {
     int nCheckLevel = gArgs.GetArg("-checklevel", DEFAULT_CHECKLEVEL);
@@ -1080,7 +1337,7 @@ UniValue verifychain(const JSONRPCRequest& request)
 }
 
 /** Implementation of IsSuperMajority with better feedback */
-static UniValue SoftForkMajorityDesc(int version, CBlockIndex* pindex, const Consensus::Params& consensusParams)
+static UniValue SoftForkMajorityDesc(int version, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
     UniValue rv(UniValue::VOBJ);
     bool activated = false;
@@ -1100,7 +1357,7 @@ static UniValue SoftForkMajorityDesc(int version, CBlockIndex* pindex, const Con
     return rv;
 }
 
-static UniValue SoftForkDesc(const std::string &name, int version, CBlockIndex* pindex, const Consensus::Params& consensusParams)
+static UniValue SoftForkDesc(const std::string &name, int version, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
 {
     UniValue rv(UniValue::VOBJ);
     rv.push_back(Pair("id", name));
@@ -1109,10 +1366,10 @@ static UniValue SoftForkDesc(const std::string &name, int version, CBlockIndex*
     return rv;
 }
 
-static UniValue BIP9SoftForkDesc(const Consensus::Params& consensusParams, Consensus::DeploymentPos id)
+static UniValue BIP9SoftForkDesc(const CBlockIndex* pindexTip, const Consensus::Params& consensusParams, Consensus::DeploymentPos id)
 {
     UniValue rv(UniValue::VOBJ);
-    const ThresholdState thresholdState = VersionBitsTipState(consensusParams, id);
+    const ThresholdState thresholdState = VersionBitsTipState(pindexTip, consensusParams, id);
     switch (thresholdState) {
     case THRESHOLD_DEFINED: rv.push_back(Pair("status", "defined")); break;
     case THRESHOLD_STARTED: rv.push_back(Pair("status", "started")); break;
@@ -1126,11 +1383,11 @@ static UniValue BIP9SoftForkDesc(const Consensus::Params& consensusParams, Conse
     }
     rv.push_back(Pair("startTime", consensusParams.vDeployments[id].nStartTime));
     rv.push_back(Pair("timeout", consensusParams.vDeployments[id].nTimeout));
-    rv.push_back(Pair("since", VersionBitsTipStateSinceHeight(consensusParams, id)));
+    rv.push_back(Pair("since", VersionBitsTipStateSinceHeight(pindexTip, consensusParams, id)));
     if (THRESHOLD_STARTED == thresholdState)
     {
         UniValue statsUV(UniValue::VOBJ);
-        BIP9Stats statsStruct = VersionBitsTipStatistics(consensusParams, id);
+        BIP9Stats statsStruct = VersionBitsTipStatistics(pindexTip, consensusParams, id);
         statsUV.push_back(Pair("period", statsStruct.period));
         statsUV.push_back(Pair("threshold", statsStruct.threshold));
         statsUV.push_back(Pair("elapsed", statsStruct.elapsed));
@@ -1141,13 +1398,13 @@ static UniValue BIP9SoftForkDesc(const Consensus::Params& consensusParams, Conse
     return rv;
 }
 
-void BIP9SoftForkDescPushBack(UniValue& bip9_softforks, const Consensus::Params& consensusParams, Consensus::DeploymentPos id)
+void BIP9SoftForkDescPushBack(UniValue& bip9_softforks, const CBlockIndex* pindexTip, const Consensus::Params& consensusParams, Consensus::DeploymentPos id)
 {
     // Deployments with timeout value of 0 are hidden.
     // A timeout value of 0 guarantees a softfork will never be activated.
     // This is used when softfork codes are merged without specifying the deployment schedule.
     if (consensusParams.vDeployments[id].nTimeout > 0)
-        bip9_softforks.push_back(Pair(VersionBitsDeploymentInfo[id].name, BIP9SoftForkDesc(consensusParams, id)));
+        bip9_softforks.push_back(Pair(VersionBitsDeploymentInfo[id].name, BIP9SoftForkDesc(pindexTip, consensusParams, id)));
 }
 
 UniValue getblockchaininfo(const JSONRPCRequest& request)
@@ -1204,28 +1461,25 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
             + HelpExampleRpc("getblockchaininfo", "")
         );
 
-    LOCK(cs_main);
+    // Everything is taken from the published chain state, so this does not
+    // wait for blocks being connected
+    const std::shared_ptr<const ChainStateSummary> summary = GetChainStateSummary();
+    const CBlockIndex* tip = summary->pindexTip;
 
     UniValue obj(UniValue::VOBJ);
     obj.push_back(Pair("chain",                 Params().NetworkIDString()));
-    obj.push_back(Pair("blocks",                (int)chainActive.Height()));
-    obj.push_back(Pair("headers",               pindexBestHeader ? pindexBestHeader->nHeight : -1));
-    obj.push_back(Pair("bestblockhash",         chainActive.Tip()->GetBlockHash().GetHex()));
-    obj.push_back(Pair("difficulty",            (double)GetDifficulty()));
-    obj.push_back(Pair("mediantime",            (int64_t)chainActive.Tip()->GetMedianTimePast()));
-    obj.push_back(Pair("verificationprogress",  GuessVerificationProgress(Params().TxData(), chainActive.Tip())));
-    obj.push_back(Pair("initialblockdownload",  IsInitialBlockDownload()));
-    obj.push_back(Pair("chainwork",             chainActive.Tip()->nChainWork.GetHex()));
-    obj.push_back(Pair("size_on_disk",          CalculateCurrentUsage()));
+    obj.push_back(Pair("blocks",                summary->nHeight));
+    obj.push_back(Pair("headers",               summary->nHeaders));
+    obj.push_back(Pair("bestblockhash",         summary->hashTip.GetHex()));
+    obj.push_back(Pair("difficulty",            (double)GetDifficulty(tip)));
+    obj.push_back(Pair("mediantime",            summary->nMedianTimePast));
+    obj.push_back(Pair("verificationprogress",  GuessVerificationProgress(Params().TxData(), tip)));
+    obj.push_back(Pair("initialblockdownload",  summary->fInitialDownload));
+    obj.push_back(Pair("chainwork",             summary->nChainWork.GetHex()));
+    obj.push_back(Pair("size_on_disk",          summary->nSizeOnDisk));
     obj.push_back(Pair("pruned",                fPruneMode));
     if (fPruneMode) {
-        CBlockIndex* block = chainActive.Tip();
-        assert(block);
-        while (block->pprev && (block->pprev->nStatus & BLOCK_HAVE_DATA)) {
-            block = block->pprev;
-        }
-
-        obj.push_back(Pair("pruneheight",        block->nHeight));
+        obj.push_back(Pair("pruneheight",        summary->nPruneHeight));
 
         // if 0, execution bypasses the whole if block.
         bool automatic_pruning = (gArgs.GetArg("-prune", 0) != 1);
@@ -1236,14 +1490,13 @@ UniValue getblockchaininfo(const JSONRPCRequest& request)
     }
 
     const Consensus::Params& consensusParams = Params().GetConsensus();
-    CBlockIndex* tip = chainActive.Tip();
     UniValue softforks(UniValue::VARR);
     UniValue bip9_softforks(UniValue::VOBJ);
     softforks.push_back(SoftForkDesc("bip34", 2, tip, consensusParams));
     softforks.push_back(SoftForkDesc("bip66", 3, tip, consensusParams));
     softforks.push_back(SoftForkDesc("bip65", 4, tip, consensusParams));
     for (int pos = Consensus::DEPLOYMENT_CSV; pos != Consensus::MAX_VERSION_BITS_DEPLOYMENTS; ++pos) {
-        BIP9SoftForkDescPushBack(bip9_softforks, consensusParams, static_cast<Consensus::DeploymentPos>(pos));
+        BIP9SoftForkDescPushBack(bip9_softforks, tip, consensusParams, static_cast<Consensus::DeploymentPos>(pos));
     }
     obj.push_back(Pair("softforks",             softforks));
     obj.push_back(Pair("bip9_softforks", bip9_softforks));
@@ -1373,14 +1626,28 @@ UniValue getchaintips(const JSONRPCRequest& request)
 UniValue mempoolInfoToJSON()
 {
     UniValue ret(UniValue::VOBJ);
-    ret.push_back(Pair("size", (int64_t) mempool.size()));
-    ret.push_back(Pair("bytes", (int64_t) mempool.GetTotalTxSize()));
-    ret.push_back(Pair("usage", (int64_t) mempool.DynamicMemoryUsage()));
+    // Does not wait for mempool.cs, the values are as of the last change to the mempool
+    uint64_t nSize, nBytes, nUsage;
+    CFeeRate minFee;
+    mempool.GetStatsNoLock(nSize, nBytes, nUsage, minFee);
+    ret.push_back(Pair("size", (int64_t) nSize));
+    ret.push_back(Pair("bytes", (int64_t) nBytes));
+    ret.push_back(Pair("usage", (int64_t) nUsage));
     size_t maxmempool = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     ret.push_back(Pair("maxmempool", (int64_t) maxmempool));
-    ret.push_back(Pair("mempoolminfee", ValueFromAmount(std::max(mempool.GetMinFee(maxmempool), ::minRelayTxFee).GetFeePerK())));
+    ret.push_back(Pair("mempoolminfee", ValueFromAmount(std::max(minFee, ::minRelayTxFee).GetFeePerK())));
     ret.push_back(Pair("minrelaytxfee", ValueFromAmount(::minRelayTxFee.GetFeePerK())));
 
+    const TxRelayCacheStats relayStats = g_relay_cache.GetStats();
+    UniValue relaycache(UniValue::VOBJ);
+    relaycache.push_back(Pair("size", (int64_t) relayStats.nTransactions));
+    relaycache.push_back(Pair("usage", (int64_t) relayStats.nUsage));
+    relaycache.push_back(Pair("maxusage", (int64_t) relayStats.nMaxUsage));
+    relaycache.push_back(Pair("hits", relayStats.nHits));
+    relaycache.push_back(Pair("misses", relayStats.nMisses));
+    relaycache.push_back(Pair("evicted", relayStats.nEvicted));
+    ret.push_back(Pair("relaycache", relaycache));
+
     return ret;
 }
 
@@ -1398,6 +1665,14 @@ UniValue getmempoolinfo(const JSONRPCRequest& request)
             "  \"maxmempool\": xxxxx,         (numeric) Maximum memory usage for the mempool\n"
             "  \"mempoolminfee\": xxxxx       (numeric) Minimum fee rate in " + CURRENCY_UNIT + "/kB for tx to be accepted. Is the maximum of minrelaytxfee and minimum mempool fee\n"
             "  \"minrelaytxfee\": xxxxx       (numeric) Current minimum relay fee for transactions\n"
+            "  \"relaycache\": {              (json object) Transactions recently announced to peers, kept to answer their requests\n"
+            "    \"size\": xxxxx,             (numeric) Current tx count\n"
+            "    \"usage\": xxxxx,            (numeric) Memory usage, in bytes\n"
+            "    \"maxusage\": xxxxx,         (numeric) Maximum memory usage (see -maxrelaycache)\n"
+            "    \"hits\": xxxxx,             (numeric) Requests answered from the cache\n"
+            "    \"misses\": xxxxx,           (numeric) Requests for transactions not in the cache\n"
+            "    \"evicted\": xxxxx           (numeric) Transactions dropped before expiring to stay within maxusage\n"
+            "  }\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getmempoolinfo", "")
@@ -1621,22 +1896,26 @@ UniValue savemempool(const JSONRPCRequest& request)
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
-    { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {} },
-    { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"} },
-    { "blockchain",         "getbestblockhash",       &getbestblockhash,       {} },
-    { "blockchain",         "getblockcount",          &getblockcount,          {} },
-    { "blockchain",         "getblock",               &getblock,               {"blockhash","verbosity|verbose"} },
-    { "blockchain",         "getblockhash",           &getblockhash,           {"height"} },
-    { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"} },
-    { "blockchain",         "getchaintips",           &getchaintips,           {} },
-    { "blockchain",         "getdifficulty",          &getdifficulty,          {} },
-    { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    {"txid","verbose"} },
-    { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"} },
-    { "blockchain",         "getmempoolentry",        &getmempoolentry,        {"txid"} },
-    { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         {} },
-    { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
-    { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
+    { "blockchain",         "getblockchaininfo",      &getblockchaininfo,      {}, true },
+    { "blockchain",         "getchaintxstats",        &getchaintxstats,        {"nblocks", "blockhash"}, true },
+    { "blockchain",         "getbestblockhash",       &getbestblockhash,       {}, true },
+    { "blockchain",         "getblockcount",          &getblockcount,          {}, true },
+    { "blockchain",         "getblock",               &getblock,               {"blockhash","verbosity|verbose"}, true, &getblock_stream },
+    { "blockchain",         "getblockhash",           &getblockhash,           {"height"}, true },
+    { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"}, true },
+    { "blockchain",         "getchaintips",           &getchaintips,           {}, true },
+    { "blockchain",         "getdifficulty",          &getdifficulty,          {}, true },
+    { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    {"txid","verbose"}, true },
+    { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"}, true },
+    { "blockchain",         "getmempoolentry",        &getmempoolentry,        {"txid"}, true },
+    { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         {}, true },
+    { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"}, true, &getrawmempool_stream },
+    { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"}, true },
+    { "blockchain",         "getaddresstxids",        &getaddresstxids,        {"address","skip","count"}, true },
+    { "blockchain",         "getaddressutxos",        &getaddressutxos,        {"address","skip","count","include_spent"}, true },
+    { "blockchain",         "getaddressbalance",      &getaddressbalance,      {"address"}, true },
     { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
+    { "blockchain",         "dumptxoutset",           &dumptxoutset,           {"path"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
     { "blockchain",         "savemempool",            &savemempool,            {} },
     { "blockchain",         "verifychain",            &verifychain,            {"checklevel","nblocks"} },
@@ -7,6 +7,7 @@
 
 class CBlock;
 class CBlockIndex;
+class JSONStreamWriter;
 class UniValue;
 
 /**
@@ -24,12 +25,19 @@ void RPCNotifyBlockChange(bool ibd, const CBlockIndex *);
 /** Block description to JSON */
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
 
+/** Write block as blockToJSON(block, blockindex, true) would, given
+ *  blockInfo = blockToJSON(block, blockindex, false), one transaction at a time */
+void blockToJSONStream(const CBlock& block, const UniValue& blockInfo, JSONStreamWriter& writer);
+
 /** Mempool information to JSON */
 UniValue mempoolInfoToJSON();
 
 /** Mempool to JSON */
 UniValue mempoolToJSON(bool fVerbose = false);
 
+/** Write the mempool as mempoolToJSON(true) would, one entry at a time */
+void mempoolToJSONStream(JSONStreamWriter& writer);
+
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex* blockindex);
 
@@ -0,0 +1,60 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONSTREAM_H
+#define BITCOIN_RPC_JSONSTREAM_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class UniValue;
+
+/** Output buffered by a JSONStreamWriter before it is handed on */
+static const size_t JSON_STREAM_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * Writes a JSON document piece by piece, the way UniValue::write() without
+ * indentation would write it as a whole, handing the output on in chunks as
+ * it grows. Large results can so be sent while they are being produced,
+ * with only their small parts ever built as UniValues.
+ */
+class JSONStreamWriter
+{
+public:
+    typedef std::function<void(const std::string& strChunk)> Sink;
+
+    explicit JSONStreamWriter(Sink sinkIn, size_t nChunkSizeIn = JSON_STREAM_CHUNK_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    /** Write the key of the next object member */
+    void Key(const std::string& key);
+    /** Write a whole value, as an array element, object member or the document */
+    void Value(const UniValue& value);
+
+    /** Hand on what is buffered */
+    void Flush();
+    /** End the document with a newline and hand it on */
+    void Finish();
+
+    /** Whether any output was handed on yet */
+    bool Flushed() const { return fFlushed; }
+
+private:
+    Sink sink;
+    const size_t nChunkSize;
+    std::string strBuffer;
+    //! For each open array or object, whether it has no elements yet
+    std::vector<bool> vEmpty;
+    bool fAfterKey;
+    bool fFlushed;
+
+    void BeginValue();
+    void EndValue();
+};
+
+#endif // BITCOIN_RPC_JSONSTREAM_H
@@ -7,6 +7,7 @@
 #include <chain.h>
 #include <clientversion.h>
 #include <core_io.h>
+#include <dbwrapper.h>
 #include <crypto/ripemd160.h>
 #include <init.h>
 #include <validation.h>
@@ -19,6 +20,7 @@
 #include <timedata.h>
 #include <util.h>
 #include <utilstrencodings.h>
+#include <validationinterface.h>
 #ifdef ENABLE_WALLET
 #include <wallet/rpcwallet.h>
 #include <wallet/wallet.h>
@@ -524,6 +526,121 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     }
 }
 
+UniValue getdbinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "getdbinfo ( verbose )\n"
+            "Returns the settings and LevelDB statistics of the open databases (see -dboption).\n"
+            "\nArguments:\n"
+            "1. verbose        (boolean, optional, default=false) Also return LevelDB's compaction statistics and table listing\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"name\": {                    (json object) The database: chainstate, blockindex or sporks\n"
+            "    \"path\": \"path\",            (string) The location of the database\n"
+            "    \"approximate_size\": n,     (numeric) The approximate size on disk, in bytes\n"
+            "    \"memory_usage\": n,         (numeric) The approximate memory used by LevelDB's write buffers, in bytes\n"
+            "    \"files_per_level\": [n,...], (array) The number of table files at each level\n"
+            "    \"options\": {               (json object) The settings the database was opened with\n"
+            "      \"block_cache_size\": n,\n"
+            "      \"write_buffer_size\": n,\n"
+            "      \"block_size\": n,\n"
+            "      \"max_file_size\": n,\n"
+            "      \"bloom_bits\": n,\n"
+            "      \"compression\": true|false,\n"
+            "      \"max_open_files\": n\n"
+            "    },\n"
+            "    \"stats\": \"...\"             (string) LevelDB's statistics (only if verbose is true)\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getdbinfo", "")
+            + HelpExampleRpc("getdbinfo", "true")
+        );
+
+    bool fVerbose = request.params[0].isNull() ? false : request.params[0].get_bool();
+
+    UniValue ret(UniValue::VOBJ);
+    for (const DBWrapperInfo& info : GetDBWrapperInfo(fVerbose)) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("path", info.path.string()));
+        obj.push_back(Pair("approximate_size", info.nApproximateSize));
+        obj.push_back(Pair("memory_usage", info.nMemoryUsage));
+        UniValue levels(UniValue::VARR);
+        for (int nFiles : info.vFilesPerLevel) {
+            levels.push_back(nFiles);
+        }
+        obj.push_back(Pair("files_per_level", levels));
+        UniValue options(UniValue::VOBJ);
+        options.push_back(Pair("block_cache_size", (uint64_t)info.nBlockCacheSize));
+        options.push_back(Pair("write_buffer_size", (uint64_t)info.nWriteBufferSize));
+        options.push_back(Pair("block_size", (uint64_t)info.nBlockSize));
+        options.push_back(Pair("max_file_size", (uint64_t)info.nMaxFileSize));
+        options.push_back(Pair("bloom_bits", info.nBloomBits));
+        options.push_back(Pair("compression", info.fCompression));
+        options.push_back(Pair("max_open_files", info.nMaxOpenFiles));
+        obj.push_back(Pair("options", options));
+        if (fVerbose) {
+            obj.push_back(Pair("stats", info.strStats));
+        }
+        ret.push_back(Pair(info.name, obj));
+    }
+    return ret;
+}
+
+UniValue getvalidationqueueinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getvalidationqueueinfo\n"
+            "Returns the queue depth and latency of the notifications of each validation listener\n"
+            "(wallets, indexes, ZMQ, ...), and how often block validation waited for them.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"validation_waits\": n,        (numeric) Times block validation waited for a listener that fell behind\n"
+            "  \"validation_wait_time\": n,    (numeric) Total time block validation waited, in microseconds\n"
+            "  \"queues\": [\n"
+            "    {\n"
+            "      \"name\": \"name\",            (string) The listener\n"
+            "      \"pending\": n,             (numeric) Notifications queued and not run yet\n"
+            "      \"processed\": n,           (numeric) Notifications run so far\n"
+            "      \"wait_time_avg\": n,       (numeric) Average time notifications waited in the queue, in microseconds\n"
+            "      \"wait_time_max\": n,       (numeric) Longest time a notification waited in the queue, in microseconds\n"
+            "      \"run_time_avg\": n,        (numeric) Average time the listener took for a notification, in microseconds\n"
+            "      \"run_time_max\": n         (numeric) Longest time the listener took for a notification, in microseconds\n"
+            "    },\n"
+            "    ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getvalidationqueueinfo", "")
+            + HelpExampleRpc("getvalidationqueueinfo", "")
+        );
+
+    uint64_t nLimitWaits;
+    int64_t nLimitWaitTime;
+    std::vector<ValidationQueueStats> vStats = GetMainSignals().GetQueueStats(nLimitWaits, nLimitWaitTime);
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("validation_waits", nLimitWaits));
+    ret.push_back(Pair("validation_wait_time", nLimitWaitTime));
+    UniValue queues(UniValue::VARR);
+    for (const ValidationQueueStats& stats : vStats) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("name", stats.name));
+        obj.push_back(Pair("pending", (uint64_t)stats.nPending));
+        obj.push_back(Pair("processed", stats.nProcessed));
+        obj.push_back(Pair("wait_time_avg", stats.nProcessed ? stats.nWaitTime / (int64_t)stats.nProcessed : 0));
+        obj.push_back(Pair("wait_time_max", stats.nMaxWaitTime));
+        obj.push_back(Pair("run_time_avg", stats.nProcessed ? stats.nRunTime / (int64_t)stats.nProcessed : 0));
+        obj.push_back(Pair("run_time_max", stats.nMaxRunTime));
+        queues.push_back(obj);
+    }
+    ret.push_back(Pair("queues", queues));
+    return ret;
+}
+
 uint32_t getCategoryMask(UniValue cats) {
     cats = cats.get_array();
     uint32_t mask = 0;
@@ -638,7 +755,9 @@ static UniValue getinfo_deprecated(const JSONRPCRequest& request)
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
+    { "control",            "getdbinfo",              &getdbinfo,              {"verbose"} },
     { "control",            "getmemoryinfo",          &getmemoryinfo,          {"mode"} },
+    { "control",            "getvalidationqueueinfo", &getvalidationqueueinfo, {} },
     { "control",            "logging",                &logging,                {"include", "exclude"}},
     { "util",               "validateaddress",        &validateaddress,        {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         &createmultisig,         {"nrequired","keys"} },
@@ -647,7 +766,7 @@ static const CRPCCommand commands[] =
 
     /* Not shown in help */
     { "hidden",             "setmocktime",            &setmocktime,            {"timestamp"}},
-    { "hidden",             "echo",                   &echo,                   {"arg0","arg1","arg2","arg3","arg4","arg5","arg6","arg7","arg8","arg9"}},
+    { "hidden",             "echo",                   &echo,                   {"arg0","arg1","arg2","arg3","arg4","arg5","arg6","arg7","arg8","arg9"}, true},
     { "hidden",             "echojson",               &echo,                   {"arg0","arg1","arg2","arg3","arg4","arg5","arg6","arg7","arg8","arg9"}},
     { "hidden",             "getinfo",                &getinfo_deprecated,     {}},
 };
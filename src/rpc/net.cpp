@@ -458,7 +458,6 @@ UniValue getnetworkinfo(const JSONRPCRequest& request)
             + HelpExampleRpc("getnetworkinfo", "")
         );
 
-    LOCK(cs_main);
     UniValue obj(UniValue::VOBJ);
     obj.push_back(Pair("version",       CLIENT_VERSION));
     obj.push_back(Pair("subversion",    strSubVersion));
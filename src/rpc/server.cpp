@@ -20,7 +20,10 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 
+#include <atomic>
 #include <memory> // for unique_ptr
+#include <system_error>
+#include <thread>
 #include <unordered_map>
 
 static bool fRPCRunning = false;
@@ -32,6 +35,10 @@ static RPCTimerInterface* timerInterface = nullptr;
 /* Map of name to timer. */
 static std::map<std::string, std::unique_ptr<RPCTimerBase> > deadlineTimers;
 
+//! Batch threads free to run calls, shared by all batches
+static std::unique_ptr<CSemaphore> g_rpc_batch_slots;
+static int g_rpc_batch_concurrency = DEFAULT_RPC_BATCH_CONCURRENCY;
+
 static struct CRPCSignals
 {
     boost::signals2::signal<void ()> Started;
@@ -305,6 +312,8 @@ bool CRPCTable::appendCommand(const std::string& name, const CRPCCommand* pcmd)
 bool StartRPC()
 {
     LogPrint(BCLog::RPC, "Starting RPC\n");
+    g_rpc_batch_slots.reset(new CSemaphore(std::max((int)gArgs.GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), 0)));
+    g_rpc_batch_concurrency = std::max((int)gArgs.GetArg("-rpcbatchconcurrency", DEFAULT_RPC_BATCH_CONCURRENCY), 1);
     fRPCRunning = true;
     g_rpcSignals.Started();
     return true;
@@ -410,11 +419,68 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
+static bool IsConcurrentRequest(const UniValue& req)
+{
+    if (!req.isObject())
+        return false;
+    const UniValue& valMethod = find_value(req, "method");
+    if (!valMethod.isStr())
+        return false;
+    const CRPCCommand *pcmd = tableRPC[valMethod.get_str()];
+    return pcmd && pcmd->fConcurrent;
+}
+
+/** Execute vReq[nBegin, nEnd) at the same time, on this thread and whatever batch threads are free */
+static void JSONRPCExecConcurrent(const JSONRPCRequest& jreq, const UniValue& vReq, size_t nBegin, size_t nEnd, std::vector<UniValue>& vReplies)
+{
+    std::atomic<size_t> nNext(nBegin);
+    auto worker = [&]() {
+        for (size_t i = nNext++; i < nEnd; i = nNext++) {
+            vReplies[i] = JSONRPCExecOne(jreq, vReq[i]);
+        }
+    };
+
+    std::vector<std::thread> vThreads;
+    while (g_rpc_batch_slots && vThreads.size() + 1 < std::min<size_t>(g_rpc_batch_concurrency, nEnd - nBegin) &&
+           g_rpc_batch_slots->try_wait()) {
+        try {
+            vThreads.emplace_back([&]() {
+                worker();
+                g_rpc_batch_slots->post();
+            });
+        } catch (const std::system_error& e) {
+            LogPrint(BCLog::RPC, "Could not start RPC batch thread: %s\n", e.what());
+            g_rpc_batch_slots->post();
+            break;
+        }
+    }
+    worker();
+    for (std::thread& thread : vThreads) {
+        thread.join();
+    }
+}
+
 std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
 {
+    std::vector<UniValue> vReplies(vReq.size());
+    size_t reqIdx = 0;
+    while (reqIdx < vReq.size()) {
+        // Run consecutive concurrent calls together, anything else on its own
+        size_t reqEnd = reqIdx;
+        while (reqEnd < vReq.size() && IsConcurrentRequest(vReq[reqEnd]))
+            reqEnd++;
+        if (reqEnd - reqIdx > 1) {
+            JSONRPCExecConcurrent(jreq, vReq, reqIdx, reqEnd, vReplies);
+            reqIdx = reqEnd;
+        } else {
+            vReplies[reqIdx] = JSONRPCExecOne(jreq, vReq[reqIdx]);
+            reqIdx++;
+        }
+    }
+
     UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    for (const UniValue& reply : vReplies)
+        ret.push_back(reply);
 
     return ret.write() + "\n";
 }
@@ -469,7 +535,7 @@ static inline JSONRPCRequest transformNamedArguments(const JSONRPCRequest& in, c
     return out;
 }
 
-UniValue CRPCTable::execute(const JSONRPCRequest &request) const
+static const CRPCCommand* FindCommandChecked(const std::string& strMethod)
 {
     // Return immediately if in warmup
     {
@@ -479,9 +545,15 @@ UniValue CRPCTable::execute(const JSONRPCRequest &request) const
     }
 
     // Find method
-    const CRPCCommand *pcmd = tableRPC[request.strMethod];
+    const CRPCCommand *pcmd = tableRPC[strMethod];
     if (!pcmd)
         throw JSONRPCError(RPC_METHOD_NOT_FOUND, "Method not found");
+    return pcmd;
+}
+
+UniValue CRPCTable::execute(const JSONRPCRequest &request) const
+{
+    const CRPCCommand *pcmd = FindCommandChecked(request.strMethod);
 
     g_rpcSignals.PreCommand(*pcmd);
 
@@ -500,6 +572,29 @@ UniValue CRPCTable::execute(const JSONRPCRequest &request) const
     }
 }
 
+bool CRPCTable::executeStream(const JSONRPCRequest &request, JSONStreamWriter& writer) const
+{
+    const CRPCCommand *pcmd = FindCommandChecked(request.strMethod);
+    if (!pcmd->streamActor)
+        return false;
+
+    g_rpcSignals.PreCommand(*pcmd);
+
+    try
+    {
+        // Execute, convert arguments to array if necessary
+        if (request.params.isObject()) {
+            return pcmd->streamActor(transformNamedArguments(request, pcmd->argNames), writer);
+        } else {
+            return pcmd->streamActor(request, writer);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        throw JSONRPCError(RPC_MISC_ERROR, e.what());
+    }
+}
+
 std::vector<std::string> CRPCTable::listCommands() const
 {
     std::vector<std::string> commandList;
@@ -20,6 +20,7 @@
 static const unsigned int DEFAULT_RPC_SERIALIZE_VERSION = 1;
 
 class CRPCCommand;
+class JSONStreamWriter;
 
 namespace RPCServer
 {
@@ -126,14 +127,24 @@ void RPCUnsetTimerInterface(RPCTimerInterface *iface);
 void RPCRunLater(const std::string& name, std::function<void(void)> func, int64_t nSeconds);
 
 typedef UniValue(*rpcfn_type)(const JSONRPCRequest& jsonRequest);
+/** Writes the result to result, or returns false without writing anything to
+ *  leave the request to the command's regular actor */
+typedef bool(*rpcstreamfn_type)(const JSONRPCRequest& jsonRequest, JSONStreamWriter& result);
 
 class CRPCCommand
 {
 public:
+    CRPCCommand(std::string categoryIn, std::string nameIn, rpcfn_type actorIn, std::vector<std::string> argNamesIn, bool fConcurrentIn = false, rpcstreamfn_type streamActorIn = nullptr)
+        : category(std::move(categoryIn)), name(std::move(nameIn)), actor(actorIn), argNames(std::move(argNamesIn)), fConcurrent(fConcurrentIn), streamActor(streamActorIn) {}
+
     std::string category;
     std::string name;
     rpcfn_type actor;
     std::vector<std::string> argNames;
+    //! Only reads state, so calls within a batch may run at the same time
+    bool fConcurrent;
+    //! Optionally, for results too large to build at once
+    rpcstreamfn_type streamActor;
 };
 
 /**
@@ -156,6 +167,14 @@ public:
      */
     UniValue execute(const JSONRPCRequest &request) const;
 
+    /**
+     * Execute a method that can write its result bit by bit.
+     * @returns false, without writing anything, if execute() should be used instead.
+     * @throws an exception (UniValue) when an error happens. Unless writer
+     * has flushed output, the result can be replaced by the error.
+     */
+    bool executeStream(const JSONRPCRequest &request, JSONStreamWriter& writer) const;
+
     /**
     * Returns a list of registered commands
     * @returns List of registered commands.
@@ -188,9 +207,20 @@ extern CAmount AmountFromValue(const UniValue& value);
 extern std::string HelpExampleCli(const std::string& methodname, const std::string& args);
 extern std::string HelpExampleRpc(const std::string& methodname, const std::string& args);
 
+/** Default for -rpcbatchthreads, threads shared by all batches to run concurrent calls on */
+static const int DEFAULT_RPC_BATCH_THREADS = 4;
+/** Default for -rpcbatchconcurrency, calls of a batch run at the same time */
+static const int DEFAULT_RPC_BATCH_CONCURRENCY = 4;
+
 bool StartRPC();
 void InterruptRPC();
 void StopRPC();
+/**
+ * Execute a batch of requests, returning the replies in order. Consecutive
+ * calls to commands marked fConcurrent run at the same time, on the calling
+ * thread and up to -rpcbatchconcurrency - 1 batch threads; other calls run
+ * alone, after the calls before them and before the calls after them.
+ */
 std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
 
 // Retrieves any serialization flags requested in command line argument
@@ -8,7 +8,7 @@
 
 CSporkDB* pSporkDB = nullptr;
 
-CSporkDB::CSporkDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "sporks", nCacheSize, fMemory, fWipe) { }
+CSporkDB::CSporkDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "sporks", nCacheSize, fMemory, fWipe, false, "sporks") { }
 
 bool CSporkDB::WriteSpork(const int nSporkId, const CSporkMessage& spork)
 {
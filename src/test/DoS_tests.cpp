@@ -11,26 +11,17 @@
 #include <pow.h>
 #include <script/sign.h>
 #include <serialize.h>
+#include <txorphanpool.h>
 #include <util.h>
 #include <validation.h>
 
 #include <test/test_bitcoin.h>
 
+#include <limits>
 #include <stdint.h>
 
 #include <boost/test/unit_test.hpp>
 
-// Tests these internal-to-net_processing.cpp methods:
-extern bool AddOrphanTx(const CTransactionRef& tx, NodeId peer);
-extern void EraseOrphansFor(NodeId peer);
-extern unsigned int LimitOrphanTxSize(unsigned int nMaxOrphans);
-struct COrphanTx {
-    CTransactionRef tx;
-    NodeId fromPeer;
-    int64_t nTimeExpire;
-};
-extern std::map<uint256, COrphanTx> mapOrphanTransactions;
-
 CService ip(uint32_t i)
 {
     struct in_addr s;
@@ -291,14 +282,9 @@ BOOST_AUTO_TEST_CASE(DoS_bantime)
     peerLogic->FinalizeNode(dummyNode.GetId(), dummy);
 }
 
-CTransactionRef RandomOrphan()
+static CTransactionRef RandomOrphan(const std::vector<CTransactionRef>& vOrphans)
 {
-    std::map<uint256, COrphanTx>::iterator it;
-    LOCK(cs_main);
-    it = mapOrphanTransactions.lower_bound(InsecureRand256());
-    if (it == mapOrphanTransactions.end())
-        it = mapOrphanTransactions.begin();
-    return it->second.tx;
+    return vOrphans[InsecureRandRange(vOrphans.size())];
 }
 
 BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
@@ -308,6 +294,9 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
     CBasicKeyStore keystore;
     keystore.AddKey(key);
 
+    CTxOrphanPool orphans;
+    std::vector<CTransactionRef> vAdded;
+
     // 50 orphan transactions:
     for (int i = 0; i < 50; i++)
     {
@@ -320,13 +309,15 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
         tx.vout[0].nValue = 1*CENT;
         tx.vout[0].scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
 
-        AddOrphanTx(MakeTransactionRef(tx), i);
+        CTransactionRef ptx = MakeTransactionRef(tx);
+        BOOST_CHECK(orphans.AddTx(ptx, i));
+        vAdded.push_back(ptx);
     }
 
     // ... and 50 that depend on other orphans:
     for (int i = 0; i < 50; i++)
     {
-        CTransactionRef txPrev = RandomOrphan();
+        CTransactionRef txPrev = RandomOrphan(vAdded);
 
         CMutableTransaction tx;
         tx.vin.resize(1);
@@ -337,13 +328,16 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
         tx.vout[0].scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
         SignSignature(keystore, *txPrev, tx, 0, SIGHASH_ALL);
 
-        AddOrphanTx(MakeTransactionRef(tx), i);
+        // Spending the same parent twice makes the same transaction, which is only added once
+        CTransactionRef ptx = MakeTransactionRef(tx);
+        if (orphans.AddTx(ptx, i)) vAdded.push_back(ptx);
     }
+    BOOST_CHECK_EQUAL(orphans.Size(), vAdded.size());
 
     // This really-big orphan should be ignored:
     for (int i = 0; i < 10; i++)
     {
-        CTransactionRef txPrev = RandomOrphan();
+        CTransactionRef txPrev = RandomOrphan(vAdded);
 
         CMutableTransaction tx;
         tx.vout.resize(1);
@@ -361,25 +355,72 @@ BOOST_AUTO_TEST_CASE(DoS_mapOrphans)
         for (unsigned int j = 1; j < tx.vin.size(); j++)
             tx.vin[j].scriptSig = tx.vin[0].scriptSig;
 
-        BOOST_CHECK(!AddOrphanTx(MakeTransactionRef(tx), i));
+        BOOST_CHECK(!orphans.AddTx(MakeTransactionRef(tx), i));
     }
 
-    LOCK(cs_main);
-    // Test EraseOrphansFor:
+    // Accepting a parent queues its orphan children for the peers that sent them
+    const CTransactionRef txParent = vAdded[0];
+    orphans.AddChildrenToWorkSet(*txParent);
+    for (NodeId i = 0; i < 50; i++) {
+        while (CTransactionRef ptx = orphans.GetTxToReconsider(i)) {
+            BOOST_CHECK_EQUAL(ptx->vin[0].prevout.hash, txParent->GetHash());
+        }
+        BOOST_CHECK(!orphans.HaveTxToReconsider(i));
+    }
+
+    // Test EraseForPeer:
     for (NodeId i = 0; i < 3; i++)
     {
-        size_t sizeBefore = mapOrphanTransactions.size();
-        EraseOrphansFor(i);
-        BOOST_CHECK(mapOrphanTransactions.size() < sizeBefore);
+        size_t sizeBefore = orphans.Size();
+        orphans.EraseForPeer(i);
+        BOOST_CHECK(orphans.Size() < sizeBefore);
     }
 
-    // Test LimitOrphanTxSize() function:
-    LimitOrphanTxSize(40);
-    BOOST_CHECK(mapOrphanTransactions.size() <= 40);
-    LimitOrphanTxSize(10);
-    BOOST_CHECK(mapOrphanTransactions.size() <= 10);
-    LimitOrphanTxSize(0);
-    BOOST_CHECK(mapOrphanTransactions.empty());
+    // Test LimitOrphans() function:
+    orphans.LimitOrphans(40, std::numeric_limits<size_t>::max());
+    BOOST_CHECK(orphans.Size() <= 40);
+    orphans.LimitOrphans(10, std::numeric_limits<size_t>::max());
+    BOOST_CHECK(orphans.Size() <= 10);
+    const size_t nUsage = orphans.DynamicMemoryUsage();
+    orphans.LimitOrphans(10, nUsage / 2);
+    BOOST_CHECK(orphans.DynamicMemoryUsage() <= nUsage / 2);
+    orphans.LimitOrphans(0, std::numeric_limits<size_t>::max());
+    BOOST_CHECK_EQUAL(orphans.Size(), 0U);
+    BOOST_CHECK_EQUAL(orphans.DynamicMemoryUsage(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(DoS_orphans_per_peer_limit)
+{
+    CTxOrphanPool orphans;
+
+    // A single peer cannot fill the pool with orphans
+    size_t nAdded = 0;
+    for (int i = 0; i < 2000; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(10);
+        for (CTxIn& txin : tx.vin) {
+            txin.prevout = COutPoint(InsecureRand256(), 0);
+            txin.scriptSig << std::vector<unsigned char>(100, 0);
+        }
+        tx.vout.resize(1);
+        tx.vout[0].nValue = 1*CENT;
+        if (orphans.AddTx(MakeTransactionRef(tx), 0)) nAdded++;
+    }
+    BOOST_CHECK(nAdded > 0 && nAdded < 2000);
+    BOOST_CHECK(orphans.DynamicMemoryUsage() <= MAX_PEER_ORPHAN_BYTES);
+
+    // ... while another one still can add its own
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(InsecureRand256(), 0);
+    tx.vout.resize(1);
+    BOOST_CHECK(orphans.AddTx(MakeTransactionRef(tx), 1));
+    BOOST_CHECK(orphans.HaveTx(tx.GetHash()));
+
+    orphans.EraseForPeer(0);
+    BOOST_CHECK_EQUAL(orphans.Size(), 1U);
+    BOOST_CHECK_EQUAL(orphans.EraseTx(tx.GetHash()), 1);
+    BOOST_CHECK_EQUAL(orphans.DynamicMemoryUsage(), 0U);
 }
 
 BOOST_AUTO_TEST_SUITE_END()
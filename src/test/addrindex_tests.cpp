@@ -0,0 +1,128 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/addrindex.h>
+#include <script/standard.h>
+#include <test/test_bitcoin.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addrindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(addrindex_initial_sync, TestChain100Setup)
+{
+    AddrIndex addr_index(1 << 20, true);
+    const CScript coinbaseScript = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+
+    // Not available before the initial sync is done
+    BOOST_CHECK(!addr_index.BlockUntilSyncedToCurrentChain());
+    BOOST_REQUIRE(addr_index.Start());
+
+    int64_t nTimeout = GetTimeMillis() + 10 * 1000;
+    while (!addr_index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(GetTimeMillis() < nTimeout);
+        MilliSleep(100);
+    }
+    BOOST_CHECK_EQUAL(addr_index.GetBestHeight(), chainActive.Height());
+
+    CAmount nExpected = 0;
+    for (const CTransaction& tx : coinbaseTxns) {
+        for (const CTxOut& out : tx.vout) {
+            if (out.scriptPubKey == coinbaseScript)
+                nExpected += out.nValue;
+        }
+    }
+
+    std::vector<std::pair<int, uint256>> vTxids;
+    BOOST_CHECK(addr_index.FindTxids(coinbaseScript, 0, 1000, vTxids));
+    BOOST_REQUIRE_EQUAL(vTxids.size(), coinbaseTxns.size());
+    for (size_t i = 0; i < vTxids.size(); i++) {
+        BOOST_CHECK_EQUAL(vTxids[i].first, (int)i + 1);
+        BOOST_CHECK(vTxids[i].second == coinbaseTxns[i].GetHash());
+    }
+
+    // Paging
+    vTxids.clear();
+    BOOST_CHECK(addr_index.FindTxids(coinbaseScript, 10, 5, vTxids));
+    BOOST_REQUIRE_EQUAL(vTxids.size(), 5U);
+    BOOST_CHECK(vTxids[0].second == coinbaseTxns[10].GetHash());
+
+    CAmount nBalance, nReceived;
+    BOOST_CHECK(addr_index.GetBalance(coinbaseScript, nBalance, nReceived));
+    BOOST_CHECK_EQUAL(nBalance, nExpected);
+    BOOST_CHECK_EQUAL(nReceived, nExpected);
+
+    // Spend a coinbase output to another script, in a block the index follows
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript destScript = GetScriptForDestination(key.GetPubKey().GetID());
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = COutPoint(coinbaseTxns[0].GetHash(), 0);
+    spend.vout.resize(1);
+    spend.vout[0].nValue = coinbaseTxns[0].vout[0].nValue - CENT;
+    spend.vout[0].scriptPubKey = destScript;
+    std::vector<unsigned char> vchSig;
+    uint256 hash = SignatureHash(coinbaseScript, spend, 0, SIGHASH_ALL, 0, SIGVERSION_BASE);
+    BOOST_CHECK(coinbaseKey.Sign(hash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+
+    CBlock block = CreateAndProcessBlock({spend}, coinbaseScript);
+    BOOST_REQUIRE(chainActive.Tip()->GetBlockHash() == block.GetHash());
+    BOOST_CHECK(addr_index.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK_EQUAL(addr_index.GetBestHeight(), chainActive.Height());
+
+    std::vector<CAddrIndexOutput> vOutputs;
+    BOOST_CHECK(addr_index.FindOutputs(destScript, false, 0, 1000, vOutputs));
+    BOOST_REQUIRE_EQUAL(vOutputs.size(), 1U);
+    BOOST_CHECK(vOutputs[0].outpoint == COutPoint(spend.GetHash(), 0));
+    BOOST_CHECK_EQUAL(vOutputs[0].nHeight, chainActive.Height());
+    BOOST_CHECK_EQUAL(vOutputs[0].nValue, spend.vout[0].nValue);
+
+    // The spent coinbase output is only listed with the spent ones, with its spender
+    vOutputs.clear();
+    BOOST_CHECK(addr_index.FindOutputs(coinbaseScript, false, 0, 1, vOutputs));
+    BOOST_REQUIRE_EQUAL(vOutputs.size(), 1U);
+    BOOST_CHECK(vOutputs[0].outpoint.hash == coinbaseTxns[1].GetHash());
+    vOutputs.clear();
+    BOOST_CHECK(addr_index.FindOutputs(coinbaseScript, true, 0, 1, vOutputs));
+    BOOST_REQUIRE_EQUAL(vOutputs.size(), 1U);
+    BOOST_CHECK(vOutputs[0].outpoint.hash == coinbaseTxns[0].GetHash());
+    BOOST_CHECK(vOutputs[0].spentTxid == spend.GetHash());
+    BOOST_CHECK_EQUAL(vOutputs[0].nSpentHeight, chainActive.Height());
+
+    vTxids.clear();
+    BOOST_CHECK(addr_index.FindTxids(destScript, 0, 1000, vTxids));
+    BOOST_REQUIRE_EQUAL(vTxids.size(), 1U);
+    BOOST_CHECK(vTxids[0].second == spend.GetHash());
+
+    // Disconnecting the block takes its entries out again
+    {
+        CValidationState state;
+        {
+            LOCK(cs_main);
+            InvalidateBlock(state, Params(), chainActive.Tip());
+        }
+        BOOST_CHECK(ActivateBestChain(state, Params()));
+    }
+    BOOST_CHECK(addr_index.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK_EQUAL(addr_index.GetBestHeight(), chainActive.Height());
+
+    vOutputs.clear();
+    BOOST_CHECK(addr_index.FindOutputs(destScript, true, 0, 1000, vOutputs));
+    BOOST_CHECK(vOutputs.empty());
+    BOOST_CHECK(addr_index.GetBalance(coinbaseScript, nBalance, nReceived));
+    BOOST_CHECK_EQUAL(nBalance, nExpected);
+    BOOST_CHECK_EQUAL(nReceived, nExpected);
+
+    addr_index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -120,6 +120,7 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
     bool found_an_entry = false;
     bool missed_an_entry = false;
     bool uncached_an_entry = false;
+    bool trimmed_a_cache = false;
 
     // A simple map to track what we expect the cache stack to represent.
     std::map<COutPoint, Coin> result;
@@ -210,7 +211,14 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
             // Every 100 iterations, flush an intermediate cache
             if (stack.size() > 1 && InsecureRandBool() == 0) {
                 unsigned int flushIndex = InsecureRandRange(stack.size() - 1);
-                stack[flushIndex]->Flush();
+                if (InsecureRandBool()) {
+                    stack[flushIndex]->Flush();
+                } else {
+                    // Write out the changes but keep a random part of the cache
+                    stack[flushIndex]->Trim(InsecureRandRange(stack[flushIndex]->DynamicMemoryUsage() + 1));
+                    stack[flushIndex]->SelfTest();
+                    trimmed_a_cache = true;
+                }
             }
         }
         if (InsecureRandRange(100) == 0) {
@@ -253,6 +261,7 @@ BOOST_AUTO_TEST_CASE(coins_cache_simulation_test)
     BOOST_CHECK(found_an_entry);
     BOOST_CHECK(missed_an_entry);
     BOOST_CHECK(uncached_an_entry);
+    BOOST_CHECK(trimmed_a_cache);
 }
 
 // Store of all necessary tx and undo data for next test
@@ -855,4 +864,79 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_trim)
+{
+    CCoinsView root;
+    CCoinsViewCacheTest base(&root);
+    CCoinsViewCacheTest cache(&base);
+    CCoinsMap empty;
+
+    std::vector<COutPoint> outpoints;
+    for (int i = 0; i < 100; i++) {
+        outpoints.emplace_back(InsecureRand256(), 0);
+        Coin coin;
+        coin.out.nValue = i;
+        coin.out.scriptPubKey.assign(InsecureRandBits(6), 0);
+        cache.AddCoin(outpoints.back(), std::move(coin), false);
+    }
+    cache.BatchWrite(empty, {});
+
+    // Use the first ten coins again one batch later, and spend a cold one.
+    for (int i = 0; i < 10; i++) {
+        BOOST_CHECK(cache.HaveCoin(outpoints[i]));
+    }
+    BOOST_CHECK(cache.SpendCoin(outpoints[50]));
+    cache.BatchWrite(empty, {});
+
+    // Any target below the current usage evicts the whole oldest generation.
+    BOOST_CHECK(cache.Trim(cache.DynamicMemoryUsage() - 1));
+    cache.SelfTest();
+    base.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 10U);
+    for (int i = 0; i < 100; i++) {
+        BOOST_CHECK_EQUAL(cache.HaveCoinInCache(outpoints[i]), i < 10);
+        BOOST_CHECK_EQUAL(base.HaveCoinInCache(outpoints[i]), i != 50);
+    }
+    for (const auto& entry : cache.map()) {
+        BOOST_CHECK_EQUAL(entry.second.flags, 0);
+    }
+
+    // A target above the current usage only writes out the changes.
+    BOOST_CHECK(cache.SpendCoin(outpoints[0]));
+    BOOST_CHECK(cache.Trim(cache.DynamicMemoryUsage()));
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 9U);
+    BOOST_CHECK(!base.HaveCoinInCache(outpoints[0]));
+
+    // A zero target empties the cache.
+    BOOST_CHECK(cache.Trim(0));
+    cache.SelfTest();
+    BOOST_CHECK_EQUAL(cache.GetCacheSize(), 0U);
+    BOOST_CHECK_EQUAL(base.GetCacheSize(), 98U);
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_add_fetched)
+{
+    CCoinsView root;
+    CCoinsViewCacheTest cache(&root);
+    COutPoint outpoint(InsecureRand256(), 0);
+
+    Coin coin;
+    coin.out.nValue = 1;
+    coin.out.scriptPubKey.assign(InsecureRandBits(6), 0);
+    cache.AddFetchedCoin(outpoint, std::move(coin));
+    cache.SelfTest();
+    BOOST_CHECK(cache.HaveCoinInCache(outpoint));
+    BOOST_CHECK_EQUAL(cache.map().at(outpoint).flags, 0);
+
+    // An entry that is cached already is left alone.
+    BOOST_CHECK(cache.SpendCoin(outpoint));
+    Coin stale;
+    stale.out.nValue = 2;
+    cache.AddFetchedCoin(outpoint, std::move(stale));
+    cache.SelfTest();
+    BOOST_CHECK(!cache.HaveCoinInCache(outpoint));
+    BOOST_CHECK_EQUAL(cache.map().at(outpoint).flags, DIRTY);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
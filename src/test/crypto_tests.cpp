@@ -4,6 +4,8 @@
 
 #include <crypto/aes.h>
 #include <crypto/chacha20.h>
+#include <crypto/common.h>
+#include <crypto/muhash.h>
 #include <crypto/ripemd160.h>
 #include <crypto/sha1.h>
 #include <crypto/sha256.h>
@@ -11,6 +13,7 @@
 #include <crypto/hmac_sha256.h>
 #include <crypto/hmac_sha512.h>
 #include <random.h>
+#include <streams.h>
 #include <utilstrencodings.h>
 #include <test/test_bitcoin.h>
 
@@ -524,6 +527,68 @@ BOOST_AUTO_TEST_CASE(chacha20_testvector)
                  "fab78c9");
 }
 
+BOOST_AUTO_TEST_CASE(num3072_reduction)
+{
+    // p - 1, with p = 2^3072 - 1103717, is its own inverse.
+    unsigned char data[Num3072::BYTE_SIZE];
+    memset(data, 0xff, sizeof(data));
+    WriteLE32(data, 0xFFFFFFFFUL - 1103717);
+    Num3072 minus_one(data);
+    Num3072 x = minus_one;
+    x.Multiply(minus_one);
+    BOOST_CHECK_EQUAL(x.limbs[0], 1U);
+    for (int i = 1; i < Num3072::LIMBS; ++i) BOOST_CHECK_EQUAL(x.limbs[i], 0U);
+    x.SetToInverse(minus_one);
+    for (int i = 0; i < Num3072::LIMBS; ++i) BOOST_CHECK_EQUAL(x.limbs[i], minus_one.limbs[i]);
+
+    // Unreduced inputs are reduced by a multiplication: 2^3072 - 1 = 1103716 (mod p).
+    memset(data, 0xff, sizeof(data));
+    x = Num3072(data);
+    x.Multiply(Num3072());
+    BOOST_CHECK_EQUAL(x.limbs[0], 1103716U);
+    for (int i = 1; i < Num3072::LIMBS; ++i) BOOST_CHECK_EQUAL(x.limbs[i], 0U);
+}
+
+BOOST_AUTO_TEST_CASE(muhash_tests)
+{
+    const unsigned char a[] = {'a'}, b[] = {'b'}, c[] = {'c'};
+    uint256 empty, res1, res2;
+    MuHash3072().Finalize(empty);
+
+    // Insertion order does not matter.
+    MuHash3072().Insert(a, 1).Insert(b, 1).Insert(c, 1).Finalize(res1);
+    MuHash3072().Insert(c, 1).Insert(a, 1).Insert(b, 1).Finalize(res2);
+    BOOST_CHECK(res1 == res2);
+    BOOST_CHECK(res1 != empty);
+
+    // Removing what was inserted gives the empty set, in any order.
+    MuHash3072().Remove(b, 1).Insert(a, 1).Insert(b, 1).Remove(a, 1).Finalize(res1);
+    BOOST_CHECK(res1 == empty);
+
+    // Sets can be combined.
+    MuHash3072 acc;
+    acc.Insert(a, 1);
+    MuHash3072 other;
+    other.Insert(b, 1).Remove(c, 1);
+    acc *= other;
+    acc.Insert(c, 1).Finalize(res1);
+    MuHash3072().Insert(b, 1).Insert(a, 1).Finalize(res2);
+    BOOST_CHECK(res1 == res2);
+    MuHash3072().Insert(a, 1).Finalize(res2);
+    BOOST_CHECK(res1 != res2);
+
+    // A serialized state that is not finalized yet can be resumed.
+    MuHash3072 partial;
+    partial.Insert(a, 1).Remove(b, 1);
+    CDataStream ss(SER_DISK, 0);
+    ss << partial;
+    MuHash3072 resumed;
+    ss >> resumed;
+    resumed.Insert(b, 1).Finalize(res1);
+    MuHash3072().Insert(a, 1).Finalize(res2);
+    BOOST_CHECK(res1 == res2);
+}
+
 BOOST_AUTO_TEST_CASE(countbits_tests)
 {
     FastRandomContext ctx;
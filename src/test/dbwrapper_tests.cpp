@@ -197,6 +197,43 @@ BOOST_AUTO_TEST_CASE(existing_data_reindex)
     BOOST_CHECK_EQUAL(res3.ToString(), in2.ToString());
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_options)
+{
+    std::string strDB, strName;
+    int64_t nValue;
+    BOOST_CHECK(ParseDBOption("chainstate:max_open_files=1000", strDB, strName, nValue));
+    BOOST_CHECK_EQUAL(strDB, "chainstate");
+    BOOST_CHECK_EQUAL(strName, "max_open_files");
+    BOOST_CHECK_EQUAL(nValue, 1000);
+    BOOST_CHECK(!ParseDBOption("chainstate:max_open_files", strDB, strName, nValue));
+    BOOST_CHECK(!ParseDBOption("chainstate:max_open_files=-1", strDB, strName, nValue));
+    BOOST_CHECK(!ParseDBOption("chainstate:max_open_files=many", strDB, strName, nValue));
+    BOOST_CHECK(!ParseDBOption("chainstate:no_such_option=1", strDB, strName, nValue));
+    BOOST_CHECK(!ParseDBOption("wallet:max_open_files=1", strDB, strName, nValue));
+    BOOST_CHECK(!ParseDBOption("max_open_files=1", strDB, strName, nValue));
+
+    // Settings only apply to the database they name, and only named databases are reported.
+    gArgs.ForceSetArg("-dboption", "blockindex:bloom_bits=0");
+    fs::path ph = fs::temp_directory_path() / fs::unique_path();
+    {
+        CDBWrapper dbw(ph, (1 << 20), true, false, false, "blockindex");
+        CDBWrapper dbw_other(ph / "other", (1 << 20), true, false, false, "sporks");
+        CDBWrapper dbw_unnamed(ph / "unnamed", (1 << 20), true, false, false);
+        BOOST_CHECK(dbw.Write('k', uint256()));
+
+        std::vector<DBWrapperInfo> vInfo = GetDBWrapperInfo(true);
+        BOOST_CHECK_EQUAL(vInfo.size(), 2U);
+        for (const DBWrapperInfo& info : vInfo) {
+            BOOST_CHECK_EQUAL(info.nBloomBits, info.name == "blockindex" ? 0 : 10);
+            BOOST_CHECK_EQUAL(info.nBlockCacheSize, (1U << 20) / 2);
+            BOOST_CHECK(!info.vFilesPerLevel.empty());
+            BOOST_CHECK(!info.strStats.empty());
+        }
+    }
+    BOOST_CHECK(GetDBWrapperInfo(false).empty());
+    gArgs.ForceSetArg("-dboption", "");
+}
+
 BOOST_AUTO_TEST_CASE(iterator_ordering)
 {
     fs::path ph = fs::temp_directory_path() / fs::unique_path();
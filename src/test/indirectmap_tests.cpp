@@ -0,0 +1,69 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <indirectmap.h>
+
+#include <test/test_bitcoin.h>
+
+#include <map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(indirectmap_tests, BasicTestingSetup)
+
+namespace {
+// Few distinct hashes, so that long probe sequences and wrap-around are exercised.
+struct CollidingHasher
+{
+    size_t operator()(const int& key) const { return (size_t)key % 5 * 7; }
+};
+} // namespace
+
+BOOST_AUTO_TEST_CASE(indirectmap_random)
+{
+    // Keys are compared by value, so separate copies of them are used for lookups.
+    std::vector<int> keys(300);
+    for (size_t i = 0; i < keys.size(); i++) {
+        keys[i] = i;
+    }
+
+    indirectmap<int, int, CollidingHasher> map;
+    std::map<int, int> expected;
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.find(1) == map.end());
+
+    for (int i = 0; i < 20000; i++) {
+        int key = InsecureRandRange(keys.size());
+        if (InsecureRandBool()) {
+            int value = InsecureRand32();
+            bool fInserted = map.insert(std::make_pair(&keys[key], value)).second;
+            BOOST_CHECK_EQUAL(fInserted, expected.emplace(key, value).second);
+        } else {
+            BOOST_CHECK_EQUAL(map.erase(key), expected.erase(key));
+        }
+        BOOST_CHECK_EQUAL(map.size(), expected.size());
+        BOOST_CHECK(map.capacity() * 3 >= map.size() * 4);
+
+        if (i % 100 == 0) {
+            for (const auto& entry : expected) {
+                auto it = map.find(entry.first);
+                BOOST_CHECK(it != map.end() && it->first == &keys[entry.first] && it->second == entry.second);
+            }
+            size_t nIterated = 0;
+            for (auto it = map.cbegin(); it != map.cend(); ++it) {
+                BOOST_CHECK(expected.count(*it->first));
+                nIterated++;
+            }
+            BOOST_CHECK_EQUAL(nIterated, expected.size());
+        }
+    }
+
+    map.clear();
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK_EQUAL(map.capacity(), 0U);
+    BOOST_CHECK_EQUAL(map.count(keys[0]), 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -287,6 +287,19 @@ BOOST_AUTO_TEST_CASE(MempoolIndexingTest)
 
     pool.removeRecursive(pool.mapTx.find(tx9.GetHash())->GetTx());
     pool.removeRecursive(pool.mapTx.find(tx8.GetHash())->GetTx());
+
+    // Keys looked up in one go order transactions like CompareDepthAndScore does
+    std::vector<uint256> vtxid;
+    pool.queryHashes(vtxid);
+    vtxid.push_back(InsecureRand256()); // not in the mempool
+    std::vector<std::pair<uint256, DepthAndScore>> vKeys;
+    pool.GetDepthAndScore(vtxid, vKeys);
+    BOOST_CHECK_EQUAL(vKeys.size(), pool.size());
+    for (const auto& a : vKeys) {
+        for (const auto& b : vKeys) {
+            BOOST_CHECK_EQUAL(CompareDepthAndScoreKeys()(a, b), pool.CompareDepthAndScore(a.first, b.first));
+        }
+    }
 }
 
 BOOST_AUTO_TEST_CASE(MempoolAncestorIndexingTest)
@@ -533,7 +546,9 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
         pool.addUnchecked(tx5.GetHash(), entry.Fee(1000LL).FromTx(tx5));
     pool.addUnchecked(tx7.GetHash(), entry.Fee(9000LL).FromTx(tx7));
 
-    pool.TrimToSize(pool.DynamicMemoryUsage() / 2); // should maximize mempool size by only removing 5/7
+    // The four transactions take the same space, but a trimmed pool keeps some
+    // fixed overhead (e.g. vTxHashes' capacity), so allow a little over half.
+    pool.TrimToSize(pool.DynamicMemoryUsage() * 3 / 5); // should maximize mempool size by only removing 5/7
     BOOST_CHECK(pool.exists(tx4.GetHash()));
     BOOST_CHECK(!pool.exists(tx5.GetHash()));
     BOOST_CHECK(pool.exists(tx6.GetHash()));
@@ -187,4 +187,47 @@ BOOST_AUTO_TEST_CASE(cnode_simple_test)
     BOOST_CHECK(pnode2->fFeeler == false);
 }
 
+BOOST_AUTO_TEST_CASE(cnode_inventory_known_size)
+{
+    in_addr ipv4Addr;
+    ipv4Addr.s_addr = 0xa0b0c001;
+    CAddress addr = CAddress(CService(ipv4Addr, 7777), NODE_NETWORK);
+    std::unique_ptr<CNode> pnode(new CNode(0, NODE_NETWORK, 0, INVALID_SOCKET, addr, 0, 0, CAddress(), "", false));
+
+    LOCK(pnode->cs_inventory);
+    BOOST_CHECK_EQUAL(pnode->nInventoryKnownElements, MIN_INVENTORY_KNOWN_ELEMENTS);
+    int64_t nNow = GetTimeMicros();
+    pnode->UpdateInventoryKnownSize(nNow);
+
+    // A busy peer gets the largest filter
+    for (int i = 0; i < 10000; i++) pnode->InsertInventoryKnown(InsecureRand256());
+    nNow += INVENTORY_KNOWN_RESIZE_INTERVAL * 1000000;
+    pnode->UpdateInventoryKnownSize(nNow);
+    BOOST_CHECK_EQUAL(pnode->nInventoryKnownElements, MAX_INVENTORY_KNOWN_ELEMENTS);
+
+    // A quiet interval shrinks it back down
+    nNow += INVENTORY_KNOWN_RESIZE_INTERVAL * 1000000;
+    pnode->UpdateInventoryKnownSize(nNow);
+    BOOST_CHECK_EQUAL(pnode->nInventoryKnownElements, MIN_INVENTORY_KNOWN_ELEMENTS);
+
+    // A moderate rate gets an hour's worth
+    const unsigned int nModerate = 2000U * 60 * 60 / INVENTORY_KNOWN_RESIZE_INTERVAL;
+    for (int i = 0; i < 2000; i++) pnode->InsertInventoryKnown(InsecureRand256());
+    nNow += INVENTORY_KNOWN_RESIZE_INTERVAL * 1000000;
+    pnode->UpdateInventoryKnownSize(nNow);
+    BOOST_CHECK_EQUAL(pnode->nInventoryKnownElements, nModerate);
+
+    // ... and is not shrunk for a slightly lower one
+    for (int i = 0; i < 1500; i++) pnode->InsertInventoryKnown(InsecureRand256());
+    nNow += INVENTORY_KNOWN_RESIZE_INTERVAL * 1000000;
+    pnode->UpdateInventoryKnownSize(nNow);
+    BOOST_CHECK_EQUAL(pnode->nInventoryKnownElements, nModerate);
+
+    // Filling the filter up triggers a resize before the interval is over
+    for (unsigned int i = 0; i < nModerate; i++) pnode->InsertInventoryKnown(InsecureRand256());
+    nNow += 60 * 1000000;
+    pnode->UpdateInventoryKnownSize(nNow);
+    BOOST_CHECK_EQUAL(pnode->nInventoryKnownElements, MAX_INVENTORY_KNOWN_ELEMENTS);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -2,8 +2,11 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <clientversion.h>
+#include <fs.h>
 #include <policy/policy.h>
 #include <policy/fees.h>
+#include <streams.h>
 #include <txmempool.h>
 #include <uint256.h>
 #include <util.h>
@@ -177,6 +180,24 @@ BOOST_AUTO_TEST_CASE(BlockPolicyEstimates)
     for (int i = 2; i < 9; i++) { // At 9, the original estimate was already at the bottom (b/c scale = 2)
         BOOST_CHECK(feeEst.estimateFee(i).GetFeePerK() < origFeeEst[i-1] - deltaFee);
     }
+
+    // Estimates survive a round trip through the estimates file
+    BOOST_CHECK(feeEst.IsDirty());
+    fs::path est_path = fs::temp_directory_path() / fs::unique_path();
+    {
+        CAutoFile est_fileout(fsbridge::fopen(est_path, "wb"), SER_DISK, CLIENT_VERSION);
+        BOOST_CHECK(feeEst.Write(est_fileout));
+    }
+    BOOST_CHECK(!feeEst.IsDirty());
+    CBlockPolicyEstimator feeEstRead;
+    CAutoFile est_filein(fsbridge::fopen(est_path, "rb"), SER_DISK, CLIENT_VERSION);
+    BOOST_CHECK(feeEstRead.Read(est_filein));
+    est_filein.fclose();
+    fs::remove(est_path);
+    for (int i = 1; i < 50; i++) {
+        BOOST_CHECK(feeEstRead.estimateSmartFee(i, nullptr, false) == feeEst.estimateSmartFee(i, nullptr, false));
+        BOOST_CHECK(feeEstRead.estimateSmartFee(i, nullptr, true) == feeEst.estimateSmartFee(i, nullptr, true));
+    }
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,11 +3,15 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <rpc/server.h>
+#include <rpc/blockchain.h>
 #include <rpc/client.h>
+#include <rpc/jsonstream.h>
 
 #include <base58.h>
+#include <chainparams.h>
 #include <core_io.h>
 #include <netbase.h>
+#include <validation.h>
 
 #include <test/test_bitcoin.h>
 
@@ -345,4 +349,82 @@ BOOST_AUTO_TEST_CASE(rpc_convert_values_generatetoaddress)
     BOOST_CHECK_EQUAL(result[2].get_int(), 9);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_batch_order)
+{
+    SetRPCWarmupFinished();
+    BOOST_CHECK(StartRPC());
+
+    // Concurrent calls around one that is not, and one that fails
+    UniValue vReq(UniValue::VARR);
+    for (int i = 0; i < 20; i++) {
+        UniValue params(UniValue::VARR);
+        params.push_back(i);
+        vReq.push_back(JSONRPCRequestObj(i == 10 ? "getnetworkinfo" : i == 15 ? "nosuchmethod" : "echo", params, i));
+    }
+    JSONRPCRequest jreq;
+    UniValue vReply;
+    BOOST_CHECK(vReply.read(JSONRPCExecBatch(jreq, vReq)));
+    BOOST_CHECK_EQUAL(vReply.size(), 20U);
+    for (int i = 0; i < 20; i++) {
+        BOOST_CHECK_EQUAL(find_value(vReply[i], "id").get_int(), i);
+        if (i == 10 || i == 15) {
+            BOOST_CHECK(find_value(vReply[i], "error").isObject());
+        } else {
+            BOOST_CHECK_EQUAL(find_value(vReply[i], "result")[0].get_int(), i);
+        }
+    }
+
+    InterruptRPC();
+    StopRPC();
+}
+
+static void WriteStreamed(JSONStreamWriter& writer, const UniValue& val)
+{
+    if (val.isObject()) {
+        writer.BeginObject();
+        for (size_t i = 0; i < val.size(); i++) {
+            writer.Key(val.getKeys()[i]);
+            WriteStreamed(writer, val.getValues()[i]);
+        }
+        writer.EndObject();
+    } else if (val.isArray()) {
+        writer.BeginArray();
+        for (size_t i = 0; i < val.size(); i++) {
+            WriteStreamed(writer, val[i]);
+        }
+        writer.EndArray();
+    } else {
+        writer.Value(val);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(rpc_jsonstream)
+{
+    UniValue val;
+    BOOST_CHECK(val.read("{\"a\":[1,\"x\\\"y\",[],{},null,true],\"b\":{\"c\":{\"d\":[[2.5]]}},\"e\\n\":\"\"}"));
+    for (size_t nChunkSize : {(size_t)1, (size_t)8, JSON_STREAM_CHUNK_SIZE}) {
+        std::string strOut;
+        int nChunks = 0;
+        JSONStreamWriter writer([&](const std::string& strChunk) {
+            strOut += strChunk;
+            nChunks++;
+        }, nChunkSize);
+        WriteStreamed(writer, val);
+        BOOST_CHECK(nChunkSize == JSON_STREAM_CHUNK_SIZE ? !writer.Flushed() : writer.Flushed());
+        writer.Finish();
+        BOOST_CHECK_EQUAL(strOut, val.write() + "\n");
+        BOOST_CHECK(nChunkSize == JSON_STREAM_CHUNK_SIZE ? nChunks == 1 : nChunks > 1);
+    }
+
+    // Streamed blocks are the same as whole ones
+    LOCK(cs_main);
+    CBlock block;
+    BOOST_CHECK(ReadBlockFromDisk(block, chainActive.Tip(), Params().GetConsensus()));
+    std::string strBlock;
+    JSONStreamWriter writer([&](const std::string& strChunk) { strBlock += strChunk; }, 1);
+    blockToJSONStream(block, blockToJSON(block, chainActive.Tip(), false), writer);
+    writer.Finish();
+    BOOST_CHECK_EQUAL(strBlock, blockToJSON(block, chainActive.Tip(), true).write() + "\n");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txrelaycache.h>
+
+#include <test/test_bitcoin.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(txrelaycache_tests, BasicTestingSetup)
+
+static CTransactionRef MakeTx(unsigned int n)
+{
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vin[0].prevout = COutPoint(InsecureRand256(), n);
+    mtx.vout.resize(1);
+    mtx.vout[0].nValue = n;
+    return MakeTransactionRef(mtx);
+}
+
+BOOST_AUTO_TEST_CASE(txrelaycache_expiry)
+{
+    CTxRelayCache cache(1000000);
+    CTransactionRef tx1 = MakeTx(1);
+    CTransactionRef tx2 = MakeTx(2);
+
+    cache.Add(tx1, 0);
+    cache.Add(tx1, 1);
+    cache.Add(tx2, RELAY_TX_CACHE_TIME / 2);
+    BOOST_CHECK_EQUAL(cache.GetStats().nTransactions, 2U);
+    BOOST_CHECK(cache.Get(tx1->GetHash()) == tx1);
+    BOOST_CHECK(!cache.Get(MakeTx(3)->GetHash()));
+
+    // Expiry happens as new transactions come in
+    cache.Add(MakeTx(4), RELAY_TX_CACHE_TIME + 1);
+    BOOST_CHECK(!cache.Get(tx1->GetHash()));
+    BOOST_CHECK(cache.Get(tx2->GetHash()) == tx2);
+
+    TxRelayCacheStats stats = cache.GetStats();
+    BOOST_CHECK_EQUAL(stats.nTransactions, 2U);
+    BOOST_CHECK_EQUAL(stats.nHits, 2U);
+    BOOST_CHECK_EQUAL(stats.nMisses, 2U);
+    BOOST_CHECK_EQUAL(stats.nEvicted, 0U);
+}
+
+BOOST_AUTO_TEST_CASE(txrelaycache_limit)
+{
+    CTxRelayCache cache(1000000);
+    std::vector<CTransactionRef> vTxs;
+    for (unsigned int i = 0; i < 100; i++) {
+        vTxs.push_back(MakeTx(i));
+        cache.Add(vTxs.back(), i);
+    }
+    const size_t nUsage = cache.GetStats().nUsage;
+    BOOST_CHECK(nUsage > 0);
+
+    // Shrinking drops the oldest transactions first
+    cache.SetMaxUsage(nUsage / 2);
+    TxRelayCacheStats stats = cache.GetStats();
+    BOOST_CHECK(stats.nUsage <= nUsage / 2);
+    BOOST_CHECK(stats.nTransactions < 100 && stats.nTransactions > 0);
+    BOOST_CHECK_EQUAL(stats.nEvicted, 100 - stats.nTransactions);
+    BOOST_CHECK(!cache.Get(vTxs.front()->GetHash()));
+    BOOST_CHECK(cache.Get(vTxs.back()->GetHash()) == vTxs.back());
+
+    // Adding stays within the limit
+    for (unsigned int i = 100; i < 200; i++) {
+        cache.Add(MakeTx(i), i);
+    }
+    stats = cache.GetStats();
+    BOOST_CHECK(stats.nUsage <= nUsage / 2);
+    BOOST_CHECK_EQUAL(stats.nEvicted + stats.nTransactions, 200U);
+
+    // A transaction larger than the cache is not kept
+    cache.SetMaxUsage(0);
+    cache.Add(MakeTx(200), 200);
+    BOOST_CHECK_EQUAL(cache.GetStats().nTransactions, 0U);
+    BOOST_CHECK_EQUAL(cache.GetStats().nUsage, 0U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
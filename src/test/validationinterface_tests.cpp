@@ -0,0 +1,77 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <primitives/transaction.h>
+#include <test/test_bitcoin.h>
+#include <validationinterface.h>
+
+#include <atomic>
+#include <future>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, TestingSetup)
+
+struct CountingSubscriber : public CValidationInterface {
+    std::atomic<int> m_count{0};
+    std::shared_future<void> m_release;
+    const std::string m_name;
+
+    explicit CountingSubscriber(const std::string& name) : m_name(name) {}
+
+protected:
+    void TransactionAddedToMempool(const CTransactionRef& ptx) override
+    {
+        if (m_release.valid()) m_release.wait();
+        m_count++;
+    }
+    std::string GetSubscriberName() const override { return m_name; }
+};
+
+BOOST_AUTO_TEST_CASE(slow_subscriber_does_not_delay_others)
+{
+    std::promise<void> release;
+    CountingSubscriber slow("slow"), fast("fast"), unregistered("unregistered");
+    slow.m_release = release.get_future().share();
+    RegisterValidationInterface(&slow);
+    RegisterValidationInterface(&fast);
+    RegisterValidationInterface(&unregistered);
+    UnregisterValidationInterface(&unregistered);
+
+    const CTransactionRef ptx = MakeTransactionRef(CMutableTransaction());
+    for (int i = 0; i < 3; i++) {
+        GetMainSignals().TransactionAddedToMempool(ptx);
+    }
+
+    // The fast listener gets all notifications while the slow one is stuck on the first
+    int64_t nTimeout = GetTimeMillis() + 10 * 1000;
+    while (fast.m_count < 3) {
+        BOOST_REQUIRE(GetTimeMillis() < nTimeout);
+        MilliSleep(10);
+    }
+    BOOST_CHECK_EQUAL(slow.m_count, 0);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 2U);
+
+    uint64_t nLimitWaits;
+    int64_t nLimitWaitTime;
+    std::vector<ValidationQueueStats> vStats = GetMainSignals().GetQueueStats(nLimitWaits, nLimitWaitTime);
+    BOOST_REQUIRE_EQUAL(vStats.size(), 2U);
+    BOOST_CHECK_EQUAL(vStats[0].name, "slow");
+    BOOST_CHECK_EQUAL(vStats[0].nPending, 2U);
+    BOOST_CHECK_EQUAL(vStats[1].name, "fast");
+    BOOST_CHECK_EQUAL(vStats[1].nPending, 0U);
+    BOOST_CHECK_EQUAL(vStats[1].nProcessed, 3U);
+
+    // Waiting for the queues covers the slow listener too
+    release.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(slow.m_count, 3);
+    BOOST_CHECK_EQUAL(unregistered.m_count, 0);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 0U);
+
+    UnregisterValidationInterface(&slow);
+    UnregisterValidationInterface(&fast);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
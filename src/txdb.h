@@ -7,6 +7,7 @@
 #define BITCOIN_TXDB_H
 
 #include <coins.h>
+#include <coinstats.h>
 #include <dbwrapper.h>
 #include <chain.h>
 
@@ -24,18 +25,16 @@ class uint256;
 static constexpr int MAX_BLOCK_COINSDB_USAGE = 10;
 //! -dbcache default (MiB)
 static const int64_t nDefaultDbCache = 450;
+//! -dbcachetrim default (percent of the in-memory UTXO cache kept warm when it fills up)
+static const int64_t nDefaultDbCacheTrim = 50;
 //! -dbbatchsize default (bytes)
 static const int64_t nDefaultDbBatchSize = 16 << 20;
 //! max. -dbcache (MiB)
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 16384 : 1024;
 //! min. -dbcache (MiB)
 static const int64_t nMinDbCache = 4;
-//! Max memory allocated to block tree DB specific cache, if no -txindex (MiB)
+//! Max memory allocated to block tree DB specific cache (MiB)
 static const int64_t nMaxBlockDBCache = 2;
-//! Max memory allocated to block tree DB specific cache, if -txindex (MiB)
-// Unlike for the UTXO database, for the txindex scenario the leveldb cache make
-// a meaningful difference: https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
-static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
 
@@ -69,6 +68,8 @@ class CCoinsViewDB final : public CCoinsView
 {
 protected:
     CDBWrapper db;
+    //! UTXO set statistics to write in the final batch of the next BatchWrite
+    std::unique_ptr<CRollingCoinsStats> pstatsPending;
 public:
     explicit CCoinsViewDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
 
@@ -79,6 +80,16 @@ public:
     bool BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) override;
     CCoinsViewCursor *Cursor() const override;
 
+    //! Bulk-write coins loaded from a UTXO snapshot taken at hashBlock. The
+    //! database is only marked as consistent with hashBlock once a call with
+    //! fFinal set has succeeded.
+    bool WriteSnapshotCoins(const std::vector<std::pair<COutPoint, Coin>>& vCoins, const uint256& hashBlock, bool fFinal);
+
+    //! Have the next BatchWrite store stats along with its best block, if they are for that block.
+    void SetCoinsStats(const CRollingCoinsStats& stats);
+    //! Read the UTXO set statistics last stored; check their hashBlock against the best block.
+    bool ReadCoinsStats(CRollingCoinsStats& stats) const;
+
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
     size_t EstimateSize() const override;
@@ -120,10 +131,10 @@ public:
     bool ReadLastBlockFile(int &nFile);
     bool WriteReindexing(bool fReindexing);
     bool ReadReindexing(bool &fReindexing);
-    bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
-    bool WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> > &vect);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    bool WriteMempoolKey(const uint256 &key);
+    bool ReadMempoolKey(uint256 &key);
     bool LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex);
 };
 
@@ -6,6 +6,9 @@
 #ifndef BITCOIN_TXMEMPOOL_H
 #define BITCOIN_TXMEMPOOL_H
 
+#include <algorithm>
+#include <assert.h>
+#include <atomic>
 #include <memory>
 #include <set>
 #include <map>
@@ -17,6 +20,7 @@
 #include <coins.h>
 #include <indirectmap.h>
 #include <policy/feerate.h>
+#include <prevector.h>
 #include <primitives/transaction.h>
 #include <sync.h>
 #include <random.h>
@@ -128,6 +132,7 @@ public:
     int64_t GetSigOpCostWithAncestors() const { return nSigOpCostWithAncestors; }
 
     mutable size_t vTxHashesIdx; //!< Index in mempool's vTxHashes
+    mutable uint64_t m_epoch; //!< Last epoch in which this entry was visited by a mempool graph walk
 };
 
 // Helpers for modifying CTxMemPool::mapTx, which is a boost multi_index.
@@ -348,6 +353,32 @@ enum class MemPoolRemovalReason {
     REPLACED     //! Removed for replacement
 };
 
+/** What CTxMemPool::CompareDepthAndScore compares, looked up for one transaction */
+struct DepthAndScore
+{
+    uint64_t nCountWithAncestors;
+    CAmount nModFee;
+    size_t nTxSize;
+};
+
+/** Orders (txid, DepthAndScore) pairs the way CTxMemPool::CompareDepthAndScore orders txids */
+class CompareDepthAndScoreKeys
+{
+public:
+    bool operator()(const std::pair<uint256, DepthAndScore>& a, const std::pair<uint256, DepthAndScore>& b) const
+    {
+        if (a.second.nCountWithAncestors != b.second.nCountWithAncestors) {
+            return a.second.nCountWithAncestors < b.second.nCountWithAncestors;
+        }
+        double f1 = (double)a.second.nModFee * b.second.nTxSize;
+        double f2 = (double)b.second.nModFee * a.second.nTxSize;
+        if (f1 == f2) {
+            return b.first < a.first;
+        }
+        return f1 > f2;
+    }
+};
+
 class SaltedTxidHasher
 {
 private:
@@ -446,6 +477,15 @@ private:
     mutable int64_t lastRollingFeeUpdate;
     mutable bool blockSinceLastRollingFeeBump;
     mutable double rollingMinimumFeeRate; //!< minimum fee to get into the pool, decreases exponentially
+    // Copies of the statistics of the mempool as of its last change, for
+    // readers that must not wait for cs (see GetStatsNoLock)
+    std::atomic<uint64_t> m_stats_size{0};
+    std::atomic<uint64_t> m_stats_bytes{0};
+    std::atomic<uint64_t> m_stats_usage{0};
+    mutable std::atomic<CAmount> m_stats_min_fee{0}; //!< as last returned by GetMinFee
+
+    mutable uint64_t m_epoch; //!< Current graph walk epoch, see EpochGuard
+    mutable bool m_has_epoch_guard; //!< Whether a graph walk is in progress
 
     void trackPackageRemoved(const CFeeRate& rate);
 
@@ -491,27 +531,57 @@ public:
         }
     };
     typedef std::set<txiter, CompareIteratorByHash> setEntries;
+    /**
+     * Direct in-mempool parents or children of an entry, sorted by txid.
+     * Most transactions have only one or two of either, which are stored
+     * inline without a heap allocation.
+     */
+    typedef prevector<2, txiter> linkEntries;
 
-    const setEntries & GetMemPoolParents(txiter entry) const;
-    const setEntries & GetMemPoolChildren(txiter entry) const;
+    const linkEntries & GetMemPoolParents(txiter entry) const;
+    const linkEntries & GetMemPoolChildren(txiter entry) const;
 private:
-    typedef std::map<txiter, setEntries, CompareIteratorByHash> cacheMap;
+    typedef std::map<txiter, std::vector<txiter>, CompareIteratorByHash> cacheMap;
 
     struct TxLinks {
-        setEntries parents;
-        setEntries children;
+        linkEntries parents;
+        linkEntries children;
     };
 
     typedef std::map<txiter, TxLinks, CompareIteratorByHash> txlinksMap;
     txlinksMap mapLinks;
 
+    void UpdateLinks(linkEntries &links, txiter item, bool add);
     void UpdateParent(txiter entry, txiter parent, bool add);
     void UpdateChild(txiter entry, txiter child, bool add);
 
     std::vector<indexed_transaction_set::const_iterator> GetSortedDepthAndScore() const;
 
+    /**
+     * Graph walks over mapLinks mark the entries they reach with the current
+     * epoch instead of collecting them in a setEntries, which saves a tree
+     * node allocation and an O(log n) lookup per visited entry. An EpochGuard
+     * starts a fresh epoch for the duration of one walk; walks cannot nest.
+     */
+    class EpochGuard
+    {
+        const CTxMemPool& pool;
+    public:
+        explicit EpochGuard(const CTxMemPool& in);
+        ~EpochGuard();
+    };
+
+    /** Mark it as visited in the current epoch. Returns whether it had been visited already. */
+    bool visited(txiter it) const
+    {
+        assert(m_has_epoch_guard);
+        bool ret = it->m_epoch >= m_epoch;
+        it->m_epoch = std::max(it->m_epoch, m_epoch);
+        return ret;
+    }
+
 public:
-    indirectmap<COutPoint, const CTransaction*> mapNextTx;
+    indirectmap<COutPoint, const CTransaction*, SaltedOutpointHasher> mapNextTx;
     std::map<uint256, CAmount> mapDeltas;
 
     /** Create a new CTxMemPool.
@@ -545,6 +615,10 @@ public:
     void clear();
     void _clear(); //lock free
     bool CompareDepthAndScore(const uint256& hasha, const uint256& hashb);
+    /** Append the DepthAndScore of each of vHashes that is in the mempool to
+     *  vKeys, taking the lock once, so that many transactions can be ordered
+     *  without a lookup per comparison. */
+    void GetDepthAndScore(const std::vector<uint256>& vHashes, std::vector<std::pair<uint256, DepthAndScore>>& vKeys) const;
     void queryHashes(std::vector<uint256>& vtxid);
     bool isSpent(const COutPoint& outpoint);
     unsigned int GetTransactionsUpdated() const;
@@ -642,6 +716,12 @@ public:
 
     size_t DynamicMemoryUsage() const;
 
+    /** The number of transactions, their total size and the memory usage as
+     *  of the last change to the mempool, and the minimum fee last computed by
+     *  GetMinFee. Does not wait for cs, so the values are not necessarily from
+     *  the same moment. */
+    void GetStatsNoLock(uint64_t& nSize, uint64_t& nBytes, uint64_t& nUsage, CFeeRate& minFee) const;
+
     boost::signals2::signal<void (CTransactionRef)> NotifyEntryAdded;
     boost::signals2::signal<void (CTransactionRef, MemPoolRemovalReason)> NotifyEntryRemoved;
 
@@ -672,6 +752,10 @@ private:
     void UpdateForRemoveFromMempool(const setEntries &entriesToRemove, bool updateDescendants);
     /** Sever link between specified transaction and direct children. */
     void UpdateChildrenForRemoval(txiter entry);
+    /** Update the copies of the statistics read by GetStatsNoLock */
+    void UpdateStatsNoLock();
+    /** GetMinFee, with cs held */
+    CFeeRate GetMinFeeInternal(size_t sizelimit) const;
 
     /** Before calling removeUnchecked for a given transaction,
      *  UpdateForRemoveFromMempool must be called on the entire (dependent) set
@@ -0,0 +1,232 @@
+// Copyright (c) 2009-2010 Satoshi Nakamoto
+// Copyright (c) 2009-2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txorphanpool.h>
+
+#include <consensus/validation.h>
+#include <core_memusage.h>
+#include <policy/policy.h>
+#include <random.h>
+#include <util.h>
+#include <utiltime.h>
+
+CTxOrphanPool::CTxOrphanPool() : nTotalUsage(0), nNextSweep(0)
+{
+}
+
+bool CTxOrphanPool::AddTx(const CTransactionRef& tx, NodeId peer)
+{
+    LOCK(cs);
+    const uint256& hash = tx->GetHash();
+    if (mapOrphans.count(hash))
+        return false;
+
+    // Ignore big transactions, to avoid a
+    // send-big-orphans memory exhaustion attack. If a peer has a legitimate
+    // large transaction with a missing parent then we assume
+    // it will rebroadcast it later, after the parent transaction(s)
+    // have been mined or received.
+    // 100 orphans, each of which is at most 99,999 bytes big is
+    // at most 10 megabytes of orphans and somewhat more byprev index (in the worst case):
+    unsigned int sz = GetTransactionWeight(*tx);
+    if (sz >= MAX_STANDARD_TX_WEIGHT)
+    {
+        LogPrint(BCLog::MEMPOOL, "ignoring large orphan tx (size: %u, hash: %s)\n", sz, hash.ToString());
+        return false;
+    }
+
+    // A single peer may only take its share of the pool
+    const size_t nUsage = RecursiveDynamicUsage(tx);
+    size_t& nPeerUsage = mapPeerUsage[peer];
+    if (nPeerUsage + nUsage > MAX_PEER_ORPHAN_BYTES) {
+        LogPrint(BCLog::MEMPOOL, "ignoring orphan tx %s, peer=%d has too many orphans\n", hash.ToString(), peer);
+        if (nPeerUsage == 0) mapPeerUsage.erase(peer);
+        return false;
+    }
+
+    auto ret = mapOrphans.emplace(hash, OrphanTx{tx, peer, GetTime() + ORPHAN_TX_EXPIRE_TIME, nUsage, vOrphanList.size()});
+    assert(ret.second);
+    vOrphanList.push_back(ret.first);
+    for (const CTxIn& txin : tx->vin) {
+        mapOrphansByPrev[txin.prevout].insert(ret.first);
+    }
+    nPeerUsage += nUsage;
+    nTotalUsage += nUsage;
+
+    LogPrint(BCLog::MEMPOOL, "stored orphan tx %s (mapsz %u outsz %u)\n", hash.ToString(),
+             mapOrphans.size(), mapOrphansByPrev.size());
+    return true;
+}
+
+bool CTxOrphanPool::HaveTx(const uint256& txid) const
+{
+    LOCK(cs);
+    return mapOrphans.count(txid);
+}
+
+int CTxOrphanPool::EraseTx(const uint256& txid)
+{
+    LOCK(cs);
+    return EraseTxInternal(txid);
+}
+
+int CTxOrphanPool::EraseTxInternal(const uint256& txid)
+{
+    std::map<uint256, OrphanTx>::iterator it = mapOrphans.find(txid);
+    if (it == mapOrphans.end())
+        return 0;
+    for (const CTxIn& txin : it->second.tx->vin)
+    {
+        auto itPrev = mapOrphansByPrev.find(txin.prevout);
+        if (itPrev == mapOrphansByPrev.end())
+            continue;
+        itPrev->second.erase(it);
+        if (itPrev->second.empty())
+            mapOrphansByPrev.erase(itPrev);
+    }
+
+    // Move the last orphan in the list into the erased one's position
+    const size_t nListPos = it->second.nListPos;
+    vOrphanList[nListPos] = vOrphanList.back();
+    vOrphanList[nListPos]->second.nListPos = nListPos;
+    vOrphanList.pop_back();
+
+    auto itPeer = mapPeerUsage.find(it->second.fromPeer);
+    assert(itPeer != mapPeerUsage.end() && itPeer->second >= it->second.nUsage);
+    itPeer->second -= it->second.nUsage;
+    if (itPeer->second == 0) mapPeerUsage.erase(itPeer);
+    nTotalUsage -= it->second.nUsage;
+
+    // Entries left in work sets are skipped when they come up.
+    mapOrphans.erase(it);
+    return 1;
+}
+
+void CTxOrphanPool::EraseForPeer(NodeId peer)
+{
+    LOCK(cs);
+    mapWorkSet.erase(peer);
+    if (!mapPeerUsage.count(peer)) return;
+
+    int nErased = 0;
+    std::map<uint256, OrphanTx>::iterator iter = mapOrphans.begin();
+    while (iter != mapOrphans.end())
+    {
+        std::map<uint256, OrphanTx>::iterator maybeErase = iter++; // increment to avoid iterator becoming invalid
+        if (maybeErase->second.fromPeer == peer)
+        {
+            nErased += EraseTxInternal(maybeErase->first);
+        }
+    }
+    if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx from peer=%d\n", nErased, peer);
+}
+
+void CTxOrphanPool::EraseForBlock(const CBlock& block)
+{
+    LOCK(cs);
+
+    std::vector<uint256> vOrphanErase;
+
+    for (const CTransactionRef& ptx : block.vtx) {
+        const CTransaction& tx = *ptx;
+
+        // Which orphan pool entries must we evict?
+        for (const auto& txin : tx.vin) {
+            auto itByPrev = mapOrphansByPrev.find(txin.prevout);
+            if (itByPrev == mapOrphansByPrev.end()) continue;
+            for (auto mi = itByPrev->second.begin(); mi != itByPrev->second.end(); ++mi) {
+                vOrphanErase.push_back((*mi)->first);
+            }
+        }
+    }
+
+    // Erase orphan transactions included or precluded by this block
+    if (vOrphanErase.size()) {
+        int nErased = 0;
+        for (const uint256& orphanHash : vOrphanErase) {
+            nErased += EraseTxInternal(orphanHash);
+        }
+        LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx included or conflicted by block\n", nErased);
+    }
+}
+
+unsigned int CTxOrphanPool::LimitOrphans(unsigned int nMaxOrphans, size_t nMaxBytes)
+{
+    LOCK(cs);
+
+    unsigned int nEvicted = 0;
+    int64_t nNow = GetTime();
+    if (nNextSweep <= nNow) {
+        // Sweep out expired orphan pool entries:
+        int nErased = 0;
+        int64_t nMinExpTime = nNow + ORPHAN_TX_EXPIRE_TIME - ORPHAN_TX_EXPIRE_INTERVAL;
+        std::map<uint256, OrphanTx>::iterator iter = mapOrphans.begin();
+        while (iter != mapOrphans.end())
+        {
+            std::map<uint256, OrphanTx>::iterator maybeErase = iter++;
+            if (maybeErase->second.nTimeExpire <= nNow) {
+                nErased += EraseTxInternal(maybeErase->first);
+            } else {
+                nMinExpTime = std::min(maybeErase->second.nTimeExpire, nMinExpTime);
+            }
+        }
+        // Sweep again 5 minutes after the next entry that expires in order to batch the linear scan.
+        nNextSweep = nMinExpTime + ORPHAN_TX_EXPIRE_INTERVAL;
+        if (nErased > 0) LogPrint(BCLog::MEMPOOL, "Erased %d orphan tx due to expiration\n", nErased);
+    }
+    while (mapOrphans.size() > nMaxOrphans || nTotalUsage > nMaxBytes)
+    {
+        // Evict a random orphan:
+        EraseTxInternal(vOrphanList[GetRand(vOrphanList.size())]->first);
+        ++nEvicted;
+    }
+    return nEvicted;
+}
+
+void CTxOrphanPool::AddChildrenToWorkSet(const CTransaction& tx)
+{
+    LOCK(cs);
+    for (unsigned int i = 0; i < tx.vout.size(); i++) {
+        auto itByPrev = mapOrphansByPrev.find(COutPoint(tx.GetHash(), i));
+        if (itByPrev == mapOrphansByPrev.end()) continue;
+        for (const OrphanIt& it : itByPrev->second) {
+            mapWorkSet[it->second.fromPeer].insert(it->first);
+        }
+    }
+}
+
+CTransactionRef CTxOrphanPool::GetTxToReconsider(NodeId peer)
+{
+    LOCK(cs);
+    auto itWork = mapWorkSet.find(peer);
+    if (itWork == mapWorkSet.end()) return nullptr;
+    std::set<uint256>& setWork = itWork->second;
+    CTransactionRef ret;
+    while (!ret && !setWork.empty()) {
+        auto it = mapOrphans.find(*setWork.begin());
+        setWork.erase(setWork.begin());
+        if (it != mapOrphans.end()) ret = it->second.tx;
+    }
+    if (setWork.empty()) mapWorkSet.erase(itWork);
+    return ret;
+}
+
+bool CTxOrphanPool::HaveTxToReconsider(NodeId peer) const
+{
+    LOCK(cs);
+    return mapWorkSet.count(peer);
+}
+
+size_t CTxOrphanPool::Size() const
+{
+    LOCK(cs);
+    return mapOrphans.size();
+}
+
+size_t CTxOrphanPool::DynamicMemoryUsage() const
+{
+    LOCK(cs);
+    return nTotalUsage;
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2009-2010 Satoshi Nakamoto
+// Copyright (c) 2009-2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_TXORPHANPOOL_H
+#define BITCOIN_TXORPHANPOOL_H
+
+#include <net.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+/** Expiration time for orphan transactions in seconds */
+static const int64_t ORPHAN_TX_EXPIRE_TIME = 20 * 60;
+/** Minimum time between orphan transactions expire time checks in seconds */
+static const int64_t ORPHAN_TX_EXPIRE_INTERVAL = 5 * 60;
+/** Maximum memory, in bytes, taken by the orphans of a single peer */
+static const size_t MAX_PEER_ORPHAN_BYTES = 1000 * 1000;
+
+/**
+ * Transactions that spend outputs we do not know about yet ("orphans"),
+ * indexed by the outpoints they spend so that they can be reconsidered once a
+ * missing parent arrives.
+ *
+ * Memory is bounded globally, by count and by bytes, and per peer that sent
+ * the orphans; random eviction takes constant time. When a parent is
+ * accepted its orphan children are not validated right away but queued in the
+ * work set of the peer that sent each of them, which the message handler
+ * drains one transaction at a time.
+ */
+class CTxOrphanPool
+{
+public:
+    CTxOrphanPool();
+
+    /** Add an orphan sent by peer. Fails if it is already present, too large,
+     *  or would take the peer over MAX_PEER_ORPHAN_BYTES. */
+    bool AddTx(const CTransactionRef& tx, NodeId peer);
+
+    bool HaveTx(const uint256& txid) const;
+
+    /** Remove an orphan, returning the number removed */
+    int EraseTx(const uint256& txid);
+
+    /** Remove all orphans sent by peer, and its work set */
+    void EraseForPeer(NodeId peer);
+
+    /** Remove orphans included in or conflicting with block */
+    void EraseForBlock(const CBlock& block);
+
+    /** Remove expired orphans, then random ones until at most nMaxOrphans
+     *  taking at most nMaxBytes are left. Returns the number evicted at random. */
+    unsigned int LimitOrphans(unsigned int nMaxOrphans, size_t nMaxBytes);
+
+    /** Queue the orphans spending outputs of tx for reconsideration */
+    void AddChildrenToWorkSet(const CTransaction& tx);
+
+    /** Take the next orphan sent by peer that should be reconsidered, or nullptr */
+    CTransactionRef GetTxToReconsider(NodeId peer);
+
+    bool HaveTxToReconsider(NodeId peer) const;
+
+    size_t Size() const;
+    size_t DynamicMemoryUsage() const;
+
+private:
+    struct OrphanTx {
+        CTransactionRef tx;
+        NodeId fromPeer;
+        int64_t nTimeExpire;
+        size_t nUsage;
+        //! Position in vOrphanList
+        size_t nListPos;
+    };
+    typedef std::map<uint256, OrphanTx>::iterator OrphanIt;
+
+    struct IteratorComparator
+    {
+        bool operator()(const OrphanIt& a, const OrphanIt& b) const
+        {
+            return &(*a) < &(*b);
+        }
+    };
+
+    mutable CCriticalSection cs;
+    std::map<uint256, OrphanTx> mapOrphans GUARDED_BY(cs);
+    std::map<COutPoint, std::set<OrphanIt, IteratorComparator>> mapOrphansByPrev GUARDED_BY(cs);
+    //! All orphans in no particular order, for random eviction
+    std::vector<OrphanIt> vOrphanList GUARDED_BY(cs);
+    //! Memory taken by the orphans of each peer that has any
+    std::map<NodeId, size_t> mapPeerUsage GUARDED_BY(cs);
+    //! Orphans of each peer whose parents have arrived since they were last considered
+    std::map<NodeId, std::set<uint256>> mapWorkSet GUARDED_BY(cs);
+    size_t nTotalUsage GUARDED_BY(cs);
+    int64_t nNextSweep GUARDED_BY(cs);
+
+    int EraseTxInternal(const uint256& txid) EXCLUSIVE_LOCKS_REQUIRED(cs);
+};
+
+#endif // BITCOIN_TXORPHANPOOL_H
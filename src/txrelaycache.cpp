@@ -0,0 +1,76 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <txrelaycache.h>
+
+#include <core_memusage.h>
+#include <memusage.h>
+
+CTxRelayCache::CTxRelayCache(size_t nMaxUsageIn) :
+    nUsage(0), nMaxUsage(nMaxUsageIn), nHits(0), nMisses(0), nEvicted(0)
+{
+}
+
+void CTxRelayCache::RemoveOldest()
+{
+    MapRelay::iterator it = vRelayExpiration.front().second;
+    nUsage -= it->second.nUsage;
+    mapRelay.erase(it);
+    vRelayExpiration.pop_front();
+}
+
+void CTxRelayCache::Expire(int64_t nNow)
+{
+    while (!vRelayExpiration.empty() && vRelayExpiration.front().first < nNow) {
+        RemoveOldest();
+    }
+}
+
+void CTxRelayCache::Add(const CTransactionRef& tx, int64_t nNow)
+{
+    LOCK(cs);
+    Expire(nNow);
+
+    // The map node and the expiration entry, plus what tx holds on to
+    const size_t nEntryUsage = RecursiveDynamicUsage(tx) + memusage::MallocUsage(sizeof(MapRelay::value_type) + 3 * sizeof(void*)) +
+                               sizeof(std::pair<int64_t, MapRelay::iterator>);
+    if (nEntryUsage > nMaxUsage || mapRelay.count(tx->GetHash()))
+        return;
+    while (nUsage + nEntryUsage > nMaxUsage) {
+        RemoveOldest();
+        nEvicted++;
+    }
+
+    auto ret = mapRelay.emplace(tx->GetHash(), Entry{tx, nEntryUsage});
+    vRelayExpiration.emplace_back(nNow + RELAY_TX_CACHE_TIME, ret.first);
+    nUsage += nEntryUsage;
+}
+
+CTransactionRef CTxRelayCache::Get(const uint256& hash)
+{
+    LOCK(cs);
+    MapRelay::const_iterator it = mapRelay.find(hash);
+    if (it == mapRelay.end()) {
+        nMisses++;
+        return nullptr;
+    }
+    nHits++;
+    return it->second.tx;
+}
+
+void CTxRelayCache::SetMaxUsage(size_t nMaxUsageIn)
+{
+    LOCK(cs);
+    nMaxUsage = nMaxUsageIn;
+    while (nUsage > nMaxUsage) {
+        RemoveOldest();
+        nEvicted++;
+    }
+}
+
+TxRelayCacheStats CTxRelayCache::GetStats() const
+{
+    LOCK(cs);
+    return TxRelayCacheStats{mapRelay.size(), nUsage, nMaxUsage, nHits, nMisses, nEvicted};
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_TXRELAYCACHE_H
+#define BITCOIN_TXRELAYCACHE_H
+
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <deque>
+#include <map>
+
+/** Time, in microseconds, announced transactions are kept to answer getdata */
+static const int64_t RELAY_TX_CACHE_TIME = 15 * 60 * 1000000LL;
+/** Default for -maxrelaycache, maximum megabytes of announced transactions kept */
+static const unsigned int DEFAULT_MAX_RELAY_CACHE_SIZE = 20;
+
+struct TxRelayCacheStats
+{
+    size_t nTransactions;
+    size_t nUsage;
+    size_t nMaxUsage;
+    uint64_t nHits;
+    uint64_t nMisses;
+    //! Transactions dropped before expiring, to stay within nMaxUsage
+    uint64_t nEvicted;
+};
+
+/**
+ * Transactions we announced to peers, kept for RELAY_TX_CACHE_TIME so that
+ * the getdata requests following the announcement can be answered even if
+ * the transaction left the mempool in the meantime.
+ *
+ * The transactions are shared with the mempool where they are still in it.
+ * The memory they take is accounted for, and capped by dropping the oldest
+ * entries early. The cache has its own lock.
+ */
+class CTxRelayCache
+{
+public:
+    explicit CTxRelayCache(size_t nMaxUsageIn);
+
+    /** Remember tx from nNow (in microseconds) on, if it is not already */
+    void Add(const CTransactionRef& tx, int64_t nNow);
+
+    /** Get a remembered transaction, or nullptr */
+    CTransactionRef Get(const uint256& hash);
+
+    void SetMaxUsage(size_t nMaxUsageIn);
+
+    TxRelayCacheStats GetStats() const;
+
+private:
+    struct Entry {
+        CTransactionRef tx;
+        size_t nUsage;
+    };
+    typedef std::map<uint256, Entry> MapRelay;
+
+    mutable CCriticalSection cs;
+    MapRelay mapRelay GUARDED_BY(cs);
+    //! Expiration-time ordered list of (expire time, relay map entry) pairs
+    std::deque<std::pair<int64_t, MapRelay::iterator>> vRelayExpiration GUARDED_BY(cs);
+    size_t nUsage GUARDED_BY(cs);
+    size_t nMaxUsage GUARDED_BY(cs);
+    uint64_t nHits GUARDED_BY(cs);
+    uint64_t nMisses GUARDED_BY(cs);
+    uint64_t nEvicted GUARDED_BY(cs);
+
+    void RemoveOldest() EXCLUSIVE_LOCKS_REQUIRED(cs);
+    void Expire(int64_t nNow) EXCLUSIVE_LOCKS_REQUIRED(cs);
+};
+
+#endif // BITCOIN_TXRELAYCACHE_H
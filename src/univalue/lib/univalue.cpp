@@ -14,12 +14,50 @@ using namespace std;
 
 const UniValue NullUniValue;
 
+// Objects with fewer keys are searched linearly
+static const size_t KEY_INDEX_MIN_KEYS = 32;
+
+UniValue::UniValue(const UniValue& other) :
+    typ(other.typ), val(other.val), keys(other.keys), values(other.values),
+    keyIndex(other.keyIndex ? new KeyIndex(*other.keyIndex) : nullptr)
+{
+}
+
+UniValue::UniValue(UniValue&& other) noexcept :
+    typ(other.typ), val(std::move(other.val)), keys(std::move(other.keys)),
+    values(std::move(other.values)), keyIndex(std::move(other.keyIndex))
+{
+    other.typ = VNULL;
+}
+
+UniValue& UniValue::operator=(const UniValue& other)
+{
+    if (this != &other)
+        *this = UniValue(other);
+    return *this;
+}
+
+UniValue& UniValue::operator=(UniValue&& other) noexcept
+{
+    if (this != &other) {
+        // other may be part of this value, take it out before replacing
+        UniValue tmp(std::move(other));
+        typ = tmp.typ;
+        val.swap(tmp.val);
+        keys.swap(tmp.keys);
+        values.swap(tmp.values);
+        keyIndex.swap(tmp.keyIndex);
+    }
+    return *this;
+}
+
 void UniValue::clear()
 {
     typ = VNULL;
     val.clear();
     keys.clear();
     values.clear();
+    keyIndex.reset();
 }
 
 bool UniValue::setNull()
@@ -58,20 +96,19 @@ bool UniValue::setNumStr(const string& val_)
 
 bool UniValue::setInt(uint64_t val_)
 {
-    ostringstream oss;
-
-    oss << val_;
-
-    return setNumStr(oss.str());
+    // Always a valid number, no need to check it
+    clear();
+    typ = VNUM;
+    val = std::to_string(val_);
+    return true;
 }
 
 bool UniValue::setInt(int64_t val_)
 {
-    ostringstream oss;
-
-    oss << val_;
-
-    return setNumStr(oss.str());
+    clear();
+    typ = VNUM;
+    val = std::to_string(val_);
+    return true;
 }
 
 bool UniValue::setFloat(double val_)
@@ -116,6 +153,15 @@ bool UniValue::push_back(const UniValue& val_)
     return true;
 }
 
+bool UniValue::push_back(UniValue&& val_)
+{
+    if (typ != VARR)
+        return false;
+
+    values.push_back(std::move(val_));
+    return true;
+}
+
 bool UniValue::push_backV(const std::vector<UniValue>& vec)
 {
     if (typ != VARR)
@@ -130,6 +176,14 @@ void UniValue::__pushKV(const std::string& key, const UniValue& val_)
 {
     keys.push_back(key);
     values.push_back(val_);
+    indexLastKey();
+}
+
+void UniValue::__pushKV(const std::string& key, UniValue&& val_)
+{
+    keys.push_back(key);
+    values.push_back(std::move(val_));
+    indexLastKey();
 }
 
 bool UniValue::pushKV(const std::string& key, const UniValue& val_)
@@ -145,6 +199,19 @@ bool UniValue::pushKV(const std::string& key, const UniValue& val_)
     return true;
 }
 
+bool UniValue::pushKV(const std::string& key, UniValue&& val_)
+{
+    if (typ != VOBJ)
+        return false;
+
+    size_t idx;
+    if (findKey(key, idx))
+        values[idx] = std::move(val_);
+    else
+        __pushKV(key, std::move(val_));
+    return true;
+}
+
 bool UniValue::pushKVs(const UniValue& obj)
 {
     if (typ != VOBJ || obj.typ != VOBJ)
@@ -166,8 +233,35 @@ void UniValue::getObjMap(std::map<std::string,UniValue>& kv) const
         kv[keys[i]] = values[i];
 }
 
+void UniValue::indexKeys()
+{
+    if (keys.size() < KEY_INDEX_MIN_KEYS) {
+        keyIndex.reset();
+        return;
+    }
+    keyIndex.reset(new KeyIndex(keys.size()));
+    for (size_t i = 0; i < keys.size(); i++)
+        keyIndex->emplace(keys[i], i);
+}
+
+void UniValue::indexLastKey()
+{
+    if (keyIndex)
+        keyIndex->emplace(keys.back(), keys.size() - 1);
+    else if (keys.size() >= KEY_INDEX_MIN_KEYS)
+        indexKeys();
+}
+
 bool UniValue::findKey(const std::string& key, size_t& retIdx) const
 {
+    if (keyIndex) {
+        KeyIndex::const_iterator it = keyIndex->find(key);
+        if (it == keyIndex->end())
+            return false;
+        retIdx = it->second;
+        return true;
+    }
+
     for (size_t i = 0; i < keys.size(); i++) {
         if (keys[i] == key) {
             retIdx = i;
@@ -235,9 +329,9 @@ const char *uvTypeName(UniValue::VType t)
 
 const UniValue& find_value(const UniValue& obj, const std::string& name)
 {
-    for (unsigned int i = 0; i < obj.keys.size(); i++)
-        if (obj.keys[i] == name)
-            return obj.values.at(i);
+    size_t idx;
+    if (obj.findKey(name, idx))
+        return obj.values.at(idx);
 
     return NullUniValue;
 }
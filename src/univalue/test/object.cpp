@@ -335,6 +335,91 @@ BOOST_AUTO_TEST_CASE(univalue_object)
 
 }
 
+BOOST_AUTO_TEST_CASE(univalue_copymove)
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("name", "foo");
+    UniValue arr(UniValue::VARR);
+    arr.push_back(1);
+    obj.pushKV("list", arr);
+
+    UniValue copy(obj);
+    copy.pushKV("extra", UniValue(true));
+    BOOST_CHECK_EQUAL(obj.size(), 2);
+    BOOST_CHECK_EQUAL(copy.size(), 3);
+
+    UniValue moved(std::move(copy));
+    BOOST_CHECK(moved.isObject());
+    BOOST_CHECK_EQUAL(moved.size(), 3);
+    BOOST_CHECK_EQUAL(moved["name"].getValStr(), "foo");
+
+    UniValue target;
+    target = std::move(moved);
+    BOOST_CHECK_EQUAL(target.size(), 3);
+    BOOST_CHECK(target["extra"].isTrue());
+
+    // Replace a value by one of its own members
+    target = target["list"];
+    BOOST_CHECK(target.isArray());
+    BOOST_CHECK_EQUAL(target.size(), 1);
+    BOOST_CHECK_EQUAL(target[0].get_int(), 1);
+
+    target = obj;
+    BOOST_CHECK_EQUAL(target.write(), obj.write());
+
+    UniValue outer(UniValue::VARR);
+    UniValue inner(UniValue::VSTR, "bar");
+    outer.push_back(std::move(inner));
+    BOOST_CHECK_EQUAL(outer[0].getValStr(), "bar");
+    UniValue kvVal(UniValue::VNUM, "5");
+    obj.pushKV("name", std::move(kvVal));
+    BOOST_CHECK_EQUAL(obj["name"].getValStr(), "5");
+}
+
+BOOST_AUTO_TEST_CASE(univalue_manykeys)
+{
+    const int nKeys = 100;
+
+    UniValue obj(UniValue::VOBJ);
+    for (int i = 0; i < nKeys; i++)
+        obj.pushKV("key" + std::to_string(i), i);
+    // Later duplicates are not found, as with few keys
+    obj.__pushKV("key7", 1000);
+
+    BOOST_CHECK_EQUAL(obj.size(), nKeys + 1);
+    for (int i = 0; i < nKeys; i++) {
+        BOOST_CHECK(obj.exists("key" + std::to_string(i)));
+        BOOST_CHECK_EQUAL(obj["key" + std::to_string(i)].get_int(), i);
+        BOOST_CHECK_EQUAL(find_value(obj, "key" + std::to_string(i)).get_int(), i);
+    }
+    BOOST_CHECK(!obj.exists("key" + std::to_string(nKeys)));
+
+    obj.pushKV("key42", "replaced");
+    BOOST_CHECK_EQUAL(obj.size(), nKeys + 1);
+    BOOST_CHECK_EQUAL(obj["key42"].getValStr(), "replaced");
+
+    UniValue copy(obj);
+    copy.pushKV("new", 1);
+    BOOST_CHECK(copy.exists("new"));
+    BOOST_CHECK(!obj.exists("new"));
+
+    UniValue parsed;
+    BOOST_CHECK(parsed.read(obj.write()));
+    BOOST_CHECK_EQUAL(parsed.write(), obj.write());
+    BOOST_CHECK_EQUAL(parsed["key7"].get_int(), 7);
+    BOOST_CHECK_EQUAL(parsed["key99"].get_int(), 99);
+    BOOST_CHECK(!parsed.exists("new"));
+
+    obj.clear();
+    obj.setObject();
+    BOOST_CHECK(!obj.exists("key1"));
+    obj.pushKV("key1", 1);
+    BOOST_CHECK_EQUAL(obj["key1"].get_int(), 1);
+}
+
+static const char *json2 =
+"[\"plain text that is long enough to be scanned in blocks\",\"tab\\tquote\\\"backslash\\\\end\",\"\xc3\xa9t\xc3\xa9 \xe2\x82\xac uni\\u00e9" "code\",-1.5e+10]";
+
 static const char *json1 =
 "[1.10000000,{\"key1\":\"str\\u0000\",\"key2\":800,\"key3\":{\"name\":\"martian http://test.com\"}}]";
 
@@ -379,6 +464,18 @@ BOOST_AUTO_TEST_CASE(univalue_readwrite)
     BOOST_CHECK(!v.read("[]{}"));
     BOOST_CHECK(!v.read("{}[]"));
     BOOST_CHECK(!v.read("{} 42"));
+
+    BOOST_CHECK(v.read(json2));
+    BOOST_CHECK_EQUAL(v.size(), 4);
+    BOOST_CHECK_EQUAL(v[0].getValStr(), "plain text that is long enough to be scanned in blocks");
+    BOOST_CHECK_EQUAL(v[1].getValStr(), "tab\tquote\"backslash\\end");
+    BOOST_CHECK_EQUAL(v[2].getValStr(), "\xc3\xa9t\xc3\xa9 \xe2\x82\xac uni\xc3\xa9" "code");
+    BOOST_CHECK_EQUAL(v[3].getValStr(), "-1.5e+10");
+
+    // Control characters and broken UTF-8 within long plain runs
+    BOOST_CHECK(!v.read("[\"0123456789abcdef\x01 0123456789abcdef\"]"));
+    BOOST_CHECK(!v.read("[\"0123456789abcdef\xc3 0123456789abcdef\"]"));
+    BOOST_CHECK(!v.read("[\"0123456789abcdef0123456789abcdef"));
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -390,6 +487,8 @@ int main (int argc, char *argv[])
     univalue_set();
     univalue_array();
     univalue_object();
+    univalue_copymove();
+    univalue_manykeys();
     univalue_readwrite();
     return 0;
 }
@@ -132,6 +132,7 @@ static const char *filenames[] = {
         "round5.json",              // bare true
         "round6.json",              // bare false
         "round7.json",              // bare null
+        "round8.json",              // object with many keys, long strings
 };
 
 // Test \u handling
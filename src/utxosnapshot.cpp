@@ -0,0 +1,194 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <utxosnapshot.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <coins.h>
+#include <hash.h>
+#include <streams.h>
+#include <sync.h>
+#include <txdb.h>
+#include <util.h>
+#include <validation.h>
+
+#include <memory>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+const unsigned char CUTXOSnapshotHeader::MAGIC[5] = {'u', 't', 'x', 'o', 0xff};
+
+//! Number of coins handed to the chainstate database at once while loading a snapshot
+static const size_t UTXO_SNAPSHOT_LOAD_CHUNK = 100000;
+
+bool DumpUTXOSnapshot(CCoinsViewCursor* pcursor, const fs::path& path, uint64_t& nCoinsRet, uint256& hashSnapshotRet, std::string& strError)
+{
+    int64_t nStart = GetTimeMillis();
+    fs::path pathTmp = path;
+    pathTmp += ".incomplete";
+
+    try {
+        FILE* filestr = fsbridge::fopen(pathTmp, "wb");
+        if (!filestr) {
+            strError = "Unable to open " + pathTmp.string() + " for writing";
+            return false;
+        }
+        CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+
+        // The number of coins is only known at the end; the header is rewritten then.
+        CUTXOSnapshotHeader header(pcursor->GetBestBlock(), 0);
+        file << header;
+
+        CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+        ss << header.hashBlock;
+        COutPoint key;
+        Coin coin;
+        while (pcursor->Valid()) {
+            boost::this_thread::interruption_point();
+            if (!pcursor->GetKey(key) || !pcursor->GetValue(coin)) {
+                strError = "Unable to read UTXO set";
+                return false;
+            }
+            file << key << coin;
+            ss << key << coin;
+            header.nCoins++;
+            pcursor->Next();
+        }
+        uint256 hashSnapshot = ss.GetHash();
+        file << hashSnapshot;
+
+        if (fseek(file.Get(), 0, SEEK_SET) != 0) {
+            strError = "Unable to rewind " + pathTmp.string();
+            return false;
+        }
+        file << header;
+        FileCommit(file.Get());
+        file.fclose();
+        if (!RenameOver(pathTmp, path)) {
+            strError = "Unable to rename " + pathTmp.string() + " to " + path.string();
+            return false;
+        }
+
+        nCoinsRet = header.nCoins;
+        hashSnapshotRet = hashSnapshot;
+    } catch (const std::exception& e) {
+        strError = strprintf("Failed to write UTXO snapshot: %s", e.what());
+        return false;
+    }
+    LogPrintf("Dumped UTXO snapshot of %u coins at block %s to %s: %dms\n", nCoinsRet, pcursor->GetBestBlock().ToString(), path.string(), GetTimeMillis() - nStart);
+    return true;
+}
+
+/**
+ * Read a snapshot file from the start. If pdb is set, its coins are written
+ * there; otherwise only the hash of the file is checked.
+ */
+static bool ReadUTXOSnapshot(const fs::path& path, CUTXOSnapshotHeader& header, uint256& hashSnapshot, CCoinsViewDB* pdb, std::string& strError)
+{
+    FILE* filestr = fsbridge::fopen(path, "rb");
+    if (!filestr) {
+        strError = "Unable to open UTXO snapshot " + path.string();
+        return false;
+    }
+    CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+
+    try {
+        file >> header;
+
+        CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+        ss << header.hashBlock;
+        std::vector<std::pair<COutPoint, Coin>> vCoins;
+        vCoins.reserve(pdb ? std::min<uint64_t>(header.nCoins, UTXO_SNAPSHOT_LOAD_CHUNK) : 0);
+        std::pair<COutPoint, Coin> entry;
+        for (uint64_t i = 0; i < header.nCoins; i++) {
+            file >> entry.first >> entry.second;
+            if (entry.second.IsSpent()) {
+                strError = "Spent coin in UTXO snapshot";
+                return false;
+            }
+            ss << entry.first << entry.second;
+            if (pdb) {
+                vCoins.push_back(std::move(entry));
+                if (vCoins.size() == UTXO_SNAPSHOT_LOAD_CHUNK) {
+                    if (!pdb->WriteSnapshotCoins(vCoins, header.hashBlock, false)) {
+                        strError = "Failed to write to coin database";
+                        return false;
+                    }
+                    vCoins.clear();
+                    LogPrintf("Loading UTXO snapshot: %u of %u coins written\n", i + 1, header.nCoins);
+                }
+            }
+        }
+
+        uint256 hashExpected;
+        file >> hashExpected;
+        hashSnapshot = ss.GetHash();
+        if (hashSnapshot != hashExpected) {
+            strError = "UTXO snapshot " + path.string() + " is corrupt";
+            return false;
+        }
+        if (pdb && !pdb->WriteSnapshotCoins(vCoins, header.hashBlock, true)) {
+            strError = "Failed to write to coin database";
+            return false;
+        }
+    } catch (const std::exception& e) {
+        strError = strprintf("Failed to read UTXO snapshot: %s", e.what());
+        return false;
+    }
+    return true;
+}
+
+bool LoadUTXOSnapshot(const fs::path& path, CCoinsViewDB& db, const CChainParams& chainparams, std::string& strError)
+{
+    int64_t nStart = GetTimeMillis();
+
+    // Verify the whole file before touching the database.
+    CUTXOSnapshotHeader header;
+    uint256 hashSnapshot;
+    if (!ReadUTXOSnapshot(path, header, hashSnapshot, nullptr, strError)) {
+        return false;
+    }
+    if (db.GetBestBlock() == header.hashBlock) {
+        LogPrintf("Chainstate is at the base of UTXO snapshot %s already\n", path.string());
+        return true;
+    }
+
+    {
+        LOCK(cs_main);
+        BlockMap::const_iterator it = mapBlockIndex.find(header.hashBlock);
+        if (it == mapBlockIndex.end() || !it->second->IsValid(BLOCK_VALID_TRANSACTIONS) || it->second->nChainTx == 0) {
+            strError = "The base block " + header.hashBlock.ToString() + " of the UTXO snapshot is not in the block database";
+            return false;
+        }
+    }
+
+    const MapUTXOSnapshots& mapSnapshots = chainparams.UTXOSnapshots();
+    MapUTXOSnapshots::const_iterator itPinned = mapSnapshots.find(header.hashBlock);
+    if (itPinned != mapSnapshots.end()) {
+        if (itPinned->second != hashSnapshot) {
+            strError = "UTXO snapshot " + path.string() + " does not match the trusted snapshot hash for its base block";
+            return false;
+        }
+    } else {
+        LogPrintf("WARNING: UTXO snapshot %s (hash %s) is not pinned in the chain parameters and is trusted as is\n", path.string(), hashSnapshot.ToString());
+    }
+
+    std::unique_ptr<CCoinsViewCursor> pcursor(db.Cursor());
+    if (pcursor->Valid() || !db.GetHeadBlocks().empty()) {
+        strError = "A UTXO snapshot can only be loaded into an empty chainstate; use -reindex-chainstate";
+        return false;
+    }
+    pcursor.reset();
+
+    LogPrintf("Loading UTXO snapshot of %u coins at block %s from %s\n", header.nCoins, header.hashBlock.ToString(), path.string());
+    uint256 hashLoaded;
+    if (!ReadUTXOSnapshot(path, header, hashLoaded, &db, strError)) {
+        return false;
+    }
+    LogPrintf("Loaded UTXO snapshot: %dms\n", GetTimeMillis() - nStart);
+    return true;
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTXOSNAPSHOT_H
+#define BITCOIN_UTXOSNAPSHOT_H
+
+#include <fs.h>
+#include <serialize.h>
+#include <tinyformat.h>
+#include <uint256.h>
+
+#include <ios>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+class CChainParams;
+class CCoinsViewCursor;
+class CCoinsViewDB;
+
+/** Current version of the UTXO snapshot file format */
+static const uint32_t UTXO_SNAPSHOT_VERSION = 1;
+
+/**
+ * Header of a UTXO snapshot file, as written by dumptxoutset.
+ *
+ * Serialized format:
+ * - 5 byte magic "utxo\xff"
+ * - uint32 format version
+ * - uint256 hash of the block the snapshot was taken at
+ * - uint64 number of coins
+ *
+ * It is followed by that many (COutPoint, Coin) pairs in chainstate database
+ * order, and the uint256 snapshot hash: the double SHA256 of the base block
+ * hash followed by all those pairs.
+ */
+class CUTXOSnapshotHeader
+{
+public:
+    static const unsigned char MAGIC[5];
+
+    uint32_t nVersion;
+    uint256 hashBlock;
+    uint64_t nCoins;
+
+    CUTXOSnapshotHeader() : nVersion(UTXO_SNAPSHOT_VERSION), nCoins(0) {}
+    CUTXOSnapshotHeader(const uint256& hashBlockIn, uint64_t nCoinsIn) : nVersion(UTXO_SNAPSHOT_VERSION), hashBlock(hashBlockIn), nCoins(nCoinsIn) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        s.write((const char*)MAGIC, sizeof(MAGIC));
+        s << nVersion << hashBlock << nCoins;
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        unsigned char magic[sizeof(MAGIC)];
+        s.read((char*)magic, sizeof(magic));
+        if (memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+            throw std::ios_base::failure("Not a UTXO snapshot file");
+        }
+        s >> nVersion;
+        if (nVersion > UTXO_SNAPSHOT_VERSION) {
+            throw std::ios_base::failure(strprintf("Unsupported UTXO snapshot version %u", nVersion));
+        }
+        s >> hashBlock >> nCoins;
+    }
+};
+
+/**
+ * Write the UTXO set seen by pcursor to path, streaming it from the database.
+ * On success, nCoinsRet and hashSnapshotRet describe what was written.
+ */
+bool DumpUTXOSnapshot(CCoinsViewCursor* pcursor, const fs::path& path, uint64_t& nCoinsRet, uint256& hashSnapshotRet, std::string& strError);
+
+/**
+ * Fill an empty chainstate database with the coins of the snapshot at path.
+ * The base block must be known, and if its snapshot hash is pinned in
+ * chainparams, the snapshot must match it. Does nothing if the database is at
+ * the snapshot's base block already.
+ */
+bool LoadUTXOSnapshot(const fs::path& path, CCoinsViewDB& db, const CChainParams& chainparams, std::string& strError);
+
+#endif // BITCOIN_UTXOSNAPSHOT_H
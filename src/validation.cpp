@@ -10,12 +10,14 @@
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <checkqueue.h>
+#include <coinstats.h>
 #include <consensus/consensus.h>
 #include <consensus/merkle.h>
 #include <consensus/tx_verify.h>
 #include <consensus/validation.h>
 #include <cuckoocache.h>
 #include <hash.h>
+#include <index/txindex.h>
 #include <init.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
@@ -169,7 +171,7 @@ public:
     // Block (dis)connection on a given view:
     DisconnectResult DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view);
     bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex,
-                    CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck = false);
+                    CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck = false, CBlockUndo* pblockundo = nullptr);
 
     // Block disconnection on our pcoinsTip:
     bool DisconnectTip(CValidationState& state, const CChainParams& chainparams, DisconnectedBlockTransactions *disconnectpool);
@@ -217,7 +219,6 @@ uint256 hashBestBlock;
 int nScriptCheckThreads = 0;
 std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
-bool fTxIndex = false;
 bool fHavePruned = false;
 bool fPruneMode = false;
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
@@ -288,6 +289,7 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 
 std::unique_ptr<CCoinsViewDB> pcoinsdbview;
 std::unique_ptr<CCoinsViewCache> pcoinsTip;
+std::unique_ptr<CRollingCoinsStats> pcoinsStats;
 std::unique_ptr<CBlockTreeDB> pblocktree;
 
 enum FlushStateMode {
@@ -662,7 +664,8 @@ static bool CheckInputsFromMempoolAndCache(const CTransaction& tx, CValidationSt
 
 static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool& pool, CValidationState& state, const CTransactionRef& ptx,
                               bool* pfMissingInputs, int64_t nAcceptTime, std::list<CTransactionRef>* plTxnReplaced,
-                              bool bypass_limits, const CAmount& nAbsurdFee, std::vector<COutPoint>& coins_to_uncache)
+                              bool bypass_limits, const CAmount& nAbsurdFee, std::vector<COutPoint>& coins_to_uncache,
+                              bool fTrustScripts)
 {
     const CTransaction& tx = *ptx;
     const uint256 hash = tx.GetHash();
@@ -1012,8 +1015,10 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
 
         // Check against previous transactions
         // This is done last to help prevent CPU exhaustion denial-of-service attacks.
+        // It is skipped for transactions whose scripts this node verified
+        // before (see LoadMempool).
         PrecomputedTransactionData txdata(tx);
-        if (!CheckInputs(tx, state, view, true, scriptVerifyFlags, true, false, txdata)) {
+        if (!fTrustScripts && !CheckInputs(tx, state, view, true, scriptVerifyFlags, true, false, txdata)) {
             // SCRIPT_VERIFY_CLEANSTACK requires SCRIPT_VERIFY_WITNESS, so we
             // need to turn both off, and compare against just turning off CLEANSTACK
             // to see if the failure is specifically due to witness validation.
@@ -1042,7 +1047,7 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
         // invalid blocks (using TestBlockValidity), however allowing such
         // transactions into the mempool can be exploited as a DoS attack.
         unsigned int currentBlockScriptVerifyFlags = GetBlockScriptFlags(chainActive.Tip(), Params().GetConsensus());
-        if (!CheckInputsFromMempoolAndCache(tx, state, view, pool, currentBlockScriptVerifyFlags, true, txdata))
+        if (!fTrustScripts && !CheckInputsFromMempoolAndCache(tx, state, view, pool, currentBlockScriptVerifyFlags, true, txdata))
         {
             // If we're using promiscuousmempoolflags, we may hit this normally
             // Check if current block has some flags that scriptVerifyFlags
@@ -1099,10 +1104,10 @@ static bool AcceptToMemoryPoolWorker(const CChainParams& chainparams, CTxMemPool
 /** (try to) add transaction to memory pool with a specified acceptance time **/
 static bool AcceptToMemoryPoolWithTime(const CChainParams& chainparams, CTxMemPool& pool, CValidationState &state, const CTransactionRef &tx,
                         bool* pfMissingInputs, int64_t nAcceptTime, std::list<CTransactionRef>* plTxnReplaced,
-                        bool bypass_limits, const CAmount nAbsurdFee)
+                        bool bypass_limits, const CAmount nAbsurdFee, bool fTrustScripts = false)
 {
     std::vector<COutPoint> coins_to_uncache;
-    bool res = AcceptToMemoryPoolWorker(chainparams, pool, state, tx, pfMissingInputs, nAcceptTime, plTxnReplaced, bypass_limits, nAbsurdFee, coins_to_uncache);
+    bool res = AcceptToMemoryPoolWorker(chainparams, pool, state, tx, pfMissingInputs, nAcceptTime, plTxnReplaced, bypass_limits, nAbsurdFee, coins_to_uncache, fTrustScripts);
     if (!res) {
         for (const COutPoint& hashTx : coins_to_uncache)
             pcoinsTip->Uncache(hashTx);
@@ -1129,8 +1134,6 @@ bool GetTransaction(const uint256& hash, CTransactionRef& txOut, const Consensus
 {
     CBlockIndex* pindexSlow = blockIndex;
 
-    LOCK(cs_main);
-
     if (!blockIndex) {
         CTransactionRef ptx = mempool.get(hash);
         if (ptx) {
@@ -1138,34 +1141,19 @@ bool GetTransaction(const uint256& hash, CTransactionRef& txOut, const Consensus
             return true;
         }
 
-        if (fTxIndex) {
-            CDiskTxPos postx;
-            if (pblocktree->ReadTxIndex(hash, postx)) {
-                CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-                if (file.IsNull())
-                    return error("%s: OpenBlockFile failed", __func__);
-                CBlockHeader header;
-                try {
-                    file >> header;
-                    fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-                    file >> txOut;
-                } catch (const std::exception& e) {
-                    return error("%s: Deserialize or I/O error - %s", __func__, e.what());
-                }
-                hashBlock = header.GetHash();
-                if (txOut->GetHash() != hash)
-                    return error("%s: txid mismatch", __func__);
-                return true;
-            }
-
-            // transaction not found in index, nothing more can be done
-            return false;
+        // Once it caught up the index is used without waiting for it, as
+        // callers may hold cs_main. It can be a few blocks behind, so the
+        // slow lookup still covers what it misses.
+        if (g_txindex && g_txindex->IsSynced() && g_txindex->FindTx(hash, hashBlock, txOut)) {
+            return true;
         }
+    }
 
-        if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
-            const Coin& coin = AccessByTxid(*pcoinsTip, hash);
-            if (!coin.IsSpent()) pindexSlow = chainActive[coin.nHeight];
-        }
+    LOCK(cs_main);
+
+    if (!blockIndex && fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
+        const Coin& coin = AccessByTxid(*pcoinsTip, hash);
+        if (!coin.IsSpent()) pindexSlow = chainActive[coin.nHeight];
     }
 
     if (pindexSlow) {
@@ -1255,6 +1243,39 @@ bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus
     return true;
 }
 
+bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& message_start)
+{
+    // Blocks are stored after the network magic and their size
+    CDiskBlockPos hpos = pos;
+    hpos.nPos -= 8;
+    CAutoFile filein(OpenBlockFile(hpos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("%s: OpenBlockFile failed for %s", __func__, pos.ToString());
+
+    try {
+        CMessageHeader::MessageStartChars blk_start;
+        unsigned int blk_size;
+
+        filein >> FLATDATA(blk_start) >> blk_size;
+
+        if (memcmp(blk_start, message_start, CMessageHeader::MESSAGE_START_SIZE))
+            return error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
+                    HexStr(blk_start, blk_start + CMessageHeader::MESSAGE_START_SIZE),
+                    HexStr(message_start, message_start + CMessageHeader::MESSAGE_START_SIZE));
+
+        if (blk_size > MAX_SIZE)
+            return error("%s: Block data is larger than maximum deserialization size for %s: %s versus %s", __func__, pos.ToString(),
+                    blk_size, MAX_SIZE);
+
+        block.resize(blk_size);
+        filein.read((char*)block.data(), blk_size);
+    } catch (const std::exception& e) {
+        return error("%s: Read from block file failed: %s for %s", __func__, e.what(), pos.ToString());
+    }
+
+    return true;
+}
+
 CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
 {
     int halvings = nHeight / consensusParams.nSubsidyHalvingInterval;
@@ -1277,6 +1298,49 @@ CAmount GetBlockSubsidy(int nHeight, const Consensus::Params& consensusParams)
     }
 }
 
+static std::shared_ptr<const ChainStateSummary> g_chainstate_summary = std::make_shared<ChainStateSummary>();
+
+std::shared_ptr<const ChainStateSummary> GetChainStateSummary()
+{
+    return std::atomic_load(&g_chainstate_summary);
+}
+
+/** Publish the state of chainActive for GetChainStateSummary */
+static void PublishChainStateSummary()
+{
+    AssertLockHeld(cs_main);
+
+    std::shared_ptr<ChainStateSummary> summary = std::make_shared<ChainStateSummary>();
+    const CBlockIndex* pindex = chainActive.Tip();
+    summary->nHeaders = pindexBestHeader ? pindexBestHeader->nHeight : -1;
+    if (pindex) {
+        summary->pindexTip = pindex;
+        summary->hashTip = pindex->GetBlockHash();
+        summary->nHeight = pindex->nHeight;
+        summary->nChainWork = pindex->nChainWork;
+        summary->nMedianTimePast = pindex->GetMedianTimePast();
+        summary->fInitialDownload = IsInitialBlockDownload();
+        summary->nSizeOnDisk = CalculateCurrentUsage();
+        if (fPruneMode) {
+            const CBlockIndex* pindexPruned = pindex;
+            while (pindexPruned->pprev && (pindexPruned->pprev->nStatus & BLOCK_HAVE_DATA))
+                pindexPruned = pindexPruned->pprev;
+            summary->nPruneHeight = pindexPruned->nHeight;
+        }
+    }
+    std::atomic_store(&g_chainstate_summary, std::shared_ptr<const ChainStateSummary>(std::move(summary)));
+}
+
+/** Publish a new best header, keeping the rest of the summary */
+static void PublishBestHeader()
+{
+    AssertLockHeld(cs_main);
+
+    std::shared_ptr<ChainStateSummary> summary = std::make_shared<ChainStateSummary>(*GetChainStateSummary());
+    summary->nHeaders = pindexBestHeader ? pindexBestHeader->nHeight : -1;
+    std::atomic_store(&g_chainstate_summary, std::shared_ptr<const ChainStateSummary>(std::move(summary)));
+}
+
 bool IsInitialBlockDownload()
 {
     // Once this function has returned false, it must remain false.
@@ -1565,6 +1629,36 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
     return true;
 }
 
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashPrevBlock)
+{
+    if (pos.IsNull()) {
+        return error("%s: no undo data available", __func__);
+    }
+
+    // Open history file to read
+    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull())
+        return error("%s: OpenUndoFile failed", __func__);
+
+    // Read block
+    uint256 hashChecksum;
+    CHashVerifier<CAutoFile> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
+    try {
+        verifier << hashPrevBlock;
+        verifier >> blockundo;
+        filein >> hashChecksum;
+    }
+    catch (const std::exception& e) {
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+
+    // Verify checksum
+    if (hashChecksum != verifier.GetHash())
+        return error("%s: Checksum mismatch", __func__);
+
+    return true;
+}
+
 namespace {
 
 bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint256& hashBlock, const CMessageHeader::MessageStartChars& messageStart)
@@ -1596,33 +1690,7 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
 
 static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
 {
-    CDiskBlockPos pos = pindex->GetUndoPos();
-    if (pos.IsNull()) {
-        return error("%s: no undo data available", __func__);
-    }
-
-    // Open history file to read
-    CAutoFile filein(OpenUndoFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull())
-        return error("%s: OpenUndoFile failed", __func__);
-
-    // Read block
-    uint256 hashChecksum;
-    CHashVerifier<CAutoFile> verifier(&filein); // We need a CHashVerifier as reserializing may lose data
-    try {
-        verifier << pindex->pprev->GetBlockHash();
-        verifier >> blockundo;
-        filein >> hashChecksum;
-    }
-    catch (const std::exception& e) {
-        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
-    }
-
-    // Verify checksum
-    if (hashChecksum != verifier.GetHash())
-        return error("%s: Checksum mismatch", __func__);
-
-    return true;
+    return ::UndoReadFromDisk(blockundo, pindex->GetUndoPos(), pindex->pprev->GetBlockHash());
 }
 
 /** Abort with a message */
@@ -1782,35 +1850,106 @@ static bool WriteUndoDataForBlock(const CBlockUndo& blockundo, CValidationState&
     return true;
 }
 
-static bool WriteTxIndexDataForBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex)
+static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+
+void ThreadScriptCheck() {
+    RenameThread("theholyroger-scriptch");
+    scriptcheckqueue.Thread();
+}
+
+/**
+ * Read of a single coin from the chainstate database, done on one of the
+ * coins prefetch threads. A coin that could not be read is left spent.
+ */
+class CCoinsPrefetch
 {
-    if (!fTxIndex) return true;
+private:
+    const CCoinsView *view;
+    std::pair<COutPoint, Coin> *entry;
 
-    CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
-    std::vector<std::pair<uint256, CDiskTxPos> > vPos;
-    vPos.reserve(block.vtx.size());
-    for (const CTransactionRef& tx : block.vtx)
-    {
-        vPos.push_back(std::make_pair(tx->GetHash(), pos));
-        pos.nTxOffset += ::GetSerializeSize(*tx, SER_DISK, CLIENT_VERSION);
+public:
+    CCoinsPrefetch() : view(nullptr), entry(nullptr) {}
+    CCoinsPrefetch(const CCoinsView *viewIn, std::pair<COutPoint, Coin> *entryIn) : view(viewIn), entry(entryIn) {}
+
+    bool operator()() {
+        try {
+            if (!view->GetCoin(entry->first, entry->second)) {
+                entry->second.Clear();
+            }
+        } catch (const std::runtime_error&) {
+            // Leave it to the regular read in ConnectBlock to report database errors.
+            entry->second.Clear();
+        }
+        return true;
     }
 
-    if (!pblocktree->WriteTxIndex(vPos)) {
-        return AbortNode(state, "Failed to write transaction index");
+    void swap(CCoinsPrefetch &check) {
+        std::swap(view, check.view);
+        std::swap(entry, check.entry);
     }
+};
 
-    return true;
+static CCheckQueue<CCoinsPrefetch> coinsprefetchqueue(16);
+
+void ThreadCoinsPrefetch() {
+    RenameThread("theholyroger-coinsfetch");
+    coinsprefetchqueue.Thread();
 }
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+/**
+ * Read the coins spent by a block that are not cached yet from the chainstate
+ * database on the prefetch threads, and add them to pcoinsTip. Without this,
+ * ConnectBlock would do one synchronous database read after another.
+ * cs_main must be held throughout, so that pcoinsTip cannot be flushed while
+ * the database is being read.
+ */
+static void PrefetchBlockCoins(const CBlock& block, const CCoinsViewCache& view)
+{
+    AssertLockHeld(cs_main);
+    if (nScriptCheckThreads == 0) {
+        return;
+    }
 
-void ThreadScriptCheck() {
-    RenameThread("theholyroger-scriptch");
-    scriptcheckqueue.Thread();
+    std::set<uint256> setBlockTxids;
+    for (const auto& tx : block.vtx) {
+        setBlockTxids.insert(tx->GetHash());
+    }
+    std::vector<std::pair<COutPoint, Coin>> vCoins;
+    for (const auto& tx : block.vtx) {
+        if (tx->IsCoinBase()) {
+            continue;
+        }
+        for (const CTxIn& txin : tx->vin) {
+            if (!setBlockTxids.count(txin.prevout.hash) && !view.HaveCoinInCache(txin.prevout) && !pcoinsTip->HaveCoinInCache(txin.prevout)) {
+                vCoins.emplace_back(txin.prevout, Coin());
+            }
+        }
+    }
+    if (vCoins.size() < MIN_PREFETCH_COINS) {
+        return;
+    }
+
+    std::vector<CCoinsPrefetch> vChecks;
+    vChecks.reserve(vCoins.size());
+    for (auto& entry : vCoins) {
+        vChecks.emplace_back(pcoinsdbview.get(), &entry);
+    }
+    CCheckQueueControl<CCoinsPrefetch> control(&coinsprefetchqueue);
+    control.Add(vChecks);
+    control.Wait();
+
+    for (auto& entry : vCoins) {
+        if (!entry.second.IsSpent()) {
+            pcoinsTip->AddFetchedCoin(entry.first, std::move(entry.second));
+        }
+    }
 }
 
 // Protected by cs_main
 VersionBitsCache versionbitscache;
+// The same for the VersionBitsTip* functions, which do not lock cs_main
+static CCriticalSection cs_versionbits_tip;
+static VersionBitsCache versionbitscache_tip;
 
 int32_t ComputeBlockVersion(const CBlockIndex* pindexPrev, const Consensus::Params& params)
 {
@@ -1903,7 +2042,7 @@ static int64_t nBlocksTotal = 0;
  *  Validity checks that depend on the UTXO set are also done; ConnectBlock()
  *  can fail if those validity checks fail (among other reasons). */
 bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex,
-                  CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck)
+                  CCoinsViewCache& view, const CChainParams& chainparams, bool fJustCheck, CBlockUndo* pblockundo)
 {
     AssertLockHeld(cs_main);
     assert(pindex);
@@ -2022,6 +2161,8 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     int64_t nTime2 = GetTimeMicros(); nTimeForks += nTime2 - nTime1;
     LogPrint(BCLog::BENCH, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2 - nTime1), nTimeForks * MICRO, nTimeForks * MILLI / nBlocksTotal);
 
+    PrefetchBlockCoins(block, view);
+
     CBlockUndo blockundo;
 
     CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : nullptr);
@@ -2117,9 +2258,6 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         setDirtyBlockIndex.insert(pindex);
     }
 
-    if (!WriteTxIndexDataForBlock(block, state, pindex))
-        return false;
-
     assert(pindex->phashBlock);
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
@@ -2130,6 +2268,9 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     int64_t nTime6 = GetTimeMicros(); nTimeCallbacks += nTime6 - nTime5;
     LogPrint(BCLog::BENCH, "    - Callbacks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime6 - nTime5), nTimeCallbacks * MICRO, nTimeCallbacks * MILLI / nBlocksTotal);
 
+    if (pblockundo) {
+        *pblockundo = std::move(blockundo);
+    }
     return true;
 }
 
@@ -2231,7 +2372,21 @@ bool static FlushStateToDisk(const CChainParams& chainparams, CValidationState &
             if (!CheckDiskSpace(48 * 2 * 2 * pcoinsTip->GetCacheSize()))
                 return state.Error("out of disk space");
             // Flush the chainstate (which may refer to block index entries).
-            if (!pcoinsTip->Flush())
+            // Unless we are shutting down, only write out the modified entries
+            // and, if the cache is too large, evict the least recently used ones,
+            // so that the working set does not have to be read back from disk.
+            int64_t nTrimPercent = std::max<int64_t>(0, std::min<int64_t>(90, gArgs.GetArg("-dbcachetrim", nDefaultDbCacheTrim)));
+            if (pcoinsStats) {
+                // Written together with the new best block, so that both always match on disk.
+                pcoinsdbview->SetCoinsStats(*pcoinsStats);
+            }
+            bool fFlushed;
+            if (mode == FLUSH_STATE_ALWAYS || nTrimPercent == 0) {
+                fFlushed = pcoinsTip->Flush();
+            } else {
+                fFlushed = pcoinsTip->Trim((fCacheLarge || fCacheCritical) ? nTotalSpace * nTrimPercent / 100 : nTotalSpace);
+            }
+            if (!fFlushed)
                 return AbortNode(state, "Failed to write to coin database");
             nLastFlush = nNow;
         }
@@ -2324,6 +2479,7 @@ void static UpdateTip(const CBlockIndex *pindexNew, const CChainParams& chainPar
         LogPrintf(" warning='%s'", boost::algorithm::join(warningMessages, ", "));
     LogPrintf("\n");
 
+    PublishChainStateSummary();
 }
 
 /** Disconnect chainActive's tip.
@@ -2355,6 +2511,12 @@ bool CChainState::DisconnectTip(CValidationState& state, const CChainParams& cha
         bool flushed = view.Flush();
         assert(flushed);
     }
+    if (pcoinsStats) {
+        CBlockUndo blockundo;
+        if (!UndoReadFromDisk(blockundo, pindexDelete))
+            return AbortNode(state, "Failed to read undo data");
+        pcoinsStats->DisconnectBlock(block, blockundo, pindexDelete->nHeight);
+    }
     LogPrint(BCLog::BENCH, "- Disconnect block: %.2fms\n", (GetTimeMicros() - nStart) * MILLI);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(chainparams, state, FLUSH_STATE_IF_NEEDED))
@@ -2480,7 +2642,8 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     LogPrint(BCLog::BENCH, "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO);
     {
         CCoinsViewCache view(pcoinsTip.get());
-        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, chainparams);
+        CBlockUndo blockundo;
+        bool rv = ConnectBlock(blockConnecting, state, pindexNew, view, chainparams, false, pcoinsStats ? &blockundo : nullptr);
         GetMainSignals().BlockChecked(blockConnecting, state);
         if (!rv) {
             if (state.IsInvalid())
@@ -2491,6 +2654,14 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         LogPrint(BCLog::BENCH, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime3 - nTime2) * MILLI, nTimeConnectTotal * MICRO, nTimeConnectTotal * MILLI / nBlocksTotal);
         bool flushed = view.Flush();
         assert(flushed);
+        if (pcoinsStats) {
+            if (pindexNew->pprev == nullptr) {
+                // The outputs of the genesis block are not added to the UTXO set.
+                pcoinsStats->hashBlock = pindexNew->GetBlockHash();
+            } else {
+                pcoinsStats->ConnectBlock(blockConnecting, blockundo, pindexNew->nHeight);
+            }
+        }
     }
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
     LogPrint(BCLog::BENCH, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime4 - nTime3) * MILLI, nTimeFlush * MICRO, nTimeFlush * MILLI / nBlocksTotal);
@@ -2715,12 +2886,11 @@ bool CChainState::ActivateBestChain(CValidationState &state, const CChainParams&
     do {
         boost::this_thread::interruption_point();
 
-        if (GetMainSignals().CallbacksPending() > 10) {
-            // Block until the validation queue drains. This should largely
-            // never happen in normal operation, however may happen during
-            // reindex, causing memory blowup  if we run too far ahead.
-            SyncWithValidationInterfaceQueue();
-        }
+        // Block until the validation queues drain if a listener is far
+        // behind. This should largely never happen in normal operation,
+        // however may happen during reindex, causing memory blowup if we run
+        // too far ahead.
+        LimitValidationInterfaceQueue();
 
         {
             LOCK(cs_main);
@@ -2956,8 +3126,10 @@ CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block)
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + GetBlockProof(*pindexNew);
     pindexNew->RaiseValidity(BLOCK_VALID_TREE);
-    if (pindexBestHeader == nullptr || pindexBestHeader->nChainWork < pindexNew->nChainWork)
+    if (pindexBestHeader == nullptr || pindexBestHeader->nChainWork < pindexNew->nChainWork) {
         pindexBestHeader = pindexNew;
+        PublishBestHeader();
+    }
 
     setDirtyBlockIndex.insert(pindexNew);
 
@@ -3941,8 +4113,6 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     if(fReindexing) fReindex = true;
 
     // Check whether we have a transaction index
-    pblocktree->ReadFlag("txindex", fTxIndex);
-    LogPrintf("%s: transaction index %s\n", __func__, fTxIndex ? "enabled" : "disabled");
 
     return true;
 }
@@ -3966,6 +4136,7 @@ bool LoadChainTip(const CChainParams& chainparams)
     if (it == mapBlockIndex.end())
         return false;
     chainActive.SetTip(it->second);
+    PublishChainStateSummary();
 
     g_chainstate.PruneBlockIndexCandidates();
 
@@ -3976,6 +4147,26 @@ bool LoadChainTip(const CChainParams& chainparams)
     return true;
 }
 
+bool LoadCoinsStats()
+{
+    LOCK(cs_main);
+    std::unique_ptr<CRollingCoinsStats> pstats(new CRollingCoinsStats());
+    if (pcoinsTip->GetBestBlock().IsNull()) {
+        // Empty chainstate; the statistics start at the genesis block.
+    } else if (!pcoinsdbview->ReadCoinsStats(*pstats) || pstats->hashBlock != pcoinsTip->GetBestBlock()) {
+        // Missing, or stale because -utxostats was not always set: recompute them from the database.
+        uiInterface.InitMessage(_("Computing UTXO set statistics..."));
+        LogPrintf("Computing UTXO set statistics at %s\n", pcoinsTip->GetBestBlock().ToString());
+        FlushStateToDisk();
+        CCoinsStats stats;
+        if (!GetUTXOStats(pcoinsdbview.get(), stats, pstats.get())) {
+            return false;
+        }
+    }
+    pcoinsStats = std::move(pstats);
+    return true;
+}
+
 CVerifyDB::CVerifyDB()
 {
     uiInterface.ShowProgress(_("Verifying blocks..."), 0, false);
@@ -4289,6 +4480,7 @@ void UnloadBlockIndex()
     chainActive.SetTip(nullptr);
     pindexBestInvalid = nullptr;
     pindexBestHeader = nullptr;
+    PublishChainStateSummary();
     mempool.clear();
     mapBlocksUnlinked.clear();
     vinfoBlockFile.clear();
@@ -4296,6 +4488,10 @@ void UnloadBlockIndex()
     setDirtyBlockIndex.clear();
     setDirtyFileInfo.clear();
     versionbitscache.Clear();
+    {
+        LOCK(cs_versionbits_tip);
+        versionbitscache_tip.Clear();
+    }
     for (int b = 0; b < VERSIONBITS_NUM_BITS; b++) {
         warningcache[b].clear();
     }
@@ -4327,9 +4523,6 @@ bool LoadBlockIndex(const CChainParams& chainparams)
         // needs_init.
 
         LogPrintf("Initializing databases...\n");
-        // Use the provided setting for -txindex in the new database
-        fTxIndex = gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX);
-        pblocktree->WriteFlag("txindex", fTxIndex);
     }
     return true;
 }
@@ -4679,25 +4872,82 @@ CBlockFileInfo* GetBlockFileInfo(size_t n)
     return &vinfoBlockFile.at(n);
 }
 
-ThresholdState VersionBitsTipState(const Consensus::Params& params, Consensus::DeploymentPos pos)
+ThresholdState VersionBitsTipState(const CBlockIndex* pindexTip, const Consensus::Params& params, Consensus::DeploymentPos pos)
 {
-    LOCK(cs_main);
-    return VersionBitsState(chainActive.Tip(), params, pos, versionbitscache);
+    LOCK(cs_versionbits_tip);
+    return VersionBitsState(pindexTip, params, pos, versionbitscache_tip);
 }
 
-BIP9Stats VersionBitsTipStatistics(const Consensus::Params& params, Consensus::DeploymentPos pos)
+BIP9Stats VersionBitsTipStatistics(const CBlockIndex* pindexTip, const Consensus::Params& params, Consensus::DeploymentPos pos)
 {
-    LOCK(cs_main);
-    return VersionBitsStatistics(chainActive.Tip(), params, pos);
+    // Only reads fields of the blocks that do not change
+    return VersionBitsStatistics(pindexTip, params, pos);
+}
+
+int VersionBitsTipStateSinceHeight(const CBlockIndex* pindexTip, const Consensus::Params& params, Consensus::DeploymentPos pos)
+{
+    LOCK(cs_versionbits_tip);
+    return VersionBitsStateSinceHeight(pindexTip, params, pos, versionbitscache_tip);
 }
 
-int VersionBitsTipStateSinceHeight(const Consensus::Params& params, Consensus::DeploymentPos pos)
+/** mempool.dat without a checksum, as written by older versions */
+static const uint64_t MEMPOOL_DUMP_VERSION_NO_CHECKSUM = 1;
+static const uint64_t MEMPOOL_DUMP_VERSION = 2;
+
+//! Number of transactions from mempool.dat that are script checked in parallel at once
+static const size_t MEMPOOL_LOAD_BATCH_SIZE = 1000;
+
+/**
+ * Return the secret that mempool.dat checksums are keyed with. It is kept in
+ * the block tree database, so a checksum that matches on load means the file
+ * was written by this node rather than copied in from elsewhere.
+ */
+static uint256 GetMempoolDumpKey()
 {
+    static uint256 key;
     LOCK(cs_main);
-    return VersionBitsStateSinceHeight(chainActive.Tip(), params, pos, versionbitscache);
+    if (key.IsNull() && pblocktree && !pblocktree->ReadMempoolKey(key)) {
+        key = GetRandHash();
+        if (!pblocktree->WriteMempoolKey(key)) {
+            key.SetNull();
+        }
+    }
+    return key;
 }
 
-static const uint64_t MEMPOOL_DUMP_VERSION = 1;
+/**
+ * Verify the scripts of a batch of transactions on the script check threads,
+ * so that the signature cache is warm when they are then accepted one by one.
+ * Failures are ignored here: AcceptToMemoryPool repeats the checks and
+ * reports them.
+ */
+static void PreCheckMempoolScripts(const std::vector<CTransactionRef>& vtx)
+{
+    if (nScriptCheckThreads == 0 || vtx.empty()) {
+        return;
+    }
+    LOCK2(cs_main, mempool.cs);
+    CCoinsViewMemPool viewMemPool(pcoinsTip.get(), mempool);
+    CCoinsViewCache view(&viewMemPool);
+    // The queued checks point into txdata, so it must not reallocate.
+    std::vector<PrecomputedTransactionData> txdata;
+    txdata.reserve(vtx.size());
+    CCheckQueueControl<CScriptCheck> control(&scriptcheckqueue);
+    for (const CTransactionRef& ptx : vtx) {
+        const CTransaction& tx = *ptx;
+        if (tx.IsCoinBase() || !view.HaveInputs(tx)) {
+            continue;
+        }
+        txdata.emplace_back(tx);
+        std::vector<CScriptCheck> vChecks;
+        CValidationState state;
+        CheckInputs(tx, state, view, true, STANDARD_SCRIPT_VERIFY_FLAGS, true, false, txdata.back(), &vChecks);
+        control.Add(vChecks);
+        // Later transactions in the batch may spend this one.
+        AddCoins(view, tx, MEMPOOL_HEIGHT, true);
+    }
+    control.Wait();
+}
 
 bool LoadMempool(void)
 {
@@ -4716,31 +4966,73 @@ bool LoadMempool(void)
     int64_t already_there = 0;
     int64_t nNow = GetTime();
 
+    struct DumpedTx {
+        CTransactionRef tx;
+        int64_t nTime;
+        int64_t nFeeDelta;
+    };
+    std::vector<DumpedTx> vDumped;
+    std::map<uint256, CAmount> mapDeltas;
+    bool fTrusted = false;
+
     try {
+        // Read the whole file first: whether its transactions can skip script
+        // checks is only known once its checksum has been verified.
+        const uint256 key = GetMempoolDumpKey();
+        CHashVerifier<CAutoFile> verifier(&file);
+        verifier << key;
         uint64_t version;
-        file >> version;
-        if (version != MEMPOOL_DUMP_VERSION) {
+        verifier >> version;
+        if (version != MEMPOOL_DUMP_VERSION && version != MEMPOOL_DUMP_VERSION_NO_CHECKSUM) {
             return false;
         }
         uint64_t num;
-        file >> num;
+        verifier >> num;
         while (num--) {
-            CTransactionRef tx;
-            int64_t nTime;
-            int64_t nFeeDelta;
-            file >> tx;
-            file >> nTime;
-            file >> nFeeDelta;
-
-            CAmount amountdelta = nFeeDelta;
+            DumpedTx dumped;
+            verifier >> dumped.tx;
+            verifier >> dumped.nTime;
+            verifier >> dumped.nFeeDelta;
+            vDumped.push_back(std::move(dumped));
+        }
+        verifier >> mapDeltas;
+        if (version == MEMPOOL_DUMP_VERSION) {
+            uint256 hashChecksum;
+            file >> hashChecksum;
+            fTrusted = !key.IsNull() && hashChecksum == verifier.GetHash();
+        }
+    } catch (const std::exception& e) {
+        LogPrintf("Failed to deserialize mempool data on disk: %s. Continuing anyway.\n", e.what());
+        return false;
+    }
+    file.fclose();
+    if (fTrusted) {
+        LogPrintf("Mempool file was written by this node, skipping script checks of its %u transactions\n", vDumped.size());
+    }
+
+    for (size_t nBatchStart = 0; nBatchStart < vDumped.size(); nBatchStart += MEMPOOL_LOAD_BATCH_SIZE) {
+        const size_t nBatchEnd = std::min(vDumped.size(), nBatchStart + MEMPOOL_LOAD_BATCH_SIZE);
+        if (!fTrusted) {
+            std::vector<CTransactionRef> vtx;
+            for (size_t i = nBatchStart; i < nBatchEnd; i++) {
+                if (vDumped[i].nTime + nExpiryTimeout > nNow) {
+                    vtx.push_back(vDumped[i].tx);
+                }
+            }
+            PreCheckMempoolScripts(vtx);
+        }
+
+        for (size_t i = nBatchStart; i < nBatchEnd; i++) {
+            const CTransactionRef& tx = vDumped[i].tx;
+            CAmount amountdelta = vDumped[i].nFeeDelta;
             if (amountdelta) {
                 mempool.PrioritiseTransaction(tx->GetHash(), amountdelta);
             }
             CValidationState state;
-            if (nTime + nExpiryTimeout > nNow) {
+            if (vDumped[i].nTime + nExpiryTimeout > nNow) {
                 LOCK(cs_main);
-                AcceptToMemoryPoolWithTime(chainparams, mempool, state, tx, nullptr /* pfMissingInputs */, nTime,
-                                           nullptr /* plTxnReplaced */, false /* bypass_limits */, 0 /* nAbsurdFee */);
+                AcceptToMemoryPoolWithTime(chainparams, mempool, state, tx, nullptr /* pfMissingInputs */, vDumped[i].nTime,
+                                           nullptr /* plTxnReplaced */, false /* bypass_limits */, 0 /* nAbsurdFee */, fTrusted);
                 if (state.IsValid()) {
                     ++count;
                 } else {
@@ -4760,15 +5052,10 @@ bool LoadMempool(void)
             if (ShutdownRequested())
                 return false;
         }
-        std::map<uint256, CAmount> mapDeltas;
-        file >> mapDeltas;
+    }
 
-        for (const auto& i : mapDeltas) {
-            mempool.PrioritiseTransaction(i.first, i.second);
-        }
-    } catch (const std::exception& e) {
-        LogPrintf("Failed to deserialize mempool data on disk: %s. Continuing anyway.\n", e.what());
-        return false;
+    for (const auto& i : mapDeltas) {
+        mempool.PrioritiseTransaction(i.first, i.second);
     }
 
     LogPrintf("Imported mempool transactions from disk: %i succeeded, %i failed, %i expired, %i already there\n", count, failed, expired, already_there);
@@ -4777,8 +5064,13 @@ bool LoadMempool(void)
 
 bool DumpMempool(void)
 {
+    // Periodic dumps, savemempool and the dump at shutdown all use mempool.dat.new.
+    static CCriticalSection cs_dump;
+    LOCK(cs_dump);
+
     int64_t start = GetTimeMicros();
 
+    const uint256 key = GetMempoolDumpKey();
     std::map<uint256, CAmount> mapDeltas;
     std::vector<TxMempoolInfo> vinfo;
 
@@ -4799,19 +5091,30 @@ bool DumpMempool(void)
         }
 
         CAutoFile file(filestr, SER_DISK, CLIENT_VERSION);
+        // Everything written is hashed too, keyed so that LoadMempool can tell
+        // this node's own dumps apart.
+        CHashWriter hasher(SER_DISK, CLIENT_VERSION);
+        hasher << key;
 
         uint64_t version = MEMPOOL_DUMP_VERSION;
         file << version;
+        hasher << version;
 
         file << (uint64_t)vinfo.size();
+        hasher << (uint64_t)vinfo.size();
         for (const auto& i : vinfo) {
             file << *(i.tx);
             file << (int64_t)i.nTime;
             file << (int64_t)i.nFeeDelta;
+            hasher << *(i.tx);
+            hasher << (int64_t)i.nTime;
+            hasher << (int64_t)i.nFeeDelta;
             mapDeltas.erase(i.tx->GetHash());
         }
 
         file << mapDeltas;
+        hasher << mapDeltas;
+        file << hasher.GetHash();
         FileCommit(file.Get());
         file.fclose();
         RenameOver(GetDataDir() / "mempool.dat.new", GetDataDir() / "mempool.dat");
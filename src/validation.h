@@ -11,12 +11,14 @@
 #endif
 
 #include <amount.h>
+#include <arith_uint256.h>
 #include <coins.h>
 #include <fs.h>
 #include <protocol.h> // For CMessageHeader::MessageStartChars
 #include <policy/feerate.h>
 #include <script/script_error.h>
 #include <sync.h>
+#include <uint256.h>
 #include <versionbits.h>
 
 #include <algorithm>
@@ -32,9 +34,11 @@
 #include <atomic>
 
 class CBlockIndex;
+class CBlockUndo;
 class CBlockTreeDB;
 class CChainParams;
 class CCoinsViewDB;
+class CRollingCoinsStats;
 class CInv;
 class CConnman;
 class CScriptCheck;
@@ -81,6 +85,8 @@ static const unsigned int UNDOFILE_CHUNK_SIZE = 0x100000; // 1 MiB
 static const int MAX_SCRIPTCHECK_THREADS = 16;
 /** -par default (number of script-checking threads, 0 = auto) */
 static const int DEFAULT_SCRIPTCHECK_THREADS = 0;
+/** Minimum number of uncached coins spent by a block to read them on the coins prefetch threads */
+static const unsigned int MIN_PREFETCH_COINS = 16;
 /** Number of blocks that can be requested at any given time from a single peer. */
 static const int MAX_BLOCKS_IN_TRANSIT_PER_PEER = 16;
 /** Timeout in seconds during which a peer must stall block download progress before being disconnected. */
@@ -130,10 +136,11 @@ static const int64_t MAX_FEE_ESTIMATION_TIP_AGE = 3 * 60 * 60;
 /** Default for -permitbaremultisig */
 static const bool DEFAULT_PERMIT_BAREMULTISIG = true;
 static const bool DEFAULT_CHECKPOINTS_ENABLED = true;
-static const bool DEFAULT_TXINDEX = false;
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 /** Default for -persistmempool */
 static const bool DEFAULT_PERSIST_MEMPOOL = true;
+/** Default for -persistmempoolinterval, in minutes */
+static const int64_t DEFAULT_PERSIST_MEMPOOL_INTERVAL = 30;
 /** Default for -mempoolreplacement */
 static const bool DEFAULT_ENABLE_REPLACEMENT = false;
 /** Default for using fee filter */
@@ -170,7 +177,6 @@ extern uint256 hashBestBlock;
 extern std::atomic_bool fImporting;
 extern std::atomic_bool fReindex;
 extern int nScriptCheckThreads;
-extern bool fTxIndex;
 extern bool fIsBareMultisigStd;
 extern bool fRequireStandard;
 extern bool fCheckBlockIndex;
@@ -270,10 +276,14 @@ bool LoadGenesisBlock(const CChainParams& chainparams);
 bool LoadBlockIndex(const CChainParams& chainparams);
 /** Update the chain tip based on database information. */
 bool LoadChainTip(const CChainParams& chainparams);
+/** Load the UTXO set statistics for the chainstate tip, computing them if needed (-utxostats) */
+bool LoadCoinsStats();
 /** Unload database information */
 void UnloadBlockIndex();
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
+/** Run an instance of the coins prefetch thread */
+void ThreadCoinsPrefetch();
 /** Check whether we are doing an initial block download (synchronizing from disk or network) */
 bool IsInitialBlockDownload();
 /** Retrieve a transaction (from memory pool, or from disk, if possible) */
@@ -288,6 +298,31 @@ double GuessVerificationProgress(const ChainTxData& data, const CBlockIndex* pin
 /** Calculate the amount of disk space the block & undo files currently use */
 uint64_t CalculateCurrentUsage();
 
+/**
+ * The state of the active chain, published whenever the tip or the best
+ * header changes, so that it can be read without cs_main. pindexTip stays
+ * valid while the block index is loaded, but only its fields that do not
+ * change once it is in the active chain may be read without cs_main.
+ */
+struct ChainStateSummary
+{
+    const CBlockIndex* pindexTip = nullptr;
+    uint256 hashTip;
+    int nHeight = -1;
+    arith_uint256 nChainWork;
+    int64_t nMedianTimePast = 0;
+    bool fInitialDownload = true;
+    //! Height of the best header, -1 if there is none
+    int nHeaders = -1;
+    //! Space used by the block and undo files, see CalculateCurrentUsage
+    uint64_t nSizeOnDisk = 0;
+    //! Lowest height from which on all blocks up to the tip are stored, if pruning
+    int nPruneHeight = 0;
+};
+
+/** The last published state of the active chain, never null. Does not lock cs_main. */
+std::shared_ptr<const ChainStateSummary> GetChainStateSummary();
+
 bool CheckTransactionForNoBlackListedAddresses(const CTransaction& tx, const Consensus::Params& consensusParams);
 
 /**
@@ -316,14 +351,17 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
 /** Convert CValidationState to a human-readable message for logging */
 std::string FormatStateMessage(const CValidationState &state);
 
-/** Get the BIP9 state for a given deployment at the current tip. */
-ThresholdState VersionBitsTipState(const Consensus::Params& params, Consensus::DeploymentPos pos);
+/* The BIP9 functions below take a tip of the active chain, such as the one of
+ * GetChainStateSummary, and do not lock cs_main. */
+
+/** Get the BIP9 state for a given deployment at pindexTip. */
+ThresholdState VersionBitsTipState(const CBlockIndex* pindexTip, const Consensus::Params& params, Consensus::DeploymentPos pos);
 
-/** Get the numerical statistics for the BIP9 state for a given deployment at the current tip. */
-BIP9Stats VersionBitsTipStatistics(const Consensus::Params& params, Consensus::DeploymentPos pos);
+/** Get the numerical statistics for the BIP9 state for a given deployment at pindexTip. */
+BIP9Stats VersionBitsTipStatistics(const CBlockIndex* pindexTip, const Consensus::Params& params, Consensus::DeploymentPos pos);
 
-/** Get the block height at which the BIP9 deployment switched into the state for the block building on the current tip. */
-int VersionBitsTipStateSinceHeight(const Consensus::Params& params, Consensus::DeploymentPos pos);
+/** Get the block height at which the BIP9 deployment switched into the state for the block building on pindexTip. */
+int VersionBitsTipStateSinceHeight(const CBlockIndex* pindexTip, const Consensus::Params& params, Consensus::DeploymentPos pos);
 
 
 /** Apply the effects of this transaction on the UTXO set represented by view */
@@ -400,6 +438,10 @@ void InitScriptExecutionCache();
 /** Functions for disk access for blocks */
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+/** Read the serialized block at pos as it is stored, without deserializing or checking it */
+bool ReadRawBlockFromDisk(std::vector<uint8_t>& block, const CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& message_start);
+/** Read the undo data of the block after hashPrevBlock, stored at pos */
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashPrevBlock);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -453,6 +495,9 @@ extern std::unique_ptr<CCoinsViewDB> pcoinsdbview;
 /** Global variable that points to the active CCoinsView (protected by cs_main) */
 extern std::unique_ptr<CCoinsViewCache> pcoinsTip;
 
+/** Global variable that points to the incrementally maintained UTXO set statistics, if enabled (protected by cs_main) */
+extern std::unique_ptr<CRollingCoinsStats> pcoinsStats;
+
 /** Global variable that points to the active block tree (protected by cs_main) */
 extern std::unique_ptr<CBlockTreeDB> pblocktree;
 
@@ -481,10 +526,14 @@ static const unsigned int REJECT_HIGHFEE = 0x100;
 /** Get block file info entry for one block file */
 CBlockFileInfo* GetBlockFileInfo(size_t n);
 
-/** Dump the mempool to disk. */
+/** Dump the mempool to disk. Safe to call from any thread; the mempool is only locked while it is copied. */
 bool DumpMempool();
 
-/** Load the mempool from disk. */
+/**
+ * Load the mempool from disk. Transactions from a file this node wrote itself
+ * skip script verification; others have their scripts pre-checked in parallel
+ * batches on the script check threads.
+ */
 bool LoadMempool();
 
 #endif // BITCOIN_VALIDATION_H
@@ -11,31 +11,89 @@
 #include <sync.h>
 #include <txmempool.h>
 #include <util.h>
+#include <utiltime.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <list>
 #include <atomic>
 #include <future>
 
-#include <boost/signals2/signal.hpp>
+/** A registered listener and the queue of its background callbacks */
+struct ValidationSubscriber {
+    CValidationInterface* const m_callbacks;
+    const std::string m_name;
+    //! Cleared when unregistered, after which its queued callbacks are dropped
+    std::atomic<bool> m_active;
+    SingleThreadedSchedulerClient m_schedulerClient;
+
+    // Statistics, only updated by the callbacks in the queue, which run one at a time
+    std::atomic<uint64_t> m_processed{0};
+    std::atomic<int64_t> m_wait_time{0};
+    std::atomic<int64_t> m_max_wait_time{0};
+    std::atomic<int64_t> m_run_time{0};
+    std::atomic<int64_t> m_max_run_time{0};
+
+    ValidationSubscriber(CValidationInterface* callbacks, CScheduler* pscheduler) :
+        m_callbacks(callbacks), m_name(callbacks->GetSubscriberName()), m_active(true), m_schedulerClient(pscheduler) {}
+
+    void AddToProcessQueue(const std::function<void (CValidationInterface*)>& func) {
+        const int64_t nQueued = GetTimeMicros();
+        m_schedulerClient.AddToProcessQueue([this, func, nQueued] {
+            if (!m_active) return;
+            const int64_t nStart = GetTimeMicros();
+            func(m_callbacks);
+            const int64_t nEnd = GetTimeMicros();
+
+            m_processed++;
+            m_wait_time += nStart - nQueued;
+            m_run_time += nEnd - nStart;
+            if (nStart - nQueued > m_max_wait_time) m_max_wait_time = nStart - nQueued;
+            if (nEnd - nStart > m_max_run_time) m_max_run_time = nEnd - nStart;
+        });
+    }
+};
 
 struct MainSignalsInstance {
-    boost::signals2::signal<void (const CBlockIndex *, const CBlockIndex *, bool fInitialDownload)> UpdatedBlockTip;
-    boost::signals2::signal<void (const CTransactionRef &)> TransactionAddedToMempool;
-    boost::signals2::signal<void (const std::shared_ptr<const CBlock> &, const CBlockIndex *pindex, const std::vector<CTransactionRef>&)> BlockConnected;
-    boost::signals2::signal<void (const std::shared_ptr<const CBlock> &)> BlockDisconnected;
-    boost::signals2::signal<void (const CTransactionRef &)> TransactionRemovedFromMempool;
-    boost::signals2::signal<void (const CBlockLocator &)> SetBestChain;
-    boost::signals2::signal<void (int64_t nBestBlockTime, CConnman* connman)> Broadcast;
-    boost::signals2::signal<void (const CBlock&, const CValidationState&)> BlockChecked;
-    boost::signals2::signal<void (const CBlockIndex *, const std::shared_ptr<const CBlock>&)> NewPoWValidBlock;
-
-    // We are not allowed to assume the scheduler only runs in one thread,
-    // but must ensure all callbacks happen in-order, so we end up creating
-    // our own queue here :(
+    CScheduler* const m_pscheduler;
+
+    // Queue for the callbacks of CallFunctionInValidationInterfaceQueue,
+    // which also makes them run when there are no listeners
     SingleThreadedSchedulerClient m_schedulerClient;
 
-    explicit MainSignalsInstance(CScheduler *pscheduler) : m_schedulerClient(pscheduler) {}
+    CCriticalSection m_cs_subscribers;
+    //! Listeners are never removed, only deactivated, as the scheduler can
+    //! still hold on to their queue
+    std::list<ValidationSubscriber> m_subscribers;
+
+    //! Times LimitValidationInterfaceQueue made validation wait, and for how long in total
+    std::atomic<uint64_t> m_limit_waits{0};
+    std::atomic<int64_t> m_limit_wait_time{0};
+
+    explicit MainSignalsInstance(CScheduler *pscheduler) : m_pscheduler(pscheduler), m_schedulerClient(pscheduler) {}
+
+    std::vector<ValidationSubscriber*> GetSubscribers(bool fActiveOnly) {
+        LOCK(m_cs_subscribers);
+        std::vector<ValidationSubscriber*> vSubscribers;
+        for (ValidationSubscriber& subscriber : m_subscribers) {
+            if (!fActiveOnly || subscriber.m_active) vSubscribers.push_back(&subscriber);
+        }
+        return vSubscribers;
+    }
+
+    /** Queue func for each listener */
+    void AddToProcessQueues(const std::function<void (CValidationInterface*)>& func) {
+        for (ValidationSubscriber* subscriber : GetSubscribers(true)) {
+            subscriber->AddToProcessQueue(func);
+        }
+    }
+
+    /** Call func for each listener on the calling thread */
+    void CallSubscribers(const std::function<void (CValidationInterface*)>& func) {
+        for (ValidationSubscriber* subscriber : GetSubscribers(true)) {
+            func(subscriber->m_callbacks);
+        }
+    }
 };
 
 static CMainSignals g_signals;
@@ -51,13 +109,42 @@ void CMainSignals::UnregisterBackgroundSignalScheduler() {
 
 void CMainSignals::FlushBackgroundCallbacks() {
     if (m_internals) {
+        for (ValidationSubscriber* subscriber : m_internals->GetSubscribers(false)) {
+            subscriber->m_schedulerClient.EmptyQueue();
+        }
         m_internals->m_schedulerClient.EmptyQueue();
     }
 }
 
 size_t CMainSignals::CallbacksPending() {
     if (!m_internals) return 0;
-    return m_internals->m_schedulerClient.CallbacksPending();
+    size_t nPending = m_internals->m_schedulerClient.CallbacksPending();
+    for (ValidationSubscriber* subscriber : m_internals->GetSubscribers(false)) {
+        nPending = std::max(nPending, subscriber->m_schedulerClient.CallbacksPending());
+    }
+    return nPending;
+}
+
+std::vector<ValidationQueueStats> CMainSignals::GetQueueStats(uint64_t& nLimitWaits, int64_t& nLimitWaitTime) {
+    std::vector<ValidationQueueStats> vStats;
+    nLimitWaits = 0;
+    nLimitWaitTime = 0;
+    if (!m_internals) return vStats;
+
+    nLimitWaits = m_internals->m_limit_waits;
+    nLimitWaitTime = m_internals->m_limit_wait_time;
+    for (ValidationSubscriber* subscriber : m_internals->GetSubscribers(true)) {
+        ValidationQueueStats stats;
+        stats.name = subscriber->m_name;
+        stats.nPending = subscriber->m_schedulerClient.CallbacksPending();
+        stats.nProcessed = subscriber->m_processed;
+        stats.nWaitTime = subscriber->m_wait_time;
+        stats.nMaxWaitTime = subscriber->m_max_wait_time;
+        stats.nRunTime = subscriber->m_run_time;
+        stats.nMaxRunTime = subscriber->m_max_run_time;
+        vStats.push_back(stats);
+    }
+    return vStats;
 }
 
 void CMainSignals::RegisterWithMempoolSignals(CTxMemPool& pool) {
@@ -74,46 +161,40 @@ CMainSignals& GetMainSignals()
 }
 
 void RegisterValidationInterface(CValidationInterface* pwalletIn) {
-    g_signals.m_internals->UpdatedBlockTip.connect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->TransactionAddedToMempool.connect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1));
-    g_signals.m_internals->BlockConnected.connect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->BlockDisconnected.connect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1));
-    g_signals.m_internals->TransactionRemovedFromMempool.connect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1));
-    g_signals.m_internals->SetBestChain.connect(boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1));
-    g_signals.m_internals->Broadcast.connect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
-    g_signals.m_internals->BlockChecked.connect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
-    g_signals.m_internals->NewPoWValidBlock.connect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
+    LOCK(g_signals.m_internals->m_cs_subscribers);
+    g_signals.m_internals->m_subscribers.emplace_back(pwalletIn, g_signals.m_internals->m_pscheduler);
 }
 
 void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
-    g_signals.m_internals->BlockChecked.disconnect(boost::bind(&CValidationInterface::BlockChecked, pwalletIn, _1, _2));
-    g_signals.m_internals->Broadcast.disconnect(boost::bind(&CValidationInterface::ResendWalletTransactions, pwalletIn, _1, _2));
-    g_signals.m_internals->SetBestChain.disconnect(boost::bind(&CValidationInterface::SetBestChain, pwalletIn, _1));
-    g_signals.m_internals->TransactionAddedToMempool.disconnect(boost::bind(&CValidationInterface::TransactionAddedToMempool, pwalletIn, _1));
-    g_signals.m_internals->BlockConnected.disconnect(boost::bind(&CValidationInterface::BlockConnected, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->BlockDisconnected.disconnect(boost::bind(&CValidationInterface::BlockDisconnected, pwalletIn, _1));
-    g_signals.m_internals->TransactionRemovedFromMempool.disconnect(boost::bind(&CValidationInterface::TransactionRemovedFromMempool, pwalletIn, _1));
-    g_signals.m_internals->UpdatedBlockTip.disconnect(boost::bind(&CValidationInterface::UpdatedBlockTip, pwalletIn, _1, _2, _3));
-    g_signals.m_internals->NewPoWValidBlock.disconnect(boost::bind(&CValidationInterface::NewPoWValidBlock, pwalletIn, _1, _2));
+    LOCK(g_signals.m_internals->m_cs_subscribers);
+    for (ValidationSubscriber& subscriber : g_signals.m_internals->m_subscribers) {
+        if (subscriber.m_callbacks == pwalletIn) subscriber.m_active = false;
+    }
 }
 
 void UnregisterAllValidationInterfaces() {
     if (!g_signals.m_internals) {
         return;
     }
-    g_signals.m_internals->BlockChecked.disconnect_all_slots();
-    g_signals.m_internals->Broadcast.disconnect_all_slots();
-    g_signals.m_internals->SetBestChain.disconnect_all_slots();
-    g_signals.m_internals->TransactionAddedToMempool.disconnect_all_slots();
-    g_signals.m_internals->BlockConnected.disconnect_all_slots();
-    g_signals.m_internals->BlockDisconnected.disconnect_all_slots();
-    g_signals.m_internals->TransactionRemovedFromMempool.disconnect_all_slots();
-    g_signals.m_internals->UpdatedBlockTip.disconnect_all_slots();
-    g_signals.m_internals->NewPoWValidBlock.disconnect_all_slots();
+    LOCK(g_signals.m_internals->m_cs_subscribers);
+    for (ValidationSubscriber& subscriber : g_signals.m_internals->m_subscribers) {
+        subscriber.m_active = false;
+    }
 }
 
 void CallFunctionInValidationInterfaceQueue(std::function<void ()> func) {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    // Put a marker in every queue and call func once the last one reaches it,
+    // when all the callbacks queued before are done. The queues carry on
+    // with the callbacks after it meanwhile.
+    std::vector<ValidationSubscriber*> vSubscribers = g_signals.m_internals->GetSubscribers(false);
+    std::shared_ptr<std::atomic<size_t>> pRemaining = std::make_shared<std::atomic<size_t>>(vSubscribers.size() + 1);
+    auto marker = [pRemaining, func] {
+        if (--*pRemaining == 0) func();
+    };
+    for (ValidationSubscriber* subscriber : vSubscribers) {
+        subscriber->m_schedulerClient.AddToProcessQueue(marker);
+    }
+    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(marker);
 }
 
 void SyncWithValidationInterfaceQueue() {
@@ -126,10 +207,21 @@ void SyncWithValidationInterfaceQueue() {
     promise.get_future().wait();
 }
 
+void LimitValidationInterfaceQueue() {
+    AssertLockNotHeld(cs_main);
+
+    if (GetMainSignals().CallbacksPending() > MAX_VALIDATION_QUEUE_CALLBACKS) {
+        const int64_t nStart = GetTimeMicros();
+        SyncWithValidationInterfaceQueue();
+        g_signals.m_internals->m_limit_waits++;
+        g_signals.m_internals->m_limit_wait_time += GetTimeMicros() - nStart;
+    }
+}
+
 void CMainSignals::MempoolEntryRemoved(CTransactionRef ptx, MemPoolRemovalReason reason) {
     if (reason != MemPoolRemovalReason::BLOCK && reason != MemPoolRemovalReason::CONFLICT) {
-        m_internals->m_schedulerClient.AddToProcessQueue([ptx, this] {
-            m_internals->TransactionRemovedFromMempool(ptx);
+        m_internals->AddToProcessQueues([ptx, reason](CValidationInterface* callbacks) {
+            callbacks->TransactionRemovedFromMempool(ptx, reason);
         });
     }
 }
@@ -139,43 +231,49 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockInd
     // the chain actually updates. One way to ensure this is for the caller to invoke this signal
     // in the same critical section where the chain is updated
 
-    m_internals->m_schedulerClient.AddToProcessQueue([pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
+    m_internals->AddToProcessQueues([pindexNew, pindexFork, fInitialDownload](CValidationInterface* callbacks) {
+        callbacks->UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     });
 }
 
 void CMainSignals::TransactionAddedToMempool(const CTransactionRef &ptx) {
-    m_internals->m_schedulerClient.AddToProcessQueue([ptx, this] {
-        m_internals->TransactionAddedToMempool(ptx);
+    m_internals->AddToProcessQueues([ptx](CValidationInterface* callbacks) {
+        callbacks->TransactionAddedToMempool(ptx);
     });
 }
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex, const std::shared_ptr<const std::vector<CTransactionRef>>& pvtxConflicted) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pblock, pindex, pvtxConflicted, this] {
-        m_internals->BlockConnected(pblock, pindex, *pvtxConflicted);
+    m_internals->AddToProcessQueues([pblock, pindex, pvtxConflicted](CValidationInterface* callbacks) {
+        callbacks->BlockConnected(pblock, pindex, *pvtxConflicted);
     });
 }
 
 void CMainSignals::BlockDisconnected(const std::shared_ptr<const CBlock> &pblock) {
-    m_internals->m_schedulerClient.AddToProcessQueue([pblock, this] {
-        m_internals->BlockDisconnected(pblock);
+    m_internals->AddToProcessQueues([pblock](CValidationInterface* callbacks) {
+        callbacks->BlockDisconnected(pblock);
     });
 }
 
 void CMainSignals::SetBestChain(const CBlockLocator &locator) {
-    m_internals->m_schedulerClient.AddToProcessQueue([locator, this] {
-        m_internals->SetBestChain(locator);
+    m_internals->AddToProcessQueues([locator](CValidationInterface* callbacks) {
+        callbacks->SetBestChain(locator);
     });
 }
 
 void CMainSignals::Broadcast(int64_t nBestBlockTime, CConnman* connman) {
-    m_internals->Broadcast(nBestBlockTime, connman);
+    m_internals->CallSubscribers([nBestBlockTime, connman](CValidationInterface* callbacks) {
+        callbacks->ResendWalletTransactions(nBestBlockTime, connman);
+    });
 }
 
 void CMainSignals::BlockChecked(const CBlock& block, const CValidationState& state) {
-    m_internals->BlockChecked(block, state);
+    m_internals->CallSubscribers([&block, &state](CValidationInterface* callbacks) {
+        callbacks->BlockChecked(block, state);
+    });
 }
 
 void CMainSignals::NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock> &block) {
-    m_internals->NewPoWValidBlock(pindex, block);
+    m_internals->CallSubscribers([pindex, &block](CValidationInterface* callbacks) {
+        callbacks->NewPoWValidBlock(pindex, block);
+    });
 }
@@ -10,6 +10,8 @@
 
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 class CBlock;
 class CBlockIndex;
@@ -24,6 +26,13 @@ class CScheduler;
 class CTxMemPool;
 enum class MemPoolRemovalReason;
 
+/** Default for -schedulerthreads, the threads running background callbacks and scheduled tasks */
+static const int DEFAULT_SCHEDULER_THREADS = 4;
+/** Maximum number of scheduler threads */
+static const int MAX_SCHEDULER_THREADS = 16;
+/** Callbacks a subscriber can be behind before validation waits for it, see LimitValidationInterfaceQueue */
+static const size_t MAX_VALIDATION_QUEUE_CALLBACKS = 10;
+
 // These functions dispatch to one or all registered wallets
 
 /** Register a wallet to receive updates from core */
@@ -35,6 +44,7 @@ void UnregisterAllValidationInterfaces();
 /**
  * Pushes a function to callback onto the notification queue, guaranteeing any
  * callbacks generated prior to now are finished when the function is called.
+ * Callbacks generated after it may already run while it is called.
  *
  * Be very careful blocking on func to be called if any locks are held -
  * validation interface clients may not be able to make progress as they often
@@ -52,6 +62,13 @@ void CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
  *     promise.get_future().wait();
  */
 void SyncWithValidationInterfaceQueue();
+/**
+ * Back-pressure for validation: if a subscriber is more than
+ * MAX_VALIDATION_QUEUE_CALLBACKS callbacks behind, wait until all queues are
+ * drained, so notifications cannot pile up without limit. Must not be called
+ * with cs_main held.
+ */
+void LimitValidationInterfaceQueue();
 
 class CValidationInterface {
 protected:
@@ -78,10 +95,11 @@ protected:
      * size limiting, reorg (changes in lock times/coinbase maturity), or
      * replacement. This does not include any transactions which are included
      * in BlockConnectedDisconnected either in block->vtx or in txnConflicted.
+     * reason tells which of these it was.
      *
      * Called on a background thread.
      */
-    virtual void TransactionRemovedFromMempool(const CTransactionRef &ptx) {}
+    virtual void TransactionRemovedFromMempool(const CTransactionRef &ptx, MemPoolRemovalReason reason) {}
     /**
      * Notifies listeners of a block being connected.
      * Provides a vector of transactions evicted from the mempool as a result.
@@ -114,12 +132,35 @@ protected:
      * Notifies listeners that a block which builds directly on our current tip
      * has been received and connected to the headers tree, though not validated yet */
     virtual void NewPoWValidBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& block) {};
+    /** Name of the listener in the validation queue statistics */
+    virtual std::string GetSubscriberName() const { return "unnamed"; }
+    friend class CMainSignals;
+    friend struct ValidationSubscriber;
     friend void ::RegisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
 };
 
+/** Queue depth and latency of the background callbacks of one listener */
+struct ValidationQueueStats
+{
+    std::string name;
+    size_t nPending;
+    uint64_t nProcessed;
+    //! Time callbacks waited in the queue and took to run, in microseconds
+    int64_t nWaitTime;
+    int64_t nMaxWaitTime;
+    int64_t nRunTime;
+    int64_t nMaxRunTime;
+};
+
 struct MainSignalsInstance;
+/**
+ * Dispatches the notifications of validation to the registered listeners.
+ * Background callbacks go to a queue per listener, so each listener gets them
+ * in order, while the scheduler threads run the queues of different listeners
+ * at the same time and a slow listener does not hold up the others.
+ */
 class CMainSignals {
 private:
     std::unique_ptr<MainSignalsInstance> m_internals;
@@ -128,6 +169,7 @@ private:
     friend void ::UnregisterValidationInterface(CValidationInterface*);
     friend void ::UnregisterAllValidationInterfaces();
     friend void ::CallFunctionInValidationInterfaceQueue(std::function<void ()> func);
+    friend void ::LimitValidationInterfaceQueue();
 
     void MempoolEntryRemoved(CTransactionRef tx, MemPoolRemovalReason reason);
 
@@ -139,7 +181,12 @@ public:
     /** Call any remaining callbacks on the calling thread */
     void FlushBackgroundCallbacks();
 
+    /** Callbacks not run yet by the listener furthest behind */
     size_t CallbacksPending();
+    /** Statistics of the queue of each registered listener */
+    /** Statistics of the queue of each registered listener, and how often and
+     *  how long in total (in microseconds) validation waited for them */
+    std::vector<ValidationQueueStats> GetQueueStats(uint64_t& nLimitWaits, int64_t& nLimitWaitTime);
 
     /** Register with mempool to call TransactionRemovedFromMempool callbacks */
     void RegisterWithMempoolSignals(CTxMemPool& pool);
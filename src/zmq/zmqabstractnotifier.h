@@ -7,8 +7,14 @@
 
 #include <zmq/zmqconfig.h>
 
+#include <memory>
+#include <utility>
+#include <vector>
+
 class CBlockIndex;
 class CZMQAbstractNotifier;
+class uint256;
+enum class MemPoolRemovalReason;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
@@ -32,8 +38,13 @@ public:
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
 
-    virtual bool NotifyBlock(const CBlockIndex *pindex);
+    /** Notify about a new tip. pblock is the block if it is at hand, otherwise nullptr. */
+    virtual bool NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock);
     virtual bool NotifyTransaction(const CTransaction &transaction);
+    /** Notify about transactions removed from the mempool, other than for being in or conflicting with a block */
+    virtual bool NotifyMempoolRemovals(const std::vector<std::pair<uint256, MemPoolRemovalReason>>& vRemoved);
+    virtual bool NotifyBlockConnected(const CBlock &block);
+    virtual bool NotifyBlockDisconnected(const CBlock &block);
 
 protected:
     void *psocket;
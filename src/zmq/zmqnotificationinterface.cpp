@@ -5,6 +5,7 @@
 #include <zmq/zmqnotificationinterface.h>
 #include <zmq/zmqpublishnotifier.h>
 
+#include <txmempool.h>
 #include <version.h>
 #include <validation.h>
 #include <streams.h>
@@ -39,6 +40,9 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubrawblock"] = CZMQAbstractNotifier::Create<CZMQPublishRawBlockNotifier>;
     factories["pubrawtx"] = CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+    factories["pubmempoolremoved"] = CZMQAbstractNotifier::Create<CZMQPublishMempoolRemovedNotifier>;
+    factories["pubblockconnected"] = CZMQAbstractNotifier::Create<CZMQPublishBlockConnectedNotifier>;
+    factories["pubblockdisconnected"] = CZMQAbstractNotifier::Create<CZMQPublishBlockDisconnectedNotifier>;
 
     for (const auto& entry : factories)
     {
@@ -124,15 +128,13 @@ void CZMQNotificationInterface::Shutdown()
     }
 }
 
-void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+template <typename Function>
+void CZMQNotificationInterface::TryForEachAndRemoveFailed(const Function& func)
 {
-    if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
-        return;
-
     for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
     {
         CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyBlock(pindexNew))
+        if (func(notifier))
         {
             i++;
         }
@@ -144,29 +146,81 @@ void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, co
     }
 }
 
+void CZMQNotificationInterface::FlushMempoolRemovals()
+{
+    LOCK(cs_notifiers);
+    if (vMempoolRemovals.empty())
+        return;
+
+    std::vector<std::pair<uint256, MemPoolRemovalReason>> vRemoved;
+    vRemoved.swap(vMempoolRemovals);
+    TryForEachAndRemoveFailed([&vRemoved](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyMempoolRemovals(vRemoved);
+    });
+}
+
+void CZMQNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
+{
+    LOCK(cs_notifiers);
+    // Notifications are delivered in order, so a block connected for the new
+    // tip came right before and need not be read back from disk
+    std::shared_ptr<const CBlock> pblock;
+    pblock.swap(pblockLastConnected);
+    if (pblock && pblock->GetHash() != pindexNew->GetBlockHash())
+        pblock.reset();
+
+    FlushMempoolRemovals();
+
+    if (fInitialDownload || pindexNew == pindexFork) // In IBD or blocks were disconnected without any new ones
+        return;
+
+    TryForEachAndRemoveFailed([pindexNew, &pblock](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlock(pindexNew, pblock);
+    });
+}
+
 void CZMQNotificationInterface::TransactionAddedToMempool(const CTransactionRef& ptx)
 {
+    LOCK(cs_notifiers);
     // Used by BlockConnected and BlockDisconnected as well, because they're
     // all the same external callback.
     const CTransaction& tx = *ptx;
 
-    for (std::list<CZMQAbstractNotifier*>::iterator i = notifiers.begin(); i!=notifiers.end(); )
-    {
-        CZMQAbstractNotifier *notifier = *i;
-        if (notifier->NotifyTransaction(tx))
-        {
-            i++;
-        }
-        else
-        {
-            notifier->Shutdown();
-            i = notifiers.erase(i);
-        }
-    }
+    FlushMempoolRemovals();
+
+    TryForEachAndRemoveFailed([&tx](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyTransaction(tx);
+    });
+}
+
+void CZMQNotificationInterface::TransactionRemovedFromMempool(const CTransactionRef& ptx, MemPoolRemovalReason reason)
+{
+    LOCK(cs_notifiers);
+    // Removals come one by one, but mostly many at a time (expiry, size
+    // limiting, replacement, reorg), so they are collected and published
+    // after the ones already queued with them
+    if (vMempoolRemovals.empty())
+        CallFunctionInValidationInterfaceQueue(std::bind(&CZMQNotificationInterface::FlushMempoolRemovals, this));
+    vMempoolRemovals.emplace_back(ptx->GetHash(), reason);
 }
 
 void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected, const std::vector<CTransactionRef>& vtxConflicted)
 {
+    LOCK(cs_notifiers);
+    pblockLastConnected = pblock;
+
+    FlushMempoolRemovals();
+
+    // Transactions conflicting with the block are only reported here, the
+    // ones in the block are removed as part of it
+    for (const CTransactionRef& ptx : vtxConflicted)
+        vMempoolRemovals.emplace_back(ptx->GetHash(), MemPoolRemovalReason::CONFLICT);
+    FlushMempoolRemovals();
+
+    TryForEachAndRemoveFailed([&pblock](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlockConnected(*pblock);
+    });
+
     for (const CTransactionRef& ptx : pblock->vtx) {
         // Do a normal notify for each transaction added in the block
         TransactionAddedToMempool(ptx);
@@ -175,6 +229,13 @@ void CZMQNotificationInterface::BlockConnected(const std::shared_ptr<const CBloc
 
 void CZMQNotificationInterface::BlockDisconnected(const std::shared_ptr<const CBlock>& pblock)
 {
+    LOCK(cs_notifiers);
+    FlushMempoolRemovals();
+
+    TryForEachAndRemoveFailed([&pblock](CZMQAbstractNotifier* notifier) {
+        return notifier->NotifyBlockDisconnected(*pblock);
+    });
+
     for (const CTransactionRef& ptx : pblock->vtx) {
         // Do a normal notify for each transaction removed in block disconnection
         TransactionAddedToMempool(ptx);
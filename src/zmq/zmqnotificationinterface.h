@@ -5,10 +5,15 @@
 #ifndef BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
+#include <sync.h>
 #include <validationinterface.h>
+#include <uint256.h>
 #include <string>
 #include <map>
 #include <list>
+#include <memory>
+#include <utility>
+#include <vector>
 
 class CBlockIndex;
 class CZMQAbstractNotifier;
@@ -26,15 +31,31 @@ protected:
 
     // CValidationInterface
     void TransactionAddedToMempool(const CTransactionRef& tx) override;
+    void TransactionRemovedFromMempool(const CTransactionRef& tx, MemPoolRemovalReason reason) override;
     void BlockConnected(const std::shared_ptr<const CBlock>& pblock, const CBlockIndex* pindexConnected, const std::vector<CTransactionRef>& vtxConflicted) override;
     void BlockDisconnected(const std::shared_ptr<const CBlock>& pblock) override;
     void UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload) override;
+    std::string GetSubscriberName() const override { return "zmq"; }
 
 private:
     CZMQNotificationInterface();
 
+    /** Call func for each notifier, shutting down and dropping those it fails for */
+    template <typename Function>
+    void TryForEachAndRemoveFailed(const Function& func);
+    /** Publish the mempool removals collected so far in one message */
+    void FlushMempoolRemovals();
+
+    //! Held while publishing, as flushing the mempool removals can run
+    //! alongside the other notifications
+    CCriticalSection cs_notifiers;
     void *pcontext;
     std::list<CZMQAbstractNotifier*> notifiers;
+    //! The last block connected, passed on with the tip update that follows it
+    std::shared_ptr<const CBlock> pblockLastConnected;
+    //! Mempool removals not published yet, sent together once the ones queued
+    //! with them were received, or before any other notification
+    std::vector<std::pair<uint256, MemPoolRemovalReason>> vMempoolRemovals;
 };
 
 #endif // BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
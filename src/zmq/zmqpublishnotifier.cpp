@@ -5,6 +5,7 @@
 #include <chain.h>
 #include <chainparams.h>
 #include <streams.h>
+#include <txmempool.h>
 #include <zmq/zmqpublishnotifier.h>
 #include <validation.h>
 #include <util.h>
@@ -16,6 +17,9 @@ static const char *MSG_HASHBLOCK = "hashblock";
 static const char *MSG_HASHTX    = "hashtx";
 static const char *MSG_RAWBLOCK  = "rawblock";
 static const char *MSG_RAWTX     = "rawtx";
+static const char *MSG_MEMPOOLREMOVED   = "mempoolremoved";
+static const char *MSG_BLOCKCONNECTED   = "blockconnected";
+static const char *MSG_BLOCKDISCONNECTED = "blockdisconnected";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -146,7 +150,45 @@ bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const void* d
     return true;
 }
 
-bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+// Called by ZMQ, on its I/O thread, once the data of a message was sent
+static void zmq_free_vector(void * /*data*/, void *hint)
+{
+    delete static_cast<std::vector<unsigned char>*>(hint);
+}
+
+bool CZMQAbstractPublishNotifier::SendMessage(const char *command, std::vector<unsigned char>&& data)
+{
+    assert(psocket);
+
+    /* same parts as above, the message owns the data from here on */
+    std::vector<unsigned char>* pdata = new std::vector<unsigned char>(std::move(data));
+    zmq_msg_t msg;
+    if (zmq_msg_init_data(&msg, pdata->data(), pdata->size(), zmq_free_vector, pdata) != 0)
+    {
+        zmqError("Unable to initialize ZMQ msg");
+        delete pdata;
+        return false;
+    }
+
+    unsigned char msgseq[sizeof(uint32_t)];
+    WriteLE32(&msgseq[0], nSequence);
+    if (zmq_send(psocket, command, strlen(command), ZMQ_SNDMORE) == -1 ||
+        zmq_msg_send(&msg, psocket, ZMQ_SNDMORE) == -1 ||
+        zmq_send(psocket, msgseq, sizeof(msgseq), 0) == -1)
+    {
+        zmqError("Unable to send ZMQ msg");
+        zmq_msg_close(&msg);
+        return false;
+    }
+    zmq_msg_close(&msg);
+
+    /* increment memory only sequence number after sending */
+    nSequence++;
+
+    return true;
+}
+
+bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& /*pblock*/)
 {
     uint256 hash = pindex->GetBlockHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish hashblock %s\n", hash.GetHex());
@@ -166,32 +208,96 @@ bool CZMQPublishHashTransactionNotifier::NotifyTransaction(const CTransaction &t
     return SendMessage(MSG_HASHTX, data, 32);
 }
 
-bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
+bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex, const std::shared_ptr<const CBlock>& pblock)
 {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s\n", pindex->GetBlockHash().GetHex());
 
-    const Consensus::Params& consensusParams = Params().GetConsensus();
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    {
-        LOCK(cs_main);
-        CBlock block;
-        if(!ReadBlockFromDisk(block, pindex, consensusParams))
+    std::vector<unsigned char> data;
+    if (pblock) {
+        // The block that was just connected, already checked and in memory
+        data.reserve(::GetSerializeSize(*pblock, SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags()));
+        CVectorWriter(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), data, 0, *pblock);
+    } else {
+        // Otherwise take it from block storage, holding cs_main only to find it
+        CDiskBlockPos pos;
         {
-            zmqError("Can't read block from disk");
-            return false;
+            LOCK(cs_main);
+            if (!(pindex->nStatus & BLOCK_HAVE_DATA))
+            {
+                zmqError("Block not available");
+                return false;
+            }
+            pos = pindex->GetBlockPos();
+        }
+        if (RPCSerializationFlags() == 0) {
+            // Stored as it is sent, so the bytes are published as they are
+            if (!ReadRawBlockFromDisk(data, pos, Params().MessageStart()))
+            {
+                zmqError("Can't read block from disk");
+                return false;
+            }
+        } else {
+            CBlock block;
+            if (!ReadBlockFromDisk(block, pos, Params().GetConsensus()))
+            {
+                zmqError("Can't read block from disk");
+                return false;
+            }
+            CVectorWriter(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), data, 0, block);
         }
-
-        ss << block;
     }
 
-    return SendMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    return SendMessage(MSG_RAWBLOCK, std::move(data));
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(const CTransaction &transaction)
 {
     uint256 hash = transaction.GetHash();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtx %s\n", hash.GetHex());
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ss << transaction;
-    return SendMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    std::vector<unsigned char> data;
+    data.reserve(::GetSerializeSize(transaction, SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags()));
+    CVectorWriter(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags(), data, 0, transaction);
+    return SendMessage(MSG_RAWTX, std::move(data));
+}
+
+// Append a hash in the byte order it is displayed in, as hashblock and hashtx send it
+static void AppendReversedHash(std::vector<unsigned char>& data, const uint256& hash)
+{
+    for (unsigned int i = 0; i < 32; i++)
+        data.push_back(hash.begin()[31 - i]);
+}
+
+// The block hash followed by the txids of all of its transactions, in block order
+static std::vector<unsigned char> SerializeBlockTxids(const CBlock &block)
+{
+    std::vector<unsigned char> data;
+    data.reserve(32 * (1 + block.vtx.size()));
+    AppendReversedHash(data, block.GetHash());
+    for (const CTransactionRef& ptx : block.vtx)
+        AppendReversedHash(data, ptx->GetHash());
+    return data;
+}
+
+bool CZMQPublishMempoolRemovedNotifier::NotifyMempoolRemovals(const std::vector<std::pair<uint256, MemPoolRemovalReason>>& vRemoved)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish mempoolremoved of %u transactions\n", vRemoved.size());
+    std::vector<unsigned char> data;
+    data.reserve(33 * vRemoved.size());
+    for (const auto& removed : vRemoved) {
+        AppendReversedHash(data, removed.first);
+        data.push_back((unsigned char)removed.second);
+    }
+    return SendMessage(MSG_MEMPOOLREMOVED, std::move(data));
+}
+
+bool CZMQPublishBlockConnectedNotifier::NotifyBlockConnected(const CBlock &block)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish blockconnected %s\n", block.GetHash().GetHex());
+    return SendMessage(MSG_BLOCKCONNECTED, SerializeBlockTxids(block));
+}
+
+bool CZMQPublishBlockDisconnectedNotifier::NotifyBlockDisconnected(const CBlock &block)
+{
+    LogPrint(BCLog::ZMQ, "zmq: Publish blockdisconnected %s\n", block.GetHash().GetHex());
+    return SendMessage(MSG_BLOCKDISCONNECTED, SerializeBlockTxids(block));
 }
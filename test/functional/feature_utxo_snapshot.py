@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+# Copyright (c) 2018 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test dumptxoutset and -loadtxoutset.
+
+- Generate blocks and dump the UTXO set to a snapshot file.
+- Check that dumptxoutset refuses to overwrite an existing file.
+- Generate more blocks, then restart with -reindex-chainstate and -loadtxoutset.
+  Verify that the node resyncs on top of the snapshot to the same UTXO set.
+"""
+
+import os
+
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error, wait_until
+
+class UTXOSnapshotTest(BitcoinTestFramework):
+
+    def set_test_params(self):
+        self.setup_clean_chain = True
+        self.num_nodes = 1
+
+    def run_test(self):
+        node = self.nodes[0]
+        node.generate(5)
+
+        res = node.dumptxoutset("utxo.dat")
+        assert_equal(res['base_hash'], node.getbestblockhash())
+        assert_equal(res['base_height'], 5)
+        assert_equal(res['coins_written'], node.gettxoutsetinfo()['txouts'])
+        assert_equal(res['path'], os.path.join(node.datadir, "regtest", "utxo.dat"))
+        assert os.path.isfile(res['path'])
+        assert_raises_rpc_error(-8, "already exists", node.dumptxoutset, "utxo.dat")
+
+        node.generate(3)
+        blockcount = node.getblockcount()
+        info = node.gettxoutsetinfo()
+
+        self.log.info("Restart from the snapshot")
+        self.stop_nodes()
+        self.start_nodes([["-reindex-chainstate", "-loadtxoutset=utxo.dat"]])
+        wait_until(lambda: self.nodes[0].getblockcount() == blockcount)
+        assert_equal(self.nodes[0].gettxoutsetinfo()['hash_serialized_2'], info['hash_serialized_2'])
+
+if __name__ == '__main__':
+    UTXOSnapshotTest().main()
@@ -265,6 +265,38 @@ class RESTTest (BitcoinTestFramework):
         json_obj = json.loads(response_header_json_str)
         assert_equal(len(json_obj), 5) #now we should have 5 header objects
 
+        #####################
+        # /rest/blockrange/ #
+        #####################
+
+        bb_height = rpc_block_json['height']
+        range_hashes = [self.nodes[0].getblockhash(bb_height + i) for i in range(5)]
+
+        # binary blocks are concatenated, as /rest/block/ returns them one by one
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/'+str(bb_height)+'/5'+self.FORMAT_SEPARATOR+"bin", True)
+        assert_equal(response.status, 200)
+        range_bin = response.read()
+        single_bin = b''.join(http_get_call(url.hostname, url.port, '/rest/block/'+h+self.FORMAT_SEPARATOR+"bin", True).read() for h in range_hashes)
+        assert_equal(range_bin, single_bin)
+
+        # hex blocks are one per line
+        range_hex = http_get_call(url.hostname, url.port, '/rest/blockrange/'+str(bb_height)+'/5'+self.FORMAT_SEPARATOR+"hex")
+        assert_equal(range_hex.split(), [self.nodes[0].getblock(h, 0) for h in range_hashes])
+
+        # json blocks come without transaction details
+        range_json = json.loads(http_get_call(url.hostname, url.port, '/rest/blockrange/'+str(bb_height)+'/5'+self.FORMAT_SEPARATOR+"json"))
+        assert_equal([b['hash'] for b in range_json], range_hashes)
+        assert_equal(range_json[0]['tx'], self.nodes[0].getblock(range_hashes[0])['tx'])
+
+        # the range ends at the tip
+        range_json = json.loads(http_get_call(url.hostname, url.port, '/rest/blockrange/'+str(bb_height + 4)+'/100'+self.FORMAT_SEPARATOR+"json"))
+        assert_equal([b['hash'] for b in range_json], [range_hashes[4]])
+
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/'+str(bb_height + 5)+'/1'+self.FORMAT_SEPARATOR+"bin", True)
+        assert_equal(response.status, 404)
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/'+str(bb_height)+'/101'+self.FORMAT_SEPARATOR+"bin", True)
+        assert_equal(response.status, 400)
+
         # do tx test
         tx_hash = block_json_obj['tx'][0]['txid']
         json_string = http_get_call(url.hostname, url.port, '/rest/tx/'+tx_hash+self.FORMAT_SEPARATOR+"json")
@@ -28,9 +28,10 @@ Test is as follows:
   - Restart node0 with -persistmempool. Verify that it has 5
     transactions in its mempool. This tests that -persistmempool=0
     does not overwrite a previously valid mempool stored on disk.
+    Since node0 wrote the file itself, it skips their script checks.
   - Remove node0 mempool.dat and verify savemempool RPC recreates it
     and verify that node1 can load it and has 5 transaction in its
-    mempool.
+    mempool. node1 did not write the file, so it checks all scripts.
   - Verify that savemempool throws when the RPC is called if
     node1 can't write to disk.
 
@@ -41,11 +42,17 @@ import time
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import *
 
+TRUSTED_LOAD_LOG = "Mempool file was written by this node"
+
 class MempoolPersistTest(BitcoinTestFramework):
     def set_test_params(self):
         self.num_nodes = 3
         self.extra_args = [[], ["-persistmempool=0"], []]
 
+    def debug_log_contains(self, node_index, text):
+        with open(os.path.join(self.options.tmpdir, 'node%d' % node_index, 'regtest', 'debug.log'), encoding='utf-8') as f:
+            return text in f.read()
+
     def run_test(self):
         chain_height = self.nodes[0].getblockcount()
         assert_equal(chain_height, 200)
@@ -90,6 +97,7 @@ class MempoolPersistTest(BitcoinTestFramework):
         self.stop_nodes()
         self.start_node(0)
         wait_until(lambda: len(self.nodes[0].getrawmempool()) == 5)
+        assert self.debug_log_contains(0, TRUSTED_LOAD_LOG)
 
         mempooldat0 = os.path.join(self.options.tmpdir, 'node0', 'regtest', 'mempool.dat')
         mempooldat1 = os.path.join(self.options.tmpdir, 'node1', 'regtest', 'mempool.dat')
@@ -103,6 +111,7 @@ class MempoolPersistTest(BitcoinTestFramework):
         self.stop_nodes()
         self.start_node(1, extra_args=[])
         wait_until(lambda: len(self.nodes[1].getrawmempool()) == 5)
+        assert not self.debug_log_contains(1, TRUSTED_LOAD_LOG)
 
         self.log.debug("Prevent theholyrogerd from writing mempool.dat to disk. Verify that `savemempool` fails")
         # to test the exception we are setting bad permissions on a tmp file called mempool.dat.new
@@ -170,6 +170,30 @@ class BlockchainTest(BitcoinTestFramework):
         assert_equal(res['bestblock'], res3['bestblock'])
         assert_equal(res['hash_serialized_2'], res3['hash_serialized_2'])
 
+        self.log.info("Test gettxoutsetinfo() with statistics maintained block by block")
+        self.restart_node(0, self.extra_args[0] + ['-utxostats'])
+        node = self.nodes[0]
+        res4 = node.gettxoutsetinfo()
+        for key in ['total_amount', 'height', 'txouts', 'bogosize', 'bestblock']:
+            assert_equal(res[key], res4[key])
+        assert 'hash_serialized_2' not in res4
+        assert_equal(len(res4['muhash']), 64)
+
+        node.invalidateblock(b1hash)
+        res5 = node.gettxoutsetinfo()
+        assert_equal(res5['txouts'], 0)
+        assert_equal(res5['total_amount'], Decimal('0'))
+        assert_equal(res5['bestblock'], node.getblockhash(0))
+        node.reconsiderblock(b1hash)
+        res6 = node.gettxoutsetinfo()
+        for key in ['total_amount', 'height', 'txouts', 'bogosize', 'bestblock', 'muhash']:
+            assert_equal(res4[key], res6[key])
+
+        # The statistics are stored with the chainstate and reloaded as they were.
+        self.restart_node(0, self.extra_args[0] + ['-utxostats'])
+        assert_equal(self.nodes[0].gettxoutsetinfo()['muhash'], res4['muhash'])
+        self.restart_node(0, self.extra_args[0])
+
     def _test_getblockheader(self):
         node = self.nodes[0]
 